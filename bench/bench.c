@@ -0,0 +1,289 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Benchmark harness for the netlink reply handlers
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "../smctools_common.h"
+#include "../libnetlink.h"
+#include "bench.h"
+
+char *myname = "bench";
+
+struct bench_res {
+	int		valid;
+	unsigned long	records;
+	unsigned long	allocs;
+	double		ns;
+	size_t		input_bytes;
+	long		setup_rss_kb;	/* peak RSS before the timed part */
+};
+
+static struct bench_res res;
+static unsigned long alloc_cnt;
+static struct timespec t_start;
+
+/* Count the allocations of the timed part */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size)
+{
+	alloc_cnt++;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	alloc_cnt++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	alloc_cnt++;
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+	__libc_free(ptr);
+}
+
+static int bench_load(struct bench_msgs *msgs, const struct nl_gen_cfg *cfg,
+		      int kind, int cmd)
+{
+	struct nl_rec_hdr *hdr;
+	struct nlmsghdr *nlh;
+	size_t off, size;
+	unsigned long max;
+	FILE *fp;
+
+	memset(msgs, 0, sizeof(*msgs));
+	fp = open_memstream(&msgs->buf, &size);
+	if (!fp)
+		return -1;
+	if (nl_gen_write(fp, cfg) < 0) {
+		fclose(fp);
+		goto err;
+	}
+	if (fclose(fp))
+		goto err;
+	msgs->bytes = size;
+
+	max = size / (sizeof(*hdr) + NLMSG_HDRLEN);
+	msgs->nlh = malloc(max * sizeof(*msgs->nlh));
+	if (!msgs->nlh)
+		goto err;
+	for (off = 0; off + sizeof(*hdr) <= size; off += sizeof(*hdr) + hdr->len) {
+		hdr = (struct nl_rec_hdr *)(msgs->buf + off);
+		nlh = (struct nlmsghdr *)(hdr + 1);
+		if (hdr->kind != (__u32)kind || hdr->cmd != (__u32)cmd ||
+		    nlh->nlmsg_type == NLMSG_DONE)
+			continue;
+		msgs->nlh[msgs->cnt++] = nlh;
+	}
+	if (!msgs->cnt) {
+		fprintf(stderr, "Error: No records of kind %d, command %d\n",
+			kind, cmd);
+		goto err;
+	}
+	res.input_bytes = size;
+
+	return 0;
+err:
+	bench_free(msgs);
+	return -1;
+}
+
+int bench_load_genl(struct bench_msgs *msgs, const struct nl_gen_cfg *cfg,
+		    int cmd)
+{
+	return bench_load(msgs, cfg, NL_REC_GENL, cmd);
+}
+
+int bench_load_diag(struct bench_msgs *msgs, const struct nl_gen_cfg *cfg,
+		    int ext)
+{
+	return bench_load(msgs, cfg, NL_REC_DIAG, ext);
+}
+
+void bench_free(struct bench_msgs *msgs)
+{
+	free(msgs->nlh);
+	free(msgs->buf);
+	memset(msgs, 0, sizeof(*msgs));
+}
+
+unsigned long bench_reps(unsigned long n)
+{
+	return n >= BENCH_MIN_RECORDS ? 1 : (BENCH_MIN_RECORDS + n - 1) / n;
+}
+
+void bench_start(void)
+{
+	struct rusage ru;
+
+	fflush(stdout);
+	if (!getrusage(RUSAGE_SELF, &ru))
+		res.setup_rss_kb = ru.ru_maxrss;
+	alloc_cnt = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t_start);
+}
+
+void bench_stop(unsigned long records)
+{
+	struct timespec t_end;
+
+	fflush(stdout);
+	clock_gettime(CLOCK_MONOTONIC, &t_end);
+	res.allocs = alloc_cnt;
+	res.ns = (t_end.tv_sec - t_start.tv_sec) * 1e9 +
+		 (t_end.tv_nsec - t_start.tv_nsec);
+	res.records = records;
+	res.valid = 1;
+}
+
+/* Run one case in a child, return its result and peak RSS */
+static int bench_fork(const struct bench_case *bc, unsigned long n,
+		      struct bench_res *r, long *peak_rss_kb)
+{
+	struct rusage ru;
+	int fds[2], status, fd;
+	pid_t pid;
+	ssize_t len;
+
+	if (pipe(fds))
+		return -1;
+	pid = fork();
+	if (pid < 0)
+		return -1;
+	if (!pid) {
+		close(fds[0]);
+		fd = open("/dev/null", O_WRONLY);
+		if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0)
+			_exit(1);
+		if (bc->run(n) || !res.valid)
+			_exit(1);
+		if (write(fds[1], &res, sizeof(res)) != sizeof(res))
+			_exit(1);
+		_exit(0);
+	}
+	close(fds[1]);
+	len = read(fds[0], r, sizeof(*r));
+	close(fds[0]);
+	if (wait4(pid, &status, 0, &ru) < 0)
+		return -1;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) || len != sizeof(*r))
+		return -1;
+	*peak_rss_kb = ru.ru_maxrss;
+
+	return 0;
+}
+
+static void bench_usage(const char *name, const char *sizes)
+{
+	fprintf(stderr,
+"Usage: bench_%s [ -l LABEL ] [ -s SIZES ] [ CASE... ]\n"
+"\t-l, --label LABEL  value of the \"src\" field, e.g. a revision\n"
+"\t-s, --sizes SIZES  comma separated numbers of entries\n"
+"\t                   (default %s)\n", name, sizes);
+	exit(-1);
+}
+
+int bench_main(int argc, char **argv, const char *name, const char *sizes,
+	       const struct bench_case *cases, int ncases)
+{
+	static const struct option long_opts[] = {
+		{ "label", 1, 0, 'l' },
+		{ "sizes", 1, 0, 's' },
+		{ "help", 0, 0, 'h' },
+		{ NULL, 0, NULL, 0}
+	};
+	const char *dflt_sizes = sizes;
+	char *label = "HEAD", *tok, *end, *list;
+	struct bench_res r;
+	unsigned long n;
+	long peak_rss;
+	int rc = 0, ch, i, j;
+
+	while ((ch = getopt_long(argc, argv, "hl:s:", long_opts, NULL)) != EOF) {
+		switch (ch) {
+		case 'l':
+			label = optarg;
+			break;
+		case 's':
+			sizes = optarg;
+			break;
+		default:
+			bench_usage(name, dflt_sizes);
+		}
+	}
+	for (j = optind; j < argc; j++) {
+		for (i = 0; i < ncases; i++) {
+			if (!strcmp(argv[j], cases[i].name))
+				break;
+		}
+		if (i == ncases) {
+			fprintf(stderr, "Error: Unknown case \"%s\"\n", argv[j]);
+			bench_usage(name, dflt_sizes);
+		}
+	}
+
+	for (i = 0; i < ncases; i++) {
+		if (optind < argc) {
+			for (j = optind; j < argc; j++) {
+				if (!strcmp(argv[j], cases[i].name))
+					break;
+			}
+			if (j == argc)
+				continue;
+		}
+		list = strdup(sizes);
+		if (!list)
+			return EXIT_FAILURE;
+		for (tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+			errno = 0;
+			n = strtoul(tok, &end, 0);
+			if (errno || end == tok || *end || !n)
+				bench_usage(name, dflt_sizes);
+			if (bench_fork(&cases[i], n, &r, &peak_rss)) {
+				fprintf(stderr, "Error: %s/%s failed for %lu entries\n",
+					name, cases[i].name, n);
+				rc = EXIT_FAILURE;
+				continue;
+			}
+			printf("{\"bench\":\"%s\",\"case\":\"%s\",\"src\":\"%s\","
+			       "\"entries\":%lu,\"records\":%lu,"
+			       "\"ns_per_record\":%.1f,\"allocs_per_record\":%.3f,"
+			       "\"input_bytes\":%zu,\"setup_rss_kb\":%ld,"
+			       "\"peak_rss_kb\":%ld}\n",
+			       name, cases[i].name, label, n, r.records,
+			       r.ns / r.records, (double)r.allocs / r.records,
+			       r.input_bytes, r.setup_rss_kb, peak_rss);
+			fflush(stdout);
+		}
+		free(list);
+	}
+
+	return rc;
+}
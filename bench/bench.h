@@ -0,0 +1,65 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Benchmark harness for the netlink reply handlers
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stddef.h>
+#include <linux/netlink.h>
+
+#include "../tests/nl_gen.h"
+
+/* Each case runs in a child process per size, with stdout on /dev/null. It
+ * builds its input with bench_load(), then times the handler between
+ * bench_start() and bench_stop(). Small sizes are repeated, so that every
+ * run handles at least BENCH_MIN_RECORDS records.
+ */
+#define BENCH_MIN_RECORDS	200000
+
+struct bench_case {
+	const char	*name;
+	int		(*run)(unsigned long n);	/* 0 or -1 */
+};
+
+/* netlink messages of one kind and command of a generated dump */
+struct bench_msgs {
+	struct nlmsghdr	**nlh;
+	unsigned long	cnt;
+	size_t		bytes;		/* size of the whole dump */
+	char		*buf;
+};
+
+/* Generate the dumps of cfg and collect the replies to generic netlink
+ * command cmd, or to the sock_diag dump with extensions ext, without the
+ * NLMSG_DONE
+ */
+int bench_load_genl(struct bench_msgs *msgs, const struct nl_gen_cfg *cfg,
+		    int cmd);
+int bench_load_diag(struct bench_msgs *msgs, const struct nl_gen_cfg *cfg,
+		    int ext);
+void bench_free(struct bench_msgs *msgs);
+
+/* repetitions of a run over n records */
+unsigned long bench_reps(unsigned long n);
+void bench_start(void);
+void bench_stop(unsigned long records);
+
+#define BENCH_SIZES		"1000,10000,100000,1000000"
+
+/* Run the cases named on the command line, or all of them, and print one
+ * line of JSON per case and size. sizes is the default list of sizes.
+ */
+int bench_main(int argc, char **argv, const char *name, const char *sizes,
+	       const struct bench_case *cases, int ncases);
+
+#endif /* BENCH_H_ */
@@ -0,0 +1,107 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Benchmark of gen_nl_batch_run() against the same dumps one at a time, on
+ * the running kernel
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "smctools_common.h"
+#include "libnetlink.h"
+#include "bench.h"
+
+/* the dumps of "smcr topology" and "smcr stats" */
+static const int cmds[] = {
+	SMC_NETLINK_GET_SYS_INFO,
+	SMC_NETLINK_GET_DEV_SMCR,
+	SMC_NETLINK_GET_DEV_SMCD,
+	SMC_NETLINK_GET_LGR_SMCR,
+	SMC_NETLINK_GET_LINK_SMCR,
+	SMC_NETLINK_GET_LGR_SMCD,
+	SMC_NETLINK_GET_STATS,
+	SMC_NETLINK_GET_FBACK_STATS,
+};
+#define NCMDS	((int)(sizeof(cmds) / sizeof(cmds[0])))
+
+static unsigned long replies;
+
+static int handle_reply(struct nl_msg *msg, void *arg)
+{
+	replies++;
+	return NL_OK;
+}
+
+/* a record is one round of all dumps */
+static int run_batch(unsigned long n)
+{
+	struct gen_nl_req reqs[NCMDS];
+	unsigned long r;
+	int i;
+
+	if (gen_nl_open())
+		return -1;
+	bench_start();
+	for (r = 0; r < n; r++) {
+		memset(reqs, 0, sizeof(reqs));
+		for (i = 0; i < NCMDS; i++) {
+			reqs[i].cmd = cmds[i];
+			reqs[i].flags = NLM_F_DUMP;
+			reqs[i].cb_handler = handle_reply;
+		}
+		if (gen_nl_batch_run(reqs, NCMDS))
+			return -1;
+	}
+	bench_stop(n);
+	gen_nl_close();
+
+	return 0;
+}
+
+static int run_sequential(unsigned long n)
+{
+	unsigned long r;
+	int i;
+
+	if (gen_nl_open())
+		return -1;
+	bench_start();
+	for (r = 0; r < n; r++) {
+		for (i = 0; i < NCMDS; i++) {
+			if (gen_nl_handle_dump(cmds[i], handle_reply, NULL))
+				return -1;
+		}
+	}
+	bench_stop(n);
+	gen_nl_close();
+
+	return 0;
+}
+
+static const struct bench_case cases[] = {
+	{ "batch", run_batch },
+	{ "sequential", run_sequential },
+};
+
+int main(int argc, char **argv)
+{
+	/* time the kernel, not a recording */
+	unsetenv("SMC_NL_REPLAY");
+	unsetenv("SMC_NL_RECORD");
+	if (gen_nl_open()) {
+		printf("{\"bench\":\"batch\",\"skipped\":\"SMC module not loaded\"}\n");
+		return EXIT_SUCCESS;
+	}
+	gen_nl_close();
+
+	return bench_main(argc, argv, "batch", "100,1000,10000", cases,
+			  sizeof(cases) / sizeof(cases[0]));
+}
@@ -0,0 +1,47 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Benchmark of handle_inventory_reply()
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include "dev.c"
+#include "bench_nl.h"
+
+static void reset_smcr(void)
+{
+	inventory_clear(SMC_INV_SMCR);
+}
+
+/* smcr device: n SMC-R devices with 2 ports, each naming its net device */
+static int run_dev(unsigned long n)
+{
+	struct bench_msgs msgs;
+	struct nl_gen_cfg cfg;
+
+	nl_gen_defaults(&cfg);
+	cfg.what = NL_GEN_DEVR;
+	cfg.devs = n;
+	cfg.lgrs = 0;
+	if (bench_load_genl(&msgs, &cfg, SMC_NETLINK_GET_DEV_SMCR))
+		return -1;
+
+	return bench_nl_run(&msgs, bench_reps(msgs.cnt), handle_inventory_reply,
+			    reset_smcr);
+}
+
+static const struct bench_case cases[] = {
+	{ "dev", run_dev },
+};
+
+int main(int argc, char **argv)
+{
+	return bench_main(argc, argv, "dev", BENCH_SIZES, cases,
+			  sizeof(cases) / sizeof(cases[0]));
+}
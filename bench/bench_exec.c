@@ -0,0 +1,107 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Exec time of a command: runs it repeatedly with stdout and stderr on
+ * /dev/null and prints the median and the minimum wall time of a run, as
+ * JSON fields for bench/run_bench
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define BENCH_EXEC_RUNS		200
+
+static int cmp_ns(const void *a, const void *b)
+{
+	long long x = *(const long long *)a, y = *(const long long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static long long run_once(char **argv)
+{
+	struct timespec t_start, t_end;
+	int status, fd;
+	pid_t pid;
+
+	clock_gettime(CLOCK_MONOTONIC, &t_start);
+	pid = fork();
+	if (pid < 0)
+		return -1;
+	if (!pid) {
+		fd = open("/dev/null", O_WRONLY);
+		if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0 ||
+		    dup2(fd, STDERR_FILENO) < 0)
+			_exit(127);
+		execv(argv[0], argv);
+		_exit(127);
+	}
+	if (waitpid(pid, &status, 0) < 0)
+		return -1;
+	clock_gettime(CLOCK_MONOTONIC, &t_end);
+	/* the live commands fail without the SMC module, that is fine */
+	if (!WIFEXITED(status) || WEXITSTATUS(status) == 127)
+		return -1;
+
+	return (t_end.tv_sec - t_start.tv_sec) * 1000000000LL +
+	       (t_end.tv_nsec - t_start.tv_nsec);
+}
+
+int main(int argc, char **argv)
+{
+	long runs = BENCH_EXEC_RUNS, i;
+	long long *ns;
+	char *end;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "+n:")) != EOF) {
+		switch (ch) {
+		case 'n':
+			errno = 0;
+			runs = strtol(optarg, &end, 0);
+			if (errno || *end || runs <= 0)
+				goto usage;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind >= argc)
+		goto usage;
+
+	ns = malloc(runs * sizeof(*ns));
+	if (!ns)
+		return EXIT_FAILURE;
+	/* warm the page cache */
+	if (run_once(&argv[optind]) < 0) {
+		fprintf(stderr, "Error: Cannot run %s\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+	for (i = 0; i < runs; i++) {
+		ns[i] = run_once(&argv[optind]);
+		if (ns[i] < 0) {
+			fprintf(stderr, "Error: Cannot run %s\n", argv[optind]);
+			return EXIT_FAILURE;
+		}
+	}
+	qsort(ns, runs, sizeof(*ns), cmp_ns);
+	printf("\"runs\":%ld,\"ns_median\":%lld,\"ns_min\":%lld\n", runs,
+	       ns[runs / 2], ns[0]);
+	free(ns);
+
+	return EXIT_SUCCESS;
+usage:
+	fprintf(stderr, "Usage: bench_exec [ -n RUNS ] PATH [ ARG... ]\n");
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,103 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Benchmark of handle_gen_lgr_reply()
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include "linkgroup.c"
+#include "bench_nl.h"
+
+/* smcr linkgroup [-d] */
+static int run_lgr(unsigned long n, int detail)
+{
+	struct bench_msgs msgs;
+	struct nl_gen_cfg cfg;
+
+	nl_gen_defaults(&cfg);
+	cfg.what = NL_GEN_LGR;
+	cfg.lgrs = n;
+	if (bench_load_genl(&msgs, &cfg, SMC_NETLINK_GET_LGR_SMCR))
+		return -1;
+	d_level = detail;
+
+	return bench_nl_run(&msgs, bench_reps(msgs.cnt), handle_gen_lgr_reply,
+			    NULL);
+}
+
+static int run_lgr_plain(unsigned long n)
+{
+	return run_lgr(n, 0);
+}
+
+static int run_lgr_details(unsigned long n)
+{
+	return run_lgr(n, SMC_DETAIL_LEVEL_V);
+}
+
+/* smcr linkgroup link-show: n link records, in link groups of 2 links, each
+ * naming its net device
+ */
+static int run_link(unsigned long n)
+{
+	struct bench_msgs msgs;
+	struct nl_gen_cfg cfg;
+
+	nl_gen_defaults(&cfg);
+	cfg.what = NL_GEN_LINK;
+	cfg.lgrs = (n + 1) / 2;
+	cfg.links = 2;
+	if (bench_load_genl(&msgs, &cfg, SMC_NETLINK_GET_LINK_SMCR))
+		return -1;
+	show_links = 1;
+
+	return bench_nl_run(&msgs, bench_reps(msgs.cnt), handle_gen_lgr_reply,
+			    NULL);
+}
+
+/* smcr linkgroup [link-show] 00000100: one link group passes the filter */
+static void filter_lgid(void)
+{
+	unmasked_trgt_lgid = 0x100;
+	target_lgid = unmasked_trgt_lgid & SMC_MASK_LINK_ID;
+}
+
+static int run_lgr_filtered(unsigned long n)
+{
+	filter_lgid();
+	return run_lgr(n, 0);
+}
+
+static int run_link_filtered(unsigned long n)
+{
+	filter_lgid();
+	return run_link(n);
+}
+
+/* smcr linkgroup link-show ibdev mlx5_0: half of the links pass */
+static int run_link_ibdev(unsigned long n)
+{
+	snprintf(target_ibdev, sizeof(target_ibdev), "mlx5_0");
+	return run_link(n);
+}
+
+static const struct bench_case cases[] = {
+	{ "lgr", run_lgr_plain },
+	{ "lgr-details", run_lgr_details },
+	{ "lgr-filtered", run_lgr_filtered },
+	{ "link", run_link },
+	{ "link-filtered", run_link_filtered },
+	{ "link-ibdev", run_link_ibdev },
+};
+
+int main(int argc, char **argv)
+{
+	return bench_main(argc, argv, "lgr", BENCH_SIZES, cases,
+			  sizeof(cases) / sizeof(cases[0]));
+}
@@ -0,0 +1,80 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * struct nl_msg wrappers for the benchmarks of the generic netlink handlers,
+ * included after the handlers' source file
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#ifndef BENCH_NL_H_
+#define BENCH_NL_H_
+
+#include "bench.h"
+
+/* Messages as the handlers receive them: raw builds point into the receive
+ * buffer, libnl builds get a copy
+ */
+static struct nl_msg **bench_nl_msgs(struct bench_msgs *msgs)
+{
+	struct nl_msg **msg;
+	unsigned long i;
+#ifdef SMC_NL_RAW
+	struct nl_msg *wrap;
+
+	msg = malloc(msgs->cnt * sizeof(*msg));
+	wrap = calloc(msgs->cnt, sizeof(*wrap));
+	if (!msg || !wrap) {
+		free(msg);
+		free(wrap);
+		return NULL;
+	}
+	for (i = 0; i < msgs->cnt; i++) {
+		wrap[i].nm_nlh = msgs->nlh[i];
+		msg[i] = &wrap[i];
+	}
+#else
+	msg = calloc(msgs->cnt, sizeof(*msg));
+	if (!msg)
+		return NULL;
+	for (i = 0; i < msgs->cnt; i++) {
+		msg[i] = nlmsg_convert(msgs->nlh[i]);
+		if (!msg[i])
+			return NULL;
+	}
+#endif
+
+	return msg;
+}
+
+/* Time cb_handler on every message, reps times */
+static int bench_nl_run(struct bench_msgs *msgs, unsigned long reps,
+			int (*cb_handler)(struct nl_msg *msg, void *arg),
+			void (*reset)(void))
+{
+	struct nl_msg **msg;
+	unsigned long i, r;
+
+	msg = bench_nl_msgs(msgs);
+	if (!msg)
+		return -1;
+	bench_start();
+	for (r = 0; r < reps; r++) {
+		if (reset)
+			reset();
+		for (i = 0; i < msgs->cnt; i++) {
+			if (cb_handler(msg[i], NULL) != NL_OK)
+				return -1;
+		}
+	}
+	bench_stop(reps * msgs->cnt);
+
+	return 0;
+}
+
+#endif /* BENCH_NL_H_ */
@@ -0,0 +1,128 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Benchmark of show_one_smc_sock() and parse_rtattr()
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#define main smcss_main
+#include "smcss.c"
+#undef main
+#include "bench.h"
+
+#define EXT_ALL	((1 << (SMC_DIAG_CONNINFO - 1)) | \
+		 (1 << (SMC_DIAG_LGRINFO - 1)) | \
+		 (1 << (SMC_DIAG_DMBINFO - 1)))
+
+static int load_socks(struct bench_msgs *msgs, unsigned long n, int ext)
+{
+	struct nl_gen_cfg cfg;
+
+	nl_gen_defaults(&cfg);
+	cfg.what = NL_GEN_SOCK;
+	cfg.socks = n;
+	cfg.sock_ext = ext;
+
+	return bench_load_diag(msgs, &cfg, ext);
+}
+
+static int run_socks(unsigned long n, int ext)
+{
+	struct bench_msgs msgs;
+	unsigned long i, r, reps;
+
+	if (load_socks(&msgs, n, ext))
+		return -1;
+	reps = bench_reps(msgs.cnt);
+	bench_start();
+	for (r = 0; r < reps; r++) {
+		for (i = 0; i < msgs.cnt; i++)
+			show_one_smc_sock(msgs.nlh[i]);
+	}
+	bench_stop(reps * msgs.cnt);
+
+	return 0;
+}
+
+/* smcss */
+static int run_smcss(unsigned long n)
+{
+	return run_socks(n, 0);
+}
+
+/* smcss -a */
+static int run_smcss_all(unsigned long n)
+{
+	all = 1;
+	return run_socks(n, 0);
+}
+
+/* smcss -l, 1 in 10 sockets is listening */
+static int run_smcss_listening(unsigned long n)
+{
+	listening = 1;
+	return run_socks(n, 0);
+}
+
+/* smcss -d */
+static int run_smcss_details(unsigned long n)
+{
+	show_debug = 1;
+	return run_socks(n, 1 << (SMC_DIAG_CONNINFO - 1));
+}
+
+/* smcss -R, 3 in 5 sockets are SMC-R */
+static int run_smcss_smcr(unsigned long n)
+{
+	show_smcr = 1;
+	return run_socks(n, 1 << (SMC_DIAG_LGRINFO - 1));
+}
+
+/* the attributes of sockets with all extensions */
+static int run_parse_rtattr(unsigned long n)
+{
+	struct rtattr *tb[SMC_DIAG_MAX + 1];
+	struct smc_diag_msg *r;
+	struct bench_msgs msgs;
+	unsigned long i, rep, reps;
+	unsigned long found = 0;
+
+	if (load_socks(&msgs, n, EXT_ALL))
+		return -1;
+	reps = bench_reps(msgs.cnt);
+	bench_start();
+	for (rep = 0; rep < reps; rep++) {
+		for (i = 0; i < msgs.cnt; i++) {
+			r = NLMSG_DATA(msgs.nlh[i]);
+			parse_rtattr(tb, SMC_DIAG_MAX, (struct rtattr *)(r + 1),
+				     msgs.nlh[i]->nlmsg_len -
+				     NLMSG_LENGTH(sizeof(*r)));
+			found += !!tb[SMC_DIAG_CONNINFO];
+		}
+	}
+	bench_stop(reps * msgs.cnt);
+	printf("%lu\n", found);	/* keep the loop */
+
+	return 0;
+}
+
+static const struct bench_case cases[] = {
+	{ "parse_rtattr", run_parse_rtattr },
+	{ "smcss", run_smcss },
+	{ "smcss-all", run_smcss_all },
+	{ "smcss-listening", run_smcss_listening },
+	{ "smcss-details", run_smcss_details },
+	{ "smcss-smcr", run_smcss_smcr },
+};
+
+int main(int argc, char **argv)
+{
+	return bench_main(argc, argv, "smcss", BENCH_SIZES, cases,
+			  sizeof(cases) / sizeof(cases[0]));
+}
@@ -0,0 +1,92 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Benchmark of socket() and close(), run with and without
+ * LD_PRELOAD=libsmc-preload.so for the overhead of its wrappers
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "bench.h"
+
+/* a record is one socket() and close() */
+static int run_socket(unsigned long n, int type)
+{
+	unsigned long i;
+	int fd;
+
+	bench_start();
+	for (i = 0; i < n; i++) {
+		fd = socket(AF_INET, type, 0);
+		if (fd < 0)
+			return -1;
+		close(fd);
+	}
+	bench_stop(n);
+
+	return 0;
+}
+
+/* not eligible for SMC: the wrappers only pass it on */
+static int run_dgram(unsigned long n)
+{
+	return run_socket(n, SOCK_DGRAM);
+}
+
+/* mapped to AF_SMC by the preload library */
+static int run_stream(unsigned long n)
+{
+	return run_socket(n, SOCK_STREAM);
+}
+
+/* fails right away in the kernel: mostly the cost of the wrapper itself */
+static int run_invalid(unsigned long n)
+{
+	unsigned long i;
+
+	bench_start();
+	for (i = 0; i < n; i++) {
+		if (socket(-1, SOCK_STREAM, 0) >= 0)
+			return -1;
+	}
+	bench_stop(n);
+
+	return 0;
+}
+
+static const struct bench_case cases[] = {
+	{ "invalid", run_invalid },
+	{ "dgram", run_dgram },
+	{ "stream", run_stream },
+};
+
+int main(int argc, char **argv)
+{
+	int ncases = sizeof(cases) / sizeof(cases[0]);
+	int fd;
+
+	/* preloaded without the SMC module, TCP sockets cannot be created */
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		printf("{\"bench\":\"socket\",\"case\":\"stream\",\"skipped\":\"%s\"}\n",
+		       errno == EAFNOSUPPORT ? "SMC module not loaded" :
+		       "cannot create a socket");
+		ncases--;
+	} else {
+		close(fd);
+	}
+
+	return bench_main(argc, argv, "socket", "100000,1000000", cases,
+			  ncases);
+}
@@ -0,0 +1,62 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Benchmark of handle_gen_stats_reply() and handle_gen_fback_stats_reply()
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include "stats.c"
+#include "bench_nl.h"
+
+/* the stats dump is a single message, handled n times */
+static int run_stats(unsigned long n)
+{
+	struct bench_msgs msgs;
+	struct nl_gen_cfg cfg;
+
+	nl_gen_defaults(&cfg);
+	cfg.what = NL_GEN_STATS;
+	if (bench_load_genl(&msgs, &cfg, SMC_NETLINK_GET_STATS))
+		return -1;
+
+	return bench_nl_run(&msgs, n * bench_reps(n), handle_gen_stats_reply,
+			    NULL);
+}
+
+static void reset_fback(void)
+{
+	memset(&smc_rsn, 0, sizeof(smc_rsn));
+}
+
+/* n fallback reason records */
+static int run_fback(unsigned long n)
+{
+	struct bench_msgs msgs;
+	struct nl_gen_cfg cfg;
+
+	nl_gen_defaults(&cfg);
+	cfg.what = NL_GEN_FBACK;
+	cfg.fbacks = n;
+	if (bench_load_genl(&msgs, &cfg, SMC_NETLINK_GET_FBACK_STATS))
+		return -1;
+
+	return bench_nl_run(&msgs, bench_reps(msgs.cnt),
+			    handle_gen_fback_stats_reply, reset_fback);
+}
+
+static const struct bench_case cases[] = {
+	{ "stats", run_stats },
+	{ "fback", run_fback },
+};
+
+int main(int argc, char **argv)
+{
+	return bench_main(argc, argv, "stats", BENCH_SIZES, cases,
+			  sizeof(cases) / sizeof(cases[0]));
+}
@@ -18,11 +18,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
 
 #include "smctools_common.h"
 #include "util.h"
 #include "libnetlink.h"
 #include "dev.h"
+#include "topology.h"
 
 #define MASK_ROCE_V1_HEX 0x1004
 #define MASK_ROCE_V2_HEX 0x1016
@@ -43,6 +47,12 @@ static int dev_smcd = 0;
 #endif
 
 static int d_level = 0;
+#if !defined(SMCD)
+static int stats_cmd = 0;
+static int stats_interval = 0;
+static int stats_count = 0;
+static char *sysfs_root = "/sys";
+#endif
 
 static char target_ibdev[IB_DEVICE_NAME_MAX] = {0};
 static char target_type[SMC_TYPE_STR_MAX] = {0};
@@ -81,16 +91,20 @@ static void usage(void)
 		"Usage: smcr device [show] [all]\n"
 		"                          [ibdev <dev>]\n"
 		"                          [netdev <dev>]\n"
+		"       smcr device stats [ibdev <dev> | netdev <dev>] [interval <sec>]\n"
+		"                         [count <n>] [root <path>]\n"
 #else
 		"Usage: smc device [show] [all] [type {smcd | smcr}]\n"
 		"                               [ibdev <dev>]\n"
 		"                               [netdev <dev>]\n"
+		"       smc device stats [ibdev <dev> | netdev <dev>] [interval <sec>]\n"
+		"                        [count <n>] [root <path>]\n"
 #endif
 	);
 	exit(-1);
 }
 
-static const char *smc_ib_port_state(unsigned int x)
+const char *smc_ib_port_state(unsigned int x)
 {
 	static char buf[16];
 
@@ -101,7 +115,7 @@ static const char *smc_ib_port_state(unsigned int x)
 	}
 }
 
-static const char *smc_ib_dev_type(unsigned int x)
+const char *smc_ib_dev_type(unsigned int x)
 {
 	static char buf[16];
 
@@ -217,8 +231,8 @@ static int fill_dev_port_smcr_struct(struct smc_diag_dev_info *dev, struct nlatt
 			 nla_get_string(port_attrs[SMC_NLA_DEV_PORT_PNETID]));
 	if (port_attrs[SMC_NLA_DEV_PORT_PNET_USR])
 		dev->pnetid_by_user[idx] = nla_get_u8(port_attrs[SMC_NLA_DEV_PORT_PNET_USR]);
-	if (port_attrs[SMC_NLA_DEV_PORT_NETDEV] && nla_get_u32(port_attrs[SMC_NLA_DEV_PORT_NETDEV]))
-			if_indextoname(nla_get_u32(port_attrs[SMC_NLA_DEV_PORT_NETDEV]), (char*)dev->netdev[idx]);
+	if (port_attrs[SMC_NLA_DEV_PORT_NETDEV])
+		smc_ifname(nla_get_u32(port_attrs[SMC_NLA_DEV_PORT_NETDEV]), (char*)dev->netdev[idx]);
 	if (port_attrs[SMC_NLA_DEV_PORT_STATE])
 		dev->port_state[idx] = nla_get_u8(port_attrs[SMC_NLA_DEV_PORT_STATE]);
 	if (port_attrs[SMC_NLA_DEV_PORT_VALID])
@@ -229,7 +243,7 @@ static int fill_dev_port_smcr_struct(struct smc_diag_dev_info *dev, struct nlatt
 	return NL_OK;
 }
 
-static int fill_dev_smcr_struct(struct smc_diag_dev_info *dev, struct nlattr **attrs)
+int fill_dev_smcr_struct(struct smc_diag_dev_info *dev, struct nlattr **attrs)
 {
 	struct nlattr *dev_attrs[SMC_NLA_DEV_MAX + 1];
 	int i;
@@ -265,26 +279,21 @@ static int fill_dev_smcr_struct(struct smc_diag_dev_info *dev, struct nlattr **a
 	return NL_OK;
 }
 
-static int show_dev_smcr_info(struct nlattr **attr)
+static void show_dev_smcr_info(struct smc_diag_dev_info *dev)
 {
-	struct smc_diag_dev_info dev;
 	int i;
 
-	if (attr[SMC_GEN_DEV_SMCR]) {
-		if (fill_dev_smcr_struct(&dev, attr) != NL_OK)
-			return NL_STOP;
-
-		for (i = 0; i < SMC_MAX_PORTS; i++) {
-			show_devs_smcr_details(&dev, i);
-		}
-	}
-	return NL_OK;
+	for (i = 0; i < SMC_MAX_PORTS; i++)
+		show_devs_smcr_details(dev, i);
 }
 
 static int fill_dev_port_smcd_struct(struct smc_diag_dev_info *dev, struct nlattr **attrs, int idx)
 {
 	struct nlattr *port_attrs[SMC_NLA_DEV_PORT_MAX + 1];
 
+	if (!attrs[SMC_NLA_DEV_PORT])
+		return NL_OK;
+
 	if (nla_parse_nested(port_attrs, SMC_NLA_DEV_PORT_MAX,
 			     attrs[SMC_NLA_DEV_PORT],
 			     smc_gen_dev_port_smcd_sock_policy)) {
@@ -300,7 +309,7 @@ static int fill_dev_port_smcd_struct(struct smc_diag_dev_info *dev, struct nlatt
 	return NL_OK;
 }
 
-static int fill_dev_smcd_struct(struct smc_diag_dev_info *dev, struct nlattr **attrs)
+int fill_dev_smcd_struct(struct smc_diag_dev_info *dev, struct nlattr **attrs)
 {
 	struct nlattr *dev_attrs[SMC_NLA_DEV_MAX + 1];
 
@@ -332,45 +341,73 @@ static int fill_dev_smcd_struct(struct smc_diag_dev_info *dev, struct nlattr **a
 	return NL_OK;
 }
 
-static int show_dev_smcd_info(struct nlattr **attr)
+static void show_dev_smcd_info(struct smc_diag_dev_info *dev)
 {
 	char buf[SMC_MAX_PNETID_LEN+1] = {0};
-	struct smc_diag_dev_info dev;
 
-	if (attr[SMC_GEN_DEV_SMCD]) {
-		if (fill_dev_smcd_struct(&dev, attr) != NL_OK)
-			return NL_STOP;
-		printf("%04x ", dev.pci_fid);
-		printf("%-4s  ", smc_ib_dev_type(dev.pci_device));
-		printf("%-12s  ", dev.pci_id);
-		printf("%04x   ", dev.pci_pchid);
-		printf("%-4s  ", dev.is_critical?"Yes":"No");
-		printf("%5d ", dev.use_cnt);
-		if (dev.pnetid_by_user[0])
-			snprintf(buf, sizeof(buf),"*%s", dev.pnet_id[0]);
-		else
-			snprintf(buf, sizeof(buf),"%s", dev.pnet_id[0]);
-		printf(" %-16s ", trim_space(buf));
-		printf("\n");
+	printf("%04x ", dev->pci_fid);
+	printf("%-4s  ", smc_ib_dev_type(dev->pci_device));
+	printf("%-12s  ", dev->pci_id);
+	printf("%04x   ", dev->pci_pchid);
+	printf("%-4s  ", dev->is_critical?"Yes":"No");
+	printf("%5d ", dev->use_cnt);
+	if (dev->pnetid_by_user[0])
+		snprintf(buf, sizeof(buf),"*%s", dev->pnet_id[0]);
+	else
+		snprintf(buf, sizeof(buf),"%s", dev->pnet_id[0]);
+	printf(" %-16s ", trim_space(buf));
+	printf("\n");
+}
+
+static struct smc_dev_inventory inventory;
+static int inventory_valid = 0;	/* SMC_INV_* parts filled */
+
+#define SMC_INV_MIN_DEVS	8
+
+/* Append a device. The array holds SMC_INV_MIN_DEVS devices, or the next
+ * power of two, so that it grows in log(n) steps.
+ */
+static struct smc_diag_dev_info *inventory_add(struct smc_diag_dev_info **devs, int *ndevs)
+{
+	struct smc_diag_dev_info *tmp = *devs;
+	int n = *ndevs;
+
+	if (n >= SMC_INV_MIN_DEVS ? !(n & (n - 1)) : !n) {
+		tmp = realloc(*devs, (n ? 2 * n : SMC_INV_MIN_DEVS) * sizeof(*tmp));
+		if (!tmp) {
+			perror("Error: Cannot allocate memory");
+			return NULL;
+		}
+		*devs = tmp;
 	}
+	memset(&tmp[n], 0, sizeof(*tmp));
 
-	return NL_OK;
+	return &tmp[(*ndevs)++];
 }
 
-static int handle_gen_dev_reply(struct nl_msg *msg, void *arg)
+static void inventory_clear(int what)
+{
+	if (what & SMC_INV_SMCR) {
+		free(inventory.smcr);
+		inventory.smcr = NULL;
+		inventory.nsmcr = 0;
+	}
+	if (what & SMC_INV_SMCD) {
+		free(inventory.smcd);
+		inventory.smcd = NULL;
+		inventory.nsmcd = 0;
+	}
+	if ((what & SMC_INV_SYS) && inventory.sys_info) {
+		nlmsg_free(inventory.sys_info);
+		inventory.sys_info = NULL;
+	}
+}
+
+static int handle_inventory_reply(struct nl_msg *msg, void *arg)
 {
 	struct nlattr *attrs[SMC_GEN_MAX + 1];
 	struct nlmsghdr *hdr = nlmsg_hdr(msg);
-	static int header_printed = 0;
-	int rc = NL_OK;
-
-	if (!header_printed) {
-		if (dev_smcr)
-			print_devs_smcr_header();
-		else
-			print_devs_smcd_header();
-		header_printed = 1;
-	}
+	struct smc_diag_dev_info *dev;
 
 	if (genlmsg_parse(hdr, 0, attrs, SMC_GEN_MAX,
 			  (struct nla_policy *)smc_gen_net_policy) < 0) {
@@ -379,18 +416,326 @@ static int handle_gen_dev_reply(struct nl_msg *msg, void *arg)
 		return NL_STOP;
 	}
 
-	if (!attrs[SMC_GEN_DEV_SMCD] && !attrs[SMC_GEN_DEV_SMCR])
+	if (attrs[SMC_GEN_DEV_SMCR]) {
+		dev = inventory_add(&inventory.smcr, &inventory.nsmcr);
+		if (!dev || fill_dev_smcr_struct(dev, attrs) != NL_OK)
+			return NL_STOP;
+	} else if (attrs[SMC_GEN_DEV_SMCD]) {
+		dev = inventory_add(&inventory.smcd, &inventory.nsmcd);
+		if (!dev || fill_dev_smcd_struct(dev, attrs) != NL_OK)
+			return NL_STOP;
+	} else if (attrs[SMC_GEN_SYS_INFO]) {
+		/* kept as message, parsed by its only user */
+		if (inventory.sys_info)
+			nlmsg_free(inventory.sys_info);
+		inventory.sys_info = nlmsg_convert(hdr);
+		if (!inventory.sys_info)
+			return NL_STOP;
+	} else {
 		return NL_STOP;
+	}
+
+	return NL_OK;
+}
+
+/* Return the devices and system info of the SMC_INV_* parts in what. Missing
+ * parts are dumped one after another, and kept for the rest of the process,
+ * so that subcommands do not dump the devices again.
+ */
+struct smc_dev_inventory *dev_inventory_get(int what)
+{
+	int missing = what & ~inventory_valid;
+	int cmds[3], ncmds = 0;
+
+	if (!missing)
+		return &inventory;
+
+	if (missing & SMC_INV_SMCR)
+		cmds[ncmds++] = SMC_NETLINK_GET_DEV_SMCR;
+	if (missing & SMC_INV_SMCD)
+		cmds[ncmds++] = SMC_NETLINK_GET_DEV_SMCD;
+	if (missing & SMC_INV_SYS)
+		cmds[ncmds++] = SMC_NETLINK_GET_SYS_INFO;
+
+	if (gen_nl_handle_dumps(cmds, ncmds, handle_inventory_reply, NULL)) {
+		inventory_clear(missing);
+		return NULL;
+	}
+	inventory_valid |= missing;
+
+	return &inventory;
+}
+
+/* Drop the kept inventory, the next dev_inventory_get() dumps it again */
+void dev_inventory_reset(void)
+{
+	inventory_clear(inventory_valid);
+	inventory_valid = 0;
+}
+
+#if !defined(SMCD)
+/* RDMA port counters, relative to <root>/class/infiniband/<dev>/ports/<port> */
+enum {
+	SMC_HWC_XMIT_DATA,
+	SMC_HWC_RCV_DATA,
+	SMC_HWC_XMIT_PKTS,
+	SMC_HWC_RCV_PKTS,
+	SMC_HWC_ACK_TIMEOUT,		/* retransmits: first of the three */
+	SMC_HWC_SEQ_ERR,
+	SMC_HWC_IMPLIED_NAK,
+	SMC_HWC_MAX,
+};
+
+static const struct {
+	const char	*path;
+	int		scale;
+} hw_counters[SMC_HWC_MAX] = {
+	/* port_*_data count in units of 4 bytes */
+	[SMC_HWC_XMIT_DATA]	= { "counters/port_xmit_data", 4 },
+	[SMC_HWC_RCV_DATA]	= { "counters/port_rcv_data", 4 },
+	[SMC_HWC_XMIT_PKTS]	= { "counters/port_xmit_packets", 1 },
+	[SMC_HWC_RCV_PKTS]	= { "counters/port_rcv_packets", 1 },
+	[SMC_HWC_ACK_TIMEOUT]	= { "hw_counters/local_ack_timeout_err", 1 },
+	[SMC_HWC_SEQ_ERR]	= { "hw_counters/packet_seq_err", 1 },
+	[SMC_HWC_IMPLIED_NAK]	= { "hw_counters/implied_nak_seq_err", 1 },
+};
+
+struct port_sample {
+	struct port_sample	*next;
+	__u8			ibname[IB_DEVICE_NAME_MAX];
+	__u8			ibport;
+	char			netdev[IFNAMSIZ];
+	int			fd[SMC_HWC_MAX];
+	__u64			val[SMC_HWC_MAX];
+	__u64			delta[SMC_HWC_MAX];
+};
+
+static struct port_sample *port_samples;
+
+static void port_sample_open(struct smc_diag_dev_info *dev, int idx)
+{
+	struct port_sample *ps;
+	char path[PATH_MAX];
+	int i, found = 0;
+
+	ps = calloc(1, sizeof(*ps));
+	if (!ps) {
+		perror("Error: Cannot allocate memory");
+		exit(-1);
+	}
+	memcpy(ps->ibname, dev->dev_name, sizeof(ps->ibname));
+	ps->ibport = idx + 1;
+	snprintf(ps->netdev, sizeof(ps->netdev), "%s", (char *)dev->netdev[idx]);
+	for (i = 0; i < SMC_HWC_MAX; i++) {
+		snprintf(path, sizeof(path), "%s/class/infiniband/%s/ports/%d/%s",
+			 sysfs_root, (char *)ps->ibname, ps->ibport, hw_counters[i].path);
+		ps->fd[i] = open(path, O_RDONLY | O_CLOEXEC);
+		if (ps->fd[i] >= 0)
+			found = 1;
+	}
+	if (!found)
+		fprintf(stderr, "Error: No counters found for %s port %d in %s\n",
+			(char *)ps->ibname, ps->ibport, sysfs_root);
+	ps->next = port_samples;
+	port_samples = ps;
+}
+
+/* Read all counters of a port, the file descriptors stay open */
+static void port_sample_read(struct port_sample *ps)
+{
+	char buf[32];
+	__u64 val;
+	ssize_t n;
+	int i;
+
+	for (i = 0; i < SMC_HWC_MAX; i++) {
+		if (ps->fd[i] < 0)
+			continue;
+		n = pread(ps->fd[i], buf, sizeof(buf) - 1, 0);
+		if (n <= 0)
+			continue;
+		buf[n] = '\0';
+		val = strtoull(buf, NULL, 10) * hw_counters[i].scale;
+		/* counter reset or 32 bit wrap: count from zero */
+		ps->delta[i] = val >= ps->val[i] ? val - ps->val[i] : val;
+		ps->val[i] = val;
+	}
+}
+
+static void print_dev_stats_header(void)
+{
+	printf("Time      ");
+	printf("IB-Dev   ");
+	printf("IB-P  ");
+	printf("Net-Dev         ");
+	printf("#Links  ");
+	printf("#Conns  ");
+	printf("TX-B/s  ");
+	printf("RX-B/s  ");
+	printf("TX-Pk/s  ");
+	printf("RX-Pk/s  ");
+	printf("Retr/s");
+	printf("\n");
+}
+
+static void print_rate(__u64 delta, int avail, int width)
+{
+	char buf[7];
+
+	if (!avail) {
+		printf("%*s  ", width, "-");
+		return;
+	}
+	get_abbreviated(delta / stats_interval, 6, buf);
+	printf("%*s  ", width, buf);
+}
+
+static void print_port_sample(struct port_sample *ps, struct topology *topo,
+			      const char *tstamp)
+{
+	struct topo_link *link;
+	struct topo_port *port;
+	int nlinks = 0, conns = 0;
+
+	port = topo ? topology_find_port(topo, ps->ibname, ps->ibport) : NULL;
+	if (port) {
+		nlinks = port->nlinks;
+		for (link = port->links; link; link = link->next_port)
+			conns += link->info.conn_cnt;
+	}
+
+	printf("%s  ", tstamp);
+	printf("%-8s ", ps->ibname);
+	printf("%4d  ", ps->ibport);
+	printf("%-15s ", ps->netdev);
+	printf("%6d  ", nlinks);
+	printf("%6d  ", conns);
+	print_rate(ps->delta[SMC_HWC_XMIT_DATA], ps->fd[SMC_HWC_XMIT_DATA] >= 0, 6);
+	print_rate(ps->delta[SMC_HWC_RCV_DATA], ps->fd[SMC_HWC_RCV_DATA] >= 0, 6);
+	print_rate(ps->delta[SMC_HWC_XMIT_PKTS], ps->fd[SMC_HWC_XMIT_PKTS] >= 0, 7);
+	print_rate(ps->delta[SMC_HWC_RCV_PKTS], ps->fd[SMC_HWC_RCV_PKTS] >= 0, 7);
+	print_rate(ps->delta[SMC_HWC_ACK_TIMEOUT] + ps->delta[SMC_HWC_SEQ_ERR] +
+		   ps->delta[SMC_HWC_IMPLIED_NAK],
+		   ps->fd[SMC_HWC_ACK_TIMEOUT] >= 0 || ps->fd[SMC_HWC_SEQ_ERR] >= 0 ||
+		   ps->fd[SMC_HWC_IMPLIED_NAK] >= 0, 6);
+	printf("\n");
+}
 
-	if (dev_smcd && attrs[SMC_GEN_DEV_SMCD])
-		rc = show_dev_smcd_info(&attrs[0]);
-	if (dev_smcr && attrs[SMC_GEN_DEV_SMCR])
-		rc = show_dev_smcr_info(&attrs[0]);
-	return rc;
+static int show_dev_stats(void)
+{
+	struct smc_dev_inventory *inv;
+	struct port_sample *ps, *next;
+	struct topology *topo;
+	struct timespec ts;
+	char tstamp[16];
+	unsigned int n;
+	int i, j;
+
+	inv = dev_inventory_get(SMC_INV_SMCR);
+	if (!inv)
+		return EXIT_FAILURE;
+	for (i = 0; i < inv->nsmcr; i++) {
+		for (j = 0; j < SMC_MAX_PORTS; j++) {
+			if (inv->smcr[i].port_valid[j] && !filter_item(&inv->smcr[i], j))
+				port_sample_open(&inv->smcr[i], j);
+		}
+	}
+	if (!port_samples) {
+		fprintf(stderr, "Error: No SMC-R device port found\n");
+		return EXIT_FAILURE;
+	}
+
+	/* like vmstat: without interval report once, without count forever */
+	if (!stats_interval) {
+		stats_interval = 1;
+		if (!stats_count)
+			stats_count = 1;
+	}
+	/* sample 0 is the base of the first interval, a replay without
+	 * further samples ends the report
+	 */
+	nl_sample(0, stats_interval, &ts);
+	for (ps = port_samples; ps; ps = ps->next)
+		port_sample_read(ps);
+	print_dev_stats_header();
+	for (n = 1; !stats_count || n <= (unsigned int)stats_count; n++) {
+		if (nl_sample(n, stats_interval, &ts))
+			break;
+		for (ps = port_samples; ps; ps = ps->next)
+			port_sample_read(ps);
+		/* link and connection counts of the current interval */
+		topo = topology_build(1, 0, TOPO_NO_SOCKS);
+		strftime(tstamp, sizeof(tstamp), "%H:%M:%S",
+			 localtime(&ts.tv_sec));
+		for (ps = port_samples; ps; ps = ps->next)
+			print_port_sample(ps, topo, tstamp);
+		topology_free(topo);
+		fflush(stdout);
+	}
+
+	for (ps = port_samples; ps; ps = next) {
+		next = ps->next;
+		for (i = 0; i < SMC_HWC_MAX; i++)
+			if (ps->fd[i] >= 0)
+				close(ps->fd[i]);
+		free(ps);
+	}
+	port_samples = NULL;
+
+	return EXIT_SUCCESS;
+}
+
+static void handle_stats_params(int argc, char **argv)
+{
+	while (NEXT_ARG_OK()) {
+		NEXT_ARG();
+		if (contains(argv[0], "help") == 0) {
+			usage();
+		} else if (contains(argv[0], "ibdev") == 0) {
+			if (!NEXT_ARG_OK())
+				usage();
+			NEXT_ARG();
+			snprintf(target_ibdev, sizeof(target_ibdev), "%s", argv[0]);
+		} else if (contains(argv[0], "netdev") == 0) {
+			if (!NEXT_ARG_OK())
+				usage();
+			NEXT_ARG();
+			snprintf(target_ndev, sizeof(target_ndev), "%s", argv[0]);
+		} else if (contains(argv[0], "interval") == 0) {
+			if (!NEXT_ARG_OK())
+				usage();
+			NEXT_ARG();
+			stats_interval = atoi(argv[0]);
+			if (stats_interval <= 0)
+				usage();
+		} else if (contains(argv[0], "count") == 0) {
+			if (!NEXT_ARG_OK())
+				usage();
+			NEXT_ARG();
+			stats_count = atoi(argv[0]);
+			if (stats_count <= 0)
+				usage();
+		} else if (contains(argv[0], "root") == 0) {
+			if (!NEXT_ARG_OK())
+				usage();
+			NEXT_ARG();
+			sysfs_root = argv[0];
+		} else {
+			usage();
+		}
+	}
 }
+#endif
 
 static void handle_cmd_params(int argc, char **argv)
 {
+#if !defined(SMCD)
+	if ((argc > 0) && (contains(argv[0], "stats") == 0)) {
+		stats_cmd = 1;
+		handle_stats_params(argc, argv);
+		return;
+	}
+#endif
 	if (((argc == 1) && (contains(argv[0], "help") == 0)) || (argc > 4))
 		usage();
 
@@ -443,103 +788,66 @@ static void handle_cmd_params(int argc, char **argv)
 
 int invoke_devs(int argc, char **argv, int detail_level)
 {
-	int rc = EXIT_SUCCESS;
+	struct smc_dev_inventory *inv;
+	int i;
 
 	d_level = detail_level;
 	handle_cmd_params(argc, argv);
-	if (dev_smcd)
-		rc = gen_nl_handle_dump(SMC_NETLINK_GET_DEV_SMCD, handle_gen_dev_reply, NULL);
-	else
-		rc = gen_nl_handle_dump(SMC_NETLINK_GET_DEV_SMCR, handle_gen_dev_reply, NULL);
-
-	return rc;
-}
-
-/* arg is an (int *) */
-static int count_ism_devices_reply(struct nl_msg *msg, void *arg)
-{
-	struct nlattr *attrs[SMC_GEN_MAX + 1];
-	struct nlmsghdr *hdr = nlmsg_hdr(msg);
-	int *ism_count = (int *)arg;
-
-	if (genlmsg_parse(hdr, 0, attrs, SMC_GEN_MAX,
-			  (struct nla_policy *)smc_gen_net_policy) < 0) {
-		fprintf(stderr, "Error: Invalid data returned: smc_gen_net_policy\n");
-		nl_msg_dump(msg, stderr);
-		return NL_STOP;
+#if !defined(SMCD)
+	if (stats_cmd)
+		return show_dev_stats();
+#endif
+	inv = dev_inventory_get(dev_smcd ? SMC_INV_SMCD : SMC_INV_SMCR);
+	if (!inv)
+		return EXIT_FAILURE;
+	if (dev_smcd) {
+		if (inv->nsmcd)
+			print_devs_smcd_header();
+		for (i = 0; i < inv->nsmcd; i++)
+			show_dev_smcd_info(&inv->smcd[i]);
+	} else {
+		if (inv->nsmcr)
+			print_devs_smcr_header();
+		for (i = 0; i < inv->nsmcr; i++)
+			show_dev_smcr_info(&inv->smcr[i]);
 	}
 
-	if (!attrs[SMC_GEN_DEV_SMCD])
-		return NL_STOP;
-
-	(*ism_count)++;
-
-	return NL_OK;
+	return EXIT_SUCCESS;
 }
 
 int dev_count_ism_devices(int *ism_count)
 {
-	*ism_count = 0;
-	return gen_nl_handle_dump(SMC_NETLINK_GET_DEV_SMCD, count_ism_devices_reply, ism_count);
-}
+	struct smc_dev_inventory *inv;
 
-struct count_roce_args {
-	int *rocev1_count;
-	int *rocev2_count;
-	int *rocev3_count;
-};
-
-/* arg is an (struct count_roce_args *) */
-static int count_roce_devices_reply(struct nl_msg *msg, void *arg)
-{
-	struct count_roce_args *args = (struct count_roce_args *)arg;
-	struct nlattr *attrs[SMC_GEN_MAX + 1];
-	struct nlmsghdr *hdr = nlmsg_hdr(msg);
-
-	if (genlmsg_parse(hdr, 0, attrs, SMC_GEN_MAX,
-			  (struct nla_policy *)smc_gen_net_policy) < 0) {
-		fprintf(stderr, "Error: Invalid data returned: smc_gen_net_policy\n");
-		nl_msg_dump(msg, stderr);
-		return NL_STOP;
-	}
-
-	if (!attrs[SMC_GEN_DEV_SMCR])
-		return NL_STOP;
-
-	/* Determine PCI device type */
-	{
-		struct nlattr *dev_attrs[SMC_NLA_DEV_MAX + 1];
-		short i = 0;
-
-		if (nla_parse_nested(dev_attrs, SMC_NLA_DEV_MAX,
-				     attrs[SMC_GEN_DEV_SMCR],
-				     smc_gen_dev_smcd_sock_policy)) {
-			fprintf(stderr, "Error: Failed to parse nested attributes: smc_gen_dev_smcd_sock_policy\n");
-			return NL_STOP;
-		}
-		if (dev_attrs[SMC_NLA_DEV_PCI_DEVICE])
-			i = nla_get_u16(dev_attrs[SMC_NLA_DEV_PCI_DEVICE]);
-		if (i == MASK_ROCE_V1_HEX)
-			(*args->rocev1_count)++;
-		if (i == MASK_ROCE_V2_HEX)
-			(*args->rocev2_count)++;
-		if (i == MASK_ROCE_V3_HEX)
-			(*args->rocev3_count)++;
-	}
+	*ism_count = 0;
+	inv = dev_inventory_get(SMC_INV_SMCD);
+	if (!inv)
+		return EXIT_FAILURE;
+	*ism_count = inv->nsmcd;
 
-	return NL_OK;
+	return EXIT_SUCCESS;
 }
 
 int dev_count_roce_devices(int *rocev1_count, int *rocev2_count, int *rocev3_count)
 {
-	struct count_roce_args args = {
-			.rocev1_count = rocev1_count,
-			.rocev2_count = rocev2_count,
-			.rocev3_count = rocev3_count,
-	};
+	struct smc_dev_inventory *inv;
+	int i;
 
 	*rocev1_count = 0;
 	*rocev2_count = 0;
 	*rocev3_count = 0;
-	return gen_nl_handle_dump(SMC_NETLINK_GET_DEV_SMCR, count_roce_devices_reply, &args);
+	inv = dev_inventory_get(SMC_INV_SMCR);
+	if (!inv)
+		return EXIT_FAILURE;
+	/* Determine PCI device type */
+	for (i = 0; i < inv->nsmcr; i++) {
+		if (inv->smcr[i].pci_device == MASK_ROCE_V1_HEX)
+			(*rocev1_count)++;
+		if (inv->smcr[i].pci_device == MASK_ROCE_V2_HEX)
+			(*rocev2_count)++;
+		if (inv->smcr[i].pci_device == MASK_ROCE_V3_HEX)
+			(*rocev3_count)++;
+	}
+
+	return EXIT_SUCCESS;
 }
@@ -18,8 +18,27 @@
 
 extern struct rtnl_handle rth;
 
+/* parts of the device inventory */
+#define SMC_INV_SMCR	1
+#define SMC_INV_SMCD	2
+#define SMC_INV_SYS	4	/* SMC_NETLINK_GET_SYS_INFO reply */
+
+struct smc_dev_inventory {
+	struct smc_diag_dev_info	*smcr;
+	int				nsmcr;
+	struct smc_diag_dev_info	*smcd;
+	int				nsmcd;
+	struct nl_msg			*sys_info;
+};
+
 int invoke_devs(int argc, char **argv, int detail_level);
+struct smc_dev_inventory *dev_inventory_get(int what);
+void dev_inventory_reset(void);
 int dev_count_ism_devices(int *ism_count);
 int dev_count_roce_devices(int *rocev1_count, int *rocev2_count, int *rocev3_count);
+int fill_dev_smcr_struct(struct smc_diag_dev_info *dev, struct nlattr **attrs);
+int fill_dev_smcd_struct(struct smc_diag_dev_info *dev, struct nlattr **attrs);
+const char *smc_ib_port_state(unsigned int x);
+const char *smc_ib_dev_type(unsigned int x);
 
 #endif /* DEV_H_ */
@@ -0,0 +1,39 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Fuzz harnesses for the netlink reply handlers and the stats cache file
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#ifndef FUZZ_H_
+#define FUZZ_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Each harness implements the libFuzzer entry points. Without libFuzzer,
+ * fuzz_main.c runs them on files, for AFL and for replaying a corpus.
+ *
+ * The input of the handler harnesses is a byte of FUZZ_F_* flags that set
+ * the command line options of the tool, followed by netlink messages as the
+ * kernel sends them. fuzz_topo takes a whole SMC_NL_RECORD recording and
+ * fuzz_cache the text of a stats cache file.
+ */
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#define FUZZ_F_DETAIL	0x01	/* -d */
+#define FUZZ_F_DETAIL2	0x02	/* -dd */
+#define FUZZ_F_ALL	0x04	/* smcss -a, smcr -a stats */
+#define FUZZ_F_SMCD	0x08	/* SMC-D instead of SMC-R */
+#define FUZZ_F_FILTER	0x10	/* a filter that matches the generated dumps */
+#define FUZZ_F_MODE	0x20	/* a second mode, e.g. link-show or json */
+#define FUZZ_F_WIDE	0x40	/* smcss -W */
+
+#endif /* FUZZ_H_ */
@@ -0,0 +1,51 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Fuzz harness for read_cache_file(): the stats cache that smcr and smcd
+ * stats read from /tmp, and the relative output computed from it
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include "stats.c"
+#include "fuzz.h"
+
+/* for the syslog of smcr stats -w */
+char *myname = "smcr";
+
+int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+	cache_file_path = "fuzz";
+	if (!freopen("/dev/null", "w", stdout))
+		return -1;
+	return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	FILE *fp;
+
+	if (!size)
+		return 0;
+	fp = fmemopen((void *)data, size, "r");
+	if (!fp)
+		return 0;
+	/* kernel values above any cached ones, so that they are subtracted */
+	memset(&smc_stat, 0x7f, sizeof(smc_stat));
+	memset(&smc_rsn, 0x7f, sizeof(smc_rsn));
+	memset(&smc_stat_c, 0, sizeof(smc_stat_c));
+	memset(&smc_rsn_c, 0, sizeof(smc_rsn_c));
+	cache_file_exists = 0;
+	read_cache_file(fp);
+	fclose(fp);
+	if (cache_file_exists && is_data_consistent())
+		subtract_cache();
+	print_as_text();
+
+	return 0;
+}
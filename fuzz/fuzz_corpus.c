@@ -0,0 +1,294 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Seed corpora of the fuzz harnesses, written to DIR/<harness>/: generated
+ * dumps with the flags that make the handlers take their other paths, a
+ * whole recording for fuzz_topo, and cache files for fuzz_cache
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <linux/genetlink.h>
+
+#include "../smctools_common.h"
+#include "../libnetlink.h"
+#include "../stats.h"
+#include "../tests/nl_gen.h"
+#include "fuzz.h"
+
+static const char *outdir;
+
+static int seed_write(const char *harness, const char *name, const void *data,
+		      size_t size)
+{
+	char path[256];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/%s", outdir, harness);
+	if (mkdir(path, 0755) && errno != EEXIST)
+		goto errout;
+	snprintf(path, sizeof(path), "%s/%s/%s", outdir, harness, name);
+	fp = fopen(path, "w");
+	if (!fp)
+		goto errout;
+	if ((size && fwrite(data, size, 1, fp) != 1) | fclose(fp))
+		goto errout;
+	return 0;
+errout:
+	fprintf(stderr, "Error: Cannot write %s: %s\n", path, strerror(errno));
+	return -1;
+}
+
+/* A generated recording of cfg */
+static char *gen_rec(const struct nl_gen_cfg *cfg, size_t *size)
+{
+	char *buf;
+	FILE *fp;
+
+	fp = open_memstream(&buf, size);
+	if (!fp)
+		return NULL;
+	if (nl_gen_write(fp, cfg) < 0) {
+		fclose(fp);
+		free(buf);
+		return NULL;
+	}
+	if (fclose(fp))
+		return NULL;
+	return buf;
+}
+
+/* The messages of kind and cmd in a recording of cfg without the NLMSG_DONE,
+ * after a byte of flags, as the handler harnesses take them
+ */
+static int seed_msgs(const char *harness, const char *name,
+		     const struct nl_gen_cfg *cfg, int kind, int cmd, int flags)
+{
+	size_t size, off, len = 0;
+	struct nl_rec_hdr *hdr;
+	struct nlmsghdr *nlh;
+	char *rec, *buf;
+	int rc;
+
+	rec = gen_rec(cfg, &size);
+	if (!rec)
+		return -1;
+	buf = malloc(size + 1);
+	if (!buf) {
+		free(rec);
+		return -1;
+	}
+	buf[len++] = flags;
+	for (off = 0; off + sizeof(*hdr) <= size; off += sizeof(*hdr) + hdr->len) {
+		hdr = (struct nl_rec_hdr *)(rec + off);
+		nlh = (struct nlmsghdr *)(hdr + 1);
+		if (hdr->kind != (__u32)kind || hdr->cmd != (__u32)cmd ||
+		    nlh->nlmsg_type == NLMSG_DONE)
+			continue;
+		memcpy(buf + len, nlh, hdr->len);
+		len += hdr->len;
+	}
+	rc = seed_write(harness, name, buf, len);
+	free(buf);
+	free(rec);
+
+	return rc;
+}
+
+static int seed_genl(const char *harness, const char *name, unsigned int what,
+		     int cmd, int flags)
+{
+	struct nl_gen_cfg cfg;
+
+	nl_gen_defaults(&cfg);
+	cfg.what = what;
+	return seed_msgs(harness, name, &cfg, NL_REC_GENL, cmd, flags);
+}
+
+/* A generic netlink message with one attribute, for the EID tables that the
+ * generator does not dump
+ */
+static int seed_eid(const char *harness, const char *name, int flags,
+		    const char *eid, int enabled)
+{
+	char buf[1 + NLMSG_SPACE(GENL_HDRLEN + 2 * NLA_HDRLEN + 2 * 36)];
+	struct genlmsghdr *genl;
+	struct nlmsghdr *nlh;
+	struct nlattr *nla;
+	size_t len;
+
+	memset(buf, 0, sizeof(buf));
+	buf[0] = flags;
+	nlh = (struct nlmsghdr *)(buf + 1);
+	nlh->nlmsg_type = GENL_ID_CTRL + 1;
+	nlh->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+	genl = NLMSG_DATA(nlh);
+	genl->cmd = SMC_NETLINK_DUMP_SEID;
+	genl->version = SMC_GENL_FAMILY_VERSION;
+	len = strlen(eid) + 1;
+	nla = (struct nlattr *)((char *)nlh + nlh->nlmsg_len);
+	nla->nla_type = enabled < 0 ? SMC_NLA_EID_TABLE_ENTRY : SMC_NLA_SEID_ENTRY;
+	nla->nla_len = NLA_HDRLEN + len;
+	memcpy((char *)nla + NLA_HDRLEN, eid, len);
+	nlh->nlmsg_len += NLA_ALIGN(nla->nla_len);
+	if (enabled >= 0) {
+		nla = (struct nlattr *)((char *)nlh + nlh->nlmsg_len);
+		nla->nla_type = SMC_NLA_SEID_ENABLED;
+		nla->nla_len = NLA_HDRLEN + 1;
+		*((char *)nla + NLA_HDRLEN) = enabled;
+		nlh->nlmsg_len += NLA_ALIGN(nla->nla_len);
+	}
+	return seed_write(harness, name, buf, 1 + nlh->nlmsg_len);
+}
+
+/* A stats cache file in the format of fill_cache_file() */
+static int seed_cache(const char *name, unsigned long long base, int ncodes)
+{
+	int size, i, rc = -1;
+	size_t len;
+	char *buf;
+	FILE *fp;
+
+	fp = open_memstream(&buf, &len);
+	if (!fp)
+		return -1;
+	size = sizeof(struct smc_stats) / sizeof(__u64);
+	for (i = 0; i < size; i++)
+		fprintf(fp, "%-12d%-16llu\n", i, base + i);
+	size = 2 * SMC_MAX_FBACK_RSN_CNT;
+	for (i = 0; i < size; i++)
+		fprintf(fp, "%-12d%-16d%-16d\n", i,
+			i % SMC_MAX_FBACK_RSN_CNT < ncodes ? 0x03010000 + i : 0,
+			i % SMC_MAX_FBACK_RSN_CNT < ncodes ? i + 1 : 0);
+	fprintf(fp, "%16llu\n", base);
+	fprintf(fp, "%16llu\n", base / 2);
+	if (!fclose(fp))
+		rc = seed_write("cache", name, buf, len);
+	free(buf);
+
+	return rc;
+}
+
+int main(int argc, char **argv)
+{
+	struct nl_gen_cfg cfg;
+	size_t size;
+	char *rec;
+	int rc = 0;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: fuzz_corpus DIR\n");
+		return EXIT_FAILURE;
+	}
+	outdir = argv[1];
+	if (mkdir(outdir, 0755) && errno != EEXIST) {
+		fprintf(stderr, "Error: Cannot create %s: %s\n", outdir,
+			strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	/* smcr linkgroup [-d] [00000100], link-show [ibdev mlx5_0], smcd */
+	rc |= seed_genl("lgr", "lgr", NL_GEN_LGR, SMC_NETLINK_GET_LGR_SMCR, 0);
+	rc |= seed_genl("lgr", "lgr-d", NL_GEN_LGR, SMC_NETLINK_GET_LGR_SMCR,
+			FUZZ_F_DETAIL);
+	rc |= seed_genl("lgr", "lgr-filter", NL_GEN_LGR, SMC_NETLINK_GET_LGR_SMCR,
+			FUZZ_F_FILTER);
+	rc |= seed_genl("lgr", "link", NL_GEN_LINK, SMC_NETLINK_GET_LINK_SMCR,
+			FUZZ_F_MODE);
+	rc |= seed_genl("lgr", "link-d", NL_GEN_LINK, SMC_NETLINK_GET_LINK_SMCR,
+			FUZZ_F_MODE | FUZZ_F_DETAIL);
+	rc |= seed_genl("lgr", "link-ibdev", NL_GEN_LINK, SMC_NETLINK_GET_LINK_SMCR,
+			FUZZ_F_MODE | FUZZ_F_FILTER | FUZZ_F_WIDE);
+	rc |= seed_genl("lgr", "lgrd", NL_GEN_LGRD, SMC_NETLINK_GET_LGR_SMCD,
+			FUZZ_F_SMCD);
+	rc |= seed_genl("lgr", "lgrd-d", NL_GEN_LGRD, SMC_NETLINK_GET_LGR_SMCD,
+			FUZZ_F_SMCD | FUZZ_F_DETAIL);
+
+	/* smcr and smcd device [-d] [ibdev/netdev] */
+	rc |= seed_genl("dev", "devr", NL_GEN_DEVR, SMC_NETLINK_GET_DEV_SMCR, 0);
+	rc |= seed_genl("dev", "devr-d", NL_GEN_DEVR, SMC_NETLINK_GET_DEV_SMCR,
+			FUZZ_F_DETAIL);
+	rc |= seed_genl("dev", "devr-filter", NL_GEN_DEVR,
+			SMC_NETLINK_GET_DEV_SMCR, FUZZ_F_FILTER);
+	rc |= seed_genl("dev", "devr-netdev", NL_GEN_DEVR,
+			SMC_NETLINK_GET_DEV_SMCR, FUZZ_F_FILTER | FUZZ_F_MODE);
+	rc |= seed_genl("dev", "devd", NL_GEN_DEVD, SMC_NETLINK_GET_DEV_SMCD,
+			FUZZ_F_SMCD);
+	rc |= seed_genl("dev", "devd-d", NL_GEN_DEVD, SMC_NETLINK_GET_DEV_SMCD,
+			FUZZ_F_SMCD | FUZZ_F_DETAIL);
+
+	/* smcr and smcd info */
+	rc |= seed_genl("info", "info", NL_GEN_SYS, SMC_NETLINK_GET_SYS_INFO, 0);
+	rc |= seed_genl("info", "info-devs", NL_GEN_SYS, SMC_NETLINK_GET_SYS_INFO,
+			FUZZ_F_DETAIL | FUZZ_F_SMCD | FUZZ_F_ALL);
+
+	/* smcr and smcd [-d] [-a] stats [json] */
+	rc |= seed_genl("stats", "smcr", NL_GEN_STATS, SMC_NETLINK_GET_STATS, 0);
+	rc |= seed_genl("stats", "smcr-d", NL_GEN_STATS, SMC_NETLINK_GET_STATS,
+			FUZZ_F_DETAIL | FUZZ_F_ALL);
+	rc |= seed_genl("stats", "smcr-json", NL_GEN_STATS, SMC_NETLINK_GET_STATS,
+			FUZZ_F_MODE | FUZZ_F_DETAIL);
+	rc |= seed_genl("stats", "smcd", NL_GEN_STATS, SMC_NETLINK_GET_STATS,
+			FUZZ_F_SMCD | FUZZ_F_DETAIL);
+	rc |= seed_genl("stats", "smcd-json", NL_GEN_STATS, SMC_NETLINK_GET_STATS,
+			FUZZ_F_SMCD | FUZZ_F_MODE);
+	rc |= seed_genl("fback", "smcr", NL_GEN_FBACK,
+			SMC_NETLINK_GET_FBACK_STATS, FUZZ_F_DETAIL);
+	rc |= seed_genl("fback", "smcr-json", NL_GEN_FBACK,
+			SMC_NETLINK_GET_FBACK_STATS, FUZZ_F_MODE | FUZZ_F_ALL);
+	rc |= seed_genl("fback", "smcd", NL_GEN_FBACK,
+			SMC_NETLINK_GET_FBACK_STATS, FUZZ_F_SMCD);
+
+	/* smcss with the extensions of smcss -d, and its display options */
+	nl_gen_defaults(&cfg);
+	cfg.what = NL_GEN_SOCK;
+	cfg.sock_ext = (1 << (SMC_DIAG_CONNINFO - 1)) |
+		       (1 << (SMC_DIAG_LGRINFO - 1)) |
+		       (1 << (SMC_DIAG_DMBINFO - 1));
+	rc |= seed_msgs("smcss", "all", &cfg, NL_REC_DIAG, cfg.sock_ext,
+			FUZZ_F_ALL);
+	rc |= seed_msgs("smcss", "debug", &cfg, NL_REC_DIAG, cfg.sock_ext,
+			FUZZ_F_DETAIL | FUZZ_F_WIDE);
+	rc |= seed_msgs("smcss", "listening", &cfg, NL_REC_DIAG, cfg.sock_ext,
+			FUZZ_F_FILTER);
+	rc |= seed_msgs("smcss", "smcr", &cfg, NL_REC_DIAG, cfg.sock_ext,
+			FUZZ_F_MODE | FUZZ_F_ALL);
+	rc |= seed_msgs("smcss", "smcd", &cfg, NL_REC_DIAG, cfg.sock_ext,
+			FUZZ_F_SMCD | FUZZ_F_DETAIL);
+
+	/* smcd ueid show, smcd seid show, enable and disable */
+	rc |= seed_eid("ueid", "ueid", 0, "SMC-EID.SYSTEM-1", -1);
+	rc |= seed_eid("seid", "enabled", FUZZ_F_MODE, "SEID-1234567890", 1);
+	rc |= seed_eid("seid", "disabled", FUZZ_F_MODE, "SEID-1234567890", 0);
+	rc |= seed_eid("seid", "defined", 0, "SEID-1234567890", 1);
+
+	/* smcr and smcd topology: a whole recording */
+	nl_gen_defaults(&cfg);
+	cfg.what = NL_GEN_ALL;
+	rec = gen_rec(&cfg, &size);
+	rc |= rec ? seed_write("topo", "all", rec, size) : -1;
+	free(rec);
+	cfg.devs = 1;
+	cfg.lgrs = 1;
+	cfg.links = 1;
+	cfg.socks = 2;
+	rec = gen_rec(&cfg, &size);
+	rc |= rec ? seed_write("topo", "small", rec, size) : -1;
+	free(rec);
+
+	/* smcr stats: cache files of older and newer values than the kernel's */
+	rc |= seed_cache("empty-fback", 1000, 0);
+	rc |= seed_cache("fback", 1000, 3);
+	rc |= seed_cache("newer", 1ULL << 62, SMC_MAX_FBACK_RSN_CNT);
+
+	return rc ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,46 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Fuzz harness for handle_inventory_reply(): the device dumps of smcr and
+ * smcd device, and the system info kept for smcr info
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include "dev.c"
+#include "fuzz_nl.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	int flags, i;
+
+	if (!size)
+		return 0;
+	flags = data[0];
+	d_level = flags & (FUZZ_F_DETAIL | FUZZ_F_DETAIL2);
+	/* smcr device [ibdev mlx5_0 | netdev eth0] */
+	target_ibdev[0] = '\0';
+	target_ndev[0] = '\0';
+	if ((flags & FUZZ_F_FILTER) && (flags & FUZZ_F_MODE))
+		snprintf(target_ndev, sizeof(target_ndev), "eth0");
+	else if (flags & FUZZ_F_FILTER)
+		snprintf(target_ibdev, sizeof(target_ibdev), "mlx5_0");
+	fuzz_genl(data + 1, size - 1, handle_inventory_reply, NULL);
+
+	/* like invoke_devs() */
+	if (flags & FUZZ_F_SMCD) {
+		for (i = 0; i < inventory.nsmcd; i++)
+			show_dev_smcd_info(&inventory.smcd[i]);
+	} else {
+		for (i = 0; i < inventory.nsmcr; i++)
+			show_dev_smcr_info(&inventory.smcr[i]);
+	}
+	inventory_clear(SMC_INV_SMCR | SMC_INV_SMCD | SMC_INV_SYS);
+
+	return 0;
+}
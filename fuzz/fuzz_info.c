@@ -0,0 +1,33 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Fuzz harness for handle_gen_info_reply(): smcr and smcd info
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include "info.c"
+#include "fuzz_nl.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	int flags;
+
+	if (!size)
+		return 0;
+	flags = data[0];
+	show_cmd = 1;
+	/* the device counts select the hardware lines */
+	ism_count = !!(flags & FUZZ_F_SMCD);
+	rocev1_count = !!(flags & FUZZ_F_DETAIL);
+	rocev2_count = !!(flags & FUZZ_F_DETAIL2);
+	rocev3_count = !!(flags & FUZZ_F_MODE);
+	fuzz_genl(data + 1, size - 1, handle_gen_info_reply, NULL);
+
+	return 0;
+}
@@ -0,0 +1,42 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Fuzz harness for handle_gen_lgr_reply(): smcr and smcd linkgroup, with
+ * link-show (FUZZ_F_MODE), details and filters
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include "linkgroup.c"
+#include "fuzz_nl.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	int flags;
+
+	if (!size)
+		return 0;
+	flags = data[0];
+	lgr_smcd = !!(flags & FUZZ_F_SMCD);
+	lgr_smcr = !lgr_smcd;
+	show_links = lgr_smcr && (flags & FUZZ_F_MODE);
+	d_level = flags & (FUZZ_F_DETAIL | FUZZ_F_DETAIL2);
+	/* smcr linkgroup [link-show] {00000100 | ibdev mlx5_0} */
+	unmasked_trgt_lgid = 0;
+	target_lgid = 0;
+	target_ibdev[0] = '\0';
+	if ((flags & FUZZ_F_FILTER) && show_links && (flags & FUZZ_F_WIDE)) {
+		snprintf(target_ibdev, sizeof(target_ibdev), "mlx5_0");
+	} else if (flags & FUZZ_F_FILTER) {
+		unmasked_trgt_lgid = 0x100;
+		target_lgid = unmasked_trgt_lgid & SMC_MASK_LINK_ID;
+	}
+	fuzz_genl(data + 1, size - 1, handle_gen_lgr_reply, NULL);
+
+	return 0;
+}
@@ -0,0 +1,249 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Driver for the fuzz harnesses without libFuzzer, e.g. built with gcc or
+ * afl-gcc: runs the harness on each input file, or on each file of an input
+ * directory, then on -runs=N random mutations of these inputs. Takes the
+ * libFuzzer options that fuzz/run_fuzz uses, so that either build runs the
+ * same way. The input that makes a sanitizer fail is written to crash-<run>,
+ * after the -artifact_prefix.
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "fuzz.h"
+
+#define FUZZ_MAX_LEN	(64 * 1024)
+
+struct fuzz_input {
+	uint8_t	*data;
+	size_t	size;
+};
+
+static struct fuzz_input *inputs;
+static int ninputs;
+static uint8_t *cur;		/* input of the current run */
+static size_t cur_size;
+static unsigned long cur_run;
+static const char *artifact_prefix = "";
+
+/* provided by the sanitizer runtimes, if linked */
+extern void __sanitizer_set_death_callback(void (*callback)(void))
+	__attribute__((weak));
+
+static void save_crash(void)
+{
+	char fname[4096];
+	FILE *fp;
+
+	snprintf(fname, sizeof(fname), "%scrash-%lu", artifact_prefix, cur_run);
+	fp = fopen(fname, "w");
+	if (!fp)
+		return;
+	fwrite(cur, 1, cur_size, fp);
+	fclose(fp);
+	fprintf(stderr, "Input written to %s\n", fname);
+}
+
+static int load_file(const char *fname)
+{
+	struct fuzz_input *tmp;
+	uint8_t *data;
+	long size;
+	FILE *fp;
+
+	fp = fopen(fname, "r");
+	if (!fp || fseek(fp, 0, SEEK_END) || (size = ftell(fp)) < 0 ||
+	    fseek(fp, 0, SEEK_SET))
+		goto errout;
+	data = malloc(size + 1);
+	if (!data || (size && fread(data, size, 1, fp) != 1))
+		goto errout;
+	fclose(fp);
+	tmp = realloc(inputs, (ninputs + 1) * sizeof(*inputs));
+	if (!tmp)
+		return -1;
+	inputs = tmp;
+	inputs[ninputs].data = data;
+	inputs[ninputs++].size = size;
+
+	return 0;
+errout:
+	fprintf(stderr, "Error: Cannot read %s\n", fname);
+	if (fp)
+		fclose(fp);
+	return -1;
+}
+
+static int load(const char *path)
+{
+	char fname[4096];
+	struct dirent *de;
+	struct stat st;
+	DIR *dir;
+	int rc = 0;
+
+	if (stat(path, &st)) {
+		fprintf(stderr, "Error: Cannot access %s\n", path);
+		return -1;
+	}
+	if (!S_ISDIR(st.st_mode))
+		return load_file(path);
+	dir = opendir(path);
+	if (!dir)
+		return -1;
+	while (!rc && (de = readdir(dir))) {
+		if (de->d_name[0] == '.')
+			continue;
+		snprintf(fname, sizeof(fname), "%s/%s", path, de->d_name);
+		rc = load_file(fname);
+	}
+	closedir(dir);
+
+	return rc;
+}
+
+/* in a buffer of its own size, like libFuzzer does */
+static void run(const uint8_t *data, size_t size)
+{
+	cur = malloc(size ? size : 1);
+	if (!cur)
+		return;
+	memcpy(cur, data, size);
+	cur_size = size;
+	LLVMFuzzerTestOneInput(cur, size);
+	free(cur);
+}
+
+/* Mutate buf, holding *size bytes of at most max, in place */
+static void mutate(uint8_t *buf, size_t *size, size_t max)
+{
+	static const uint32_t magic[] = { 0, 1, 2, 3, 4, 0x7f, 0x80, 0xff,
+					  0x7fff, 0xffff, 0x7fffffff,
+					  0xffffffff };
+	size_t n = *size, pos, len;
+	struct fuzz_input *o;
+	uint32_t val;
+	int i, k;
+
+	for (k = rand() % 4; k >= 0; k--) {
+		pos = n ? (size_t)rand() % n : 0;
+		switch (rand() % 8) {
+		case 0:		/* flip a bit */
+			if (n)
+				buf[pos] ^= 1 << (rand() % 8);
+			break;
+		case 1:		/* random byte */
+			if (n)
+				buf[pos] = rand();
+			break;
+		case 2:		/* special value, e.g. a length */
+			val = magic[rand() % (sizeof(magic) / sizeof(magic[0]))];
+			len = 1 << (rand() % 3);
+			if (pos + len <= n)
+				memcpy(buf + pos, &val, len);
+			break;
+		case 3:		/* erase bytes */
+			len = rand() % 16 + 1;
+			if (pos + len <= n) {
+				memmove(buf + pos, buf + pos + len, n - pos - len);
+				n -= len;
+			}
+			break;
+		case 4:		/* insert bytes */
+			len = rand() % 16 + 1;
+			if (n + len <= max) {
+				memmove(buf + pos + len, buf + pos, n - pos);
+				for (i = 0; i < (int)len; i++)
+					buf[pos + i] = rand();
+				n += len;
+			}
+			break;
+		case 5:		/* truncate */
+			n = pos;
+			break;
+		case 7:		/* small value, e.g. a shorter length */
+			val = rand() % 256;
+			len = 1 << (rand() % 3);
+			if (pos + len <= n)
+				memcpy(buf + pos, &val, len);
+			break;
+		case 6:		/* copy a chunk of another input */
+			o = &inputs[rand() % ninputs];
+			if (!o->size)
+				break;
+			len = rand() % o->size + 1;
+			if (pos + len > max)
+				len = max - pos;
+			memcpy(buf + pos, o->data + o->size - len, len);
+			if (pos + len > n)
+				n = pos + len;
+			break;
+		}
+	}
+	*size = n;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long runs = 0, seed = 1;
+	size_t max = FUZZ_MAX_LEN, size;
+	struct fuzz_input *in;
+	uint8_t *buf;
+	int i;
+
+	if (LLVMFuzzerInitialize(&argc, &argv))
+		return EXIT_FAILURE;
+	if (__sanitizer_set_death_callback)
+		__sanitizer_set_death_callback(save_crash);
+	for (i = 1; i < argc; i++) {
+		if (!strncmp(argv[i], "-runs=", 6))
+			runs = strtoul(argv[i] + 6, NULL, 0);
+		else if (!strncmp(argv[i], "-seed=", 6))
+			seed = strtoul(argv[i] + 6, NULL, 0);
+		else if (!strncmp(argv[i], "-max_len=", 9))
+			max = strtoul(argv[i] + 9, NULL, 0);
+		else if (!strncmp(argv[i], "-artifact_prefix=", 17))
+			artifact_prefix = argv[i] + 17;
+		else if (argv[i][0] == '-')
+			continue;	/* other libFuzzer options */
+		else if (load(argv[i]))
+			return EXIT_FAILURE;
+	}
+	if (!ninputs) {
+		fprintf(stderr, "Usage: %s [ -runs=N ] [ -seed=N ] [ -max_len=N ] FILE|DIR...\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	for (i = 0; i < ninputs; i++)
+		run(inputs[i].data, inputs[i].size);
+	if (!runs)
+		return EXIT_SUCCESS;
+
+	buf = malloc(max);
+	if (!buf)
+		return EXIT_FAILURE;
+	srand(seed);
+	for (cur_run = 1; cur_run <= runs; cur_run++) {
+		in = &inputs[rand() % ninputs];
+		size = in->size < max ? in->size : max;
+		memcpy(buf, in->data, size);
+		mutate(buf, &size, max);
+		run(buf, size);
+	}
+	fprintf(stderr, "Done %lu runs on %d inputs\n", runs, ninputs);
+	free(buf);
+
+	return EXIT_SUCCESS;
+}
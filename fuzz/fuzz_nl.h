@@ -0,0 +1,115 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Netlink message framing for the fuzz harnesses, included after the
+ * handlers' source file
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#ifndef FUZZ_NL_H_
+#define FUZZ_NL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fuzz.h"
+
+/* Split data into netlink messages like the receive loops do, and hand each
+ * message other than the control messages to handler, in a buffer of its
+ * own size so that the sanitizers catch any read past its end. Stops when
+ * handler returns NL_STOP, like the dump would.
+ */
+static void fuzz_nl_each(const uint8_t *data, size_t size,
+			 int (*handler)(struct nlmsghdr *nlh, void *arg),
+			 void *arg)
+{
+	struct nlmsghdr *buf, *h, *copy;
+	int len = size, rc;
+
+	if (!size || size > 1 << 20)
+		return;
+	/* aligned, like a receive buffer */
+	buf = malloc(size);
+	if (!buf)
+		return;
+	memcpy(buf, data, size);
+	for (h = buf; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+		if (h->nlmsg_type < NLMSG_MIN_TYPE)
+			continue;
+		copy = malloc(h->nlmsg_len);
+		if (!copy)
+			break;
+		memcpy(copy, h, h->nlmsg_len);
+		rc = handler(copy, arg);
+		free(copy);
+		if (rc == NL_STOP)
+			break;
+	}
+	free(buf);
+}
+
+struct fuzz_genl {
+	int	(*cb_handler)(struct nl_msg *msg, void *arg);
+	void	*arg;
+};
+
+static inline int fuzz_genl_one(struct nlmsghdr *nlh, void *arg)
+{
+	struct fuzz_genl *g = arg;
+	struct nl_msg *msg;
+	int rc;
+
+	msg = nlmsg_convert(nlh);
+	if (!msg)
+		return NL_STOP;
+	rc = g->cb_handler(msg, g->arg);
+	nlmsg_free(msg);
+
+	return rc;
+}
+
+/* Run a generic netlink reply handler on the messages in data */
+static inline void fuzz_genl(const uint8_t *data, size_t size,
+			     int (*cb_handler)(struct nl_msg *msg, void *arg),
+			     void *arg)
+{
+	struct fuzz_genl g = { .cb_handler = cb_handler, .arg = arg };
+
+	fuzz_nl_each(data, size, fuzz_genl_one, &g);
+}
+
+struct fuzz_diag {
+	void	(*handler)(struct nlmsghdr *nlh);
+};
+
+static inline int fuzz_diag_one(struct nlmsghdr *nlh, void *arg)
+{
+	((struct fuzz_diag *)arg)->handler(nlh);
+	return NL_OK;
+}
+
+/* Run a sock_diag dump handler on the messages in data */
+static inline void fuzz_diag(const uint8_t *data, size_t size,
+			     void (*handler)(struct nlmsghdr *nlh))
+{
+	struct fuzz_diag d = { .handler = handler };
+
+	fuzz_nl_each(data, size, fuzz_diag_one, &d);
+}
+
+/* The output is not checked, but still formatted */
+int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+	if (!freopen("/dev/null", "w", stdout))
+		return -1;
+	return 0;
+}
+
+#endif /* FUZZ_NL_H_ */
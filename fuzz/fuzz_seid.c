@@ -0,0 +1,32 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Fuzz harness for handle_gen_seid_reply() and is_seid_defined_reply():
+ * smcd seid show (FUZZ_F_MODE), enable and disable
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include "seid.c"
+#include "fuzz_nl.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	int is_seid;
+
+	if (!size)
+		return 0;
+	if (data[0] & FUZZ_F_MODE) {
+		show_cmd = 1;
+		fuzz_genl(data + 1, size - 1, handle_gen_seid_reply, NULL);
+	} else {
+		fuzz_genl(data + 1, size - 1, is_seid_defined_reply, &is_seid);
+	}
+
+	return 0;
+}
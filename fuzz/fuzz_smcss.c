@@ -0,0 +1,36 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Fuzz harness for show_one_smc_sock(): smcss with its display options
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#define main smcss_main
+#include "smcss.c"
+#undef main
+#include "fuzz_nl.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	int flags;
+
+	if (!size)
+		return 0;
+	flags = data[0];
+	/* -d, -a, -l, -W, -R or -D */
+	show_debug = !!(flags & (FUZZ_F_DETAIL | FUZZ_F_DETAIL2));
+	all = !!(flags & FUZZ_F_ALL);
+	listening = !!(flags & FUZZ_F_FILTER);
+	show_wide = !!(flags & FUZZ_F_WIDE);
+	show_smcd = !!(flags & FUZZ_F_SMCD);
+	show_smcr = !show_smcd && (flags & FUZZ_F_MODE);
+	fuzz_diag(data + 1, size - 1, show_one_smc_sock);
+
+	return 0;
+}
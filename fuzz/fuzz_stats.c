@@ -0,0 +1,41 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Fuzz harness for handle_gen_stats_reply(): smcr and smcd stats, as text
+ * or as json (FUZZ_F_MODE)
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include "stats.c"
+#include "fuzz_nl.h"
+
+/* for the syslog of smcr stats -w */
+char *myname = "smcr";
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	int flags;
+
+	if (!size)
+		return 0;
+	flags = data[0];
+	is_smcd = !!(flags & FUZZ_F_SMCD);
+	d_level = flags & (FUZZ_F_DETAIL | FUZZ_F_DETAIL2);
+	is_abs = !!(flags & FUZZ_F_ALL);
+	memset(&smc_stat, 0, sizeof(smc_stat));
+	memset(&smc_rsn, 0, sizeof(smc_rsn));
+	fuzz_genl(data + 1, size - 1, handle_gen_stats_reply, NULL);
+
+	if (flags & FUZZ_F_MODE)
+		print_as_json();
+	else
+		print_as_text();
+
+	return 0;
+}
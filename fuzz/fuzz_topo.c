@@ -0,0 +1,57 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Fuzz harness for the replay of a recording: smcr and smcd topology, which
+ * runs the device, link group, link and socket dumps
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#include "libnetlink.c"
+#include "topology.c"
+#include "fuzz.h"
+
+int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+	unsetenv("SMC_NL_RECORD");
+	if (!freopen("/dev/null", "w", stdout))
+		return -1;
+	return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+	struct topology *topo;
+	struct timespec ts;
+	char *buf;
+
+	if (size > 1 << 20)
+		return 0;
+	buf = malloc(size + 1);
+	if (!buf)
+		return 0;
+	memcpy(buf, data, size);
+	if (nl_replay_parse(buf, size))
+		goto out;
+	nl_replay_on = 1;
+	dev_inventory_reset();
+	if (nl_sample(0, 0, &ts))
+		goto out;
+	d_level = 1;
+	topo = topology_build(1, 1, TOPO_SOCK_CONNINFO);
+	if (topo) {
+		print_topo_text(topo);
+		print_topo_json(topo);
+		topology_free(topo);
+	}
+out:
+	nl_replay_cnt = 0;
+	free(buf);
+
+	return 0;
+}
@@ -73,7 +73,7 @@ static int handle_gen_info_reply(struct nl_msg *msg, void *arg)
 	if (!attrs[SMC_GEN_SYS_INFO])
 		return rc;
 
-	if (nla_parse_nested(info_attrs, SMC_NLA_DEV_MAX,
+	if (nla_parse_nested(info_attrs, SMC_NLA_SYS_MAX,
 			     attrs[SMC_GEN_SYS_INFO],
 			     smc_gen_info_policy)) {
 		fprintf(stderr, "Error: Failed to parse nested attributes: smc_gen_info_policy\n");
@@ -93,7 +93,7 @@ static int handle_gen_info_reply(struct nl_msg *msg, void *arg)
 	/* Hostname */
 	tmp[0] = '\0';
 	if (info_attrs[SMC_NLA_SYS_LOCAL_HOST]) {
-		sprintf(tmp, "%s", nla_get_string(info_attrs[SMC_NLA_SYS_LOCAL_HOST]));
+		snprintf(tmp, sizeof(tmp), "%s", nla_get_string(info_attrs[SMC_NLA_SYS_LOCAL_HOST]));
 	}
 	printf("SMC Hostname:     %s\n", (tmp[0] != '\0' ? tmp : "n/a"));
 
@@ -117,7 +117,7 @@ static int handle_gen_info_reply(struct nl_msg *msg, void *arg)
 	/* SEID */
 	tmp[0] = '\0';
 	if (info_attrs[SMC_NLA_SYS_SEID]) {
-		sprintf(tmp, "%s", nla_get_string(info_attrs[SMC_NLA_SYS_SEID]));
+		snprintf(tmp, sizeof(tmp), "%s", nla_get_string(info_attrs[SMC_NLA_SYS_SEID]));
 	}
 	printf("SEID:             %s\n", (tmp[0] != '\0' ? tmp : "n/a"));
 
@@ -175,11 +175,18 @@ static void handle_cmd_params(int argc, char **argv)
 
 int invoke_info(int argc, char **argv, int detail_level)
 {
+	struct smc_dev_inventory *inv;
 	int rc = EXIT_SUCCESS;
 
 	handle_cmd_params(argc, argv);
 
 	if (show_cmd) {
+		/* devices and system info in one round */
+		inv = dev_inventory_get(SMC_INV_SMCR | SMC_INV_SMCD | SMC_INV_SYS);
+		if (!inv) {
+			fprintf(stderr, "Error: Failed to retrieve device inventory\n");
+			return EXIT_FAILURE;
+		}
 		if (dev_count_ism_devices(&ism_count)) {
 			fprintf(stderr, "Error: Failed to retrieve ISM device count\n");
 			return EXIT_FAILURE;
@@ -189,7 +196,8 @@ int invoke_info(int argc, char **argv, int detail_level)
 			return EXIT_FAILURE;
 		}
 
-		rc = gen_nl_handle_dump(SMC_NETLINK_GET_SYS_INFO, handle_gen_info_reply, NULL);
+		if (inv->sys_info)
+			handle_gen_info_reply(inv->sys_info, NULL);
 	} else {
 		printf("Error: Unknown command\n"); /* we should never come here ... */
 		return EXIT_FAILURE;
@@ -24,9 +24,13 @@
 #include <time.h>
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
+#ifdef SMC_NL_RAW
+#include <linux/genetlink.h>
+#else
 #include <netlink/socket.h>
 #include <netlink/msg.h>
 #include <netlink/genl/ctrl.h>
+#endif
 
 #include "smctools_common.h"
 #include "libnetlink.h"
@@ -34,7 +38,255 @@
 #define MAGIC_SEQ 123456
 
 int smc_id = 0;
+#ifdef SMC_NL_RAW
+static int gen_fd = -1;
+static __u32 gen_seq;
+/* single receive buffer for all generic netlink replies */
+static long gen_buf[32768 / sizeof(long)];
+#else
 struct nl_sock *sk;
+#endif
+
+/* Record and replay of netlink replies
+ *
+ * With SMC_NL_RECORD=<file> set, every reply received on the generic netlink
+ * and sock_diag sockets is appended to <file>, tagged with the command (or the
+ * sock_diag extensions) of its request. With SMC_NL_REPLAY=<file> set, no
+ * socket is opened and the requests are answered from such a file instead, in
+ * recorded order per command. This allows running the tools on systems without
+ * SMC hardware.
+ *
+ * Repeated runs of a command are separated by sample marks, see nl_sample().
+ * A replay answers from one sample only, the first one by default. The file
+ * format is in libnetlink.h.
+ */
+struct nl_rec {
+	struct nl_rec_hdr	*hdr;
+	struct nlmsghdr		*nlh;
+	int			used;
+};
+
+static FILE *nl_rec_fp;
+static int nl_rec_checked;
+static struct nl_rec *nl_replay;
+static char *nl_replay_msgs;	/* 8 byte aligned, like in a receive buffer */
+static int nl_replay_cnt;
+static int nl_replay_on = -1;	/* not checked yet */
+static int nl_replay_start;	/* first record of the current sample */
+static unsigned int nl_replay_sample;
+/* per kind and command of the current sample: the records before next are
+ * used, so that a replay does not search them again for every message
+ */
+#define NL_REPLAY_CURSORS	32
+static struct {
+	__u32	kind;
+	__u32	cmd;
+	int	next;
+} nl_replay_cursor[NL_REPLAY_CURSORS];
+static int nl_replay_ncursors;
+static struct timespec nl_sample_base;
+static unsigned char diag_ext;	/* extensions of the last sock_diag request */
+
+static void nl_record(int kind, int cmd, struct nlmsghdr *nlh)
+{
+	struct nl_rec_hdr hdr = { .kind = kind, .cmd = cmd, .len = nlh->nlmsg_len };
+	char *fname;
+
+	if (!nl_rec_checked) {
+		nl_rec_checked = 1;
+		fname = getenv("SMC_NL_RECORD");
+		if (fname && fname[0]) {
+			nl_rec_fp = fopen(fname, "w");
+			if (!nl_rec_fp)
+				fprintf(stderr, "Error: Cannot open record file %s: %s\n",
+					fname, strerror(errno));
+		}
+	}
+	if (!nl_rec_fp)
+		return;
+	if (fwrite(&hdr, sizeof(hdr), 1, nl_rec_fp) != 1 ||
+	    fwrite(nlh, nlh->nlmsg_len, 1, nl_rec_fp) != 1) {
+		fprintf(stderr, "Error: Cannot write record file\n");
+		fclose(nl_rec_fp);
+		nl_rec_fp = NULL;
+	}
+}
+
+/* Index the records in buf, -1 if it is not a valid recording. The messages
+ * follow the 12 byte record headers, so they are copied to nl_replay_msgs for
+ * the structs of 8 byte alignment, e.g. struct smc_diag_msg. Aligning each
+ * message takes less than the header it drops, so size bytes suffice.
+ */
+static int nl_replay_parse(char *buf, long size)
+{
+	struct nl_rec_hdr *hdr;
+	long off = 0, moff = 0;
+	struct nl_rec *r;
+	int max = 0;
+	char *msgs;
+
+	nl_replay_cnt = 0;
+	msgs = realloc(nl_replay_msgs, size ? size : 1);
+	if (!msgs)
+		return -1;
+	nl_replay_msgs = msgs;
+	while (off < size) {
+		if (size - off < (long)sizeof(*hdr))
+			return -1;
+		hdr = (struct nl_rec_hdr *)(buf + off);
+		off += sizeof(*hdr);
+		/* netlink messages are padded, so the next header is aligned */
+		if (hdr->len < NLMSG_HDRLEN || hdr->len > size - off ||
+		    hdr->len != NLMSG_ALIGN(hdr->len) ||
+		    ((struct nlmsghdr *)(buf + off))->nlmsg_len != hdr->len)
+			return -1;
+		if (hdr->kind == NL_REC_MARK &&
+		    hdr->len < sizeof(struct nl_rec_mark))
+			return -1;
+		if (nl_replay_cnt == max) {
+			max = max ? 2 * max : 256;
+			r = realloc(nl_replay, max * sizeof(*r));
+			if (!r)
+				return -1;
+			nl_replay = r;
+		}
+		r = &nl_replay[nl_replay_cnt++];
+		r->hdr = hdr;
+		r->nlh = (struct nlmsghdr *)(msgs + moff);
+		memcpy(r->nlh, buf + off, hdr->len);
+		r->used = 0;
+		off += hdr->len;
+		moff += (hdr->len + 7) & ~7;
+	}
+	return 0;
+}
+
+static void nl_replay_load(const char *fname)
+{
+	char *buf = NULL;
+	long size;
+	FILE *fp;
+
+	fp = fopen(fname, "r");
+	if (!fp || fseek(fp, 0, SEEK_END) || (size = ftell(fp)) < 0 ||
+	    fseek(fp, 0, SEEK_SET))
+		goto errout;
+	buf = malloc(size + 1);
+	if (!buf || (size && fread(buf, size, 1, fp) != 1))
+		goto errout;
+	if (nl_replay_parse(buf, size))
+		goto errout;
+	fclose(fp);
+	return;
+errout:
+	fprintf(stderr, "Error: Cannot read replay file %s\n", fname);
+	exit(EXIT_FAILURE);
+}
+
+static int nl_replay_active(void)
+{
+	char *fname;
+
+	if (nl_replay_on < 0) {
+		fname = getenv("SMC_NL_REPLAY");
+		nl_replay_on = fname && fname[0];
+		if (nl_replay_on)
+			nl_replay_load(fname);
+	}
+	return nl_replay_on;
+}
+
+/* Next unused recorded message for a request in the current sample, NULL if
+ * there is none left
+ */
+static struct nlmsghdr *nl_replay_next(int kind, int cmd)
+{
+	int i, c;
+
+	for (c = 0; c < nl_replay_ncursors; c++) {
+		if (nl_replay_cursor[c].kind == (__u32)kind &&
+		    nl_replay_cursor[c].cmd == (__u32)cmd)
+			break;
+	}
+	if (c == nl_replay_ncursors && c < NL_REPLAY_CURSORS) {
+		nl_replay_cursor[c].kind = kind;
+		nl_replay_cursor[c].cmd = cmd;
+		nl_replay_cursor[c].next = nl_replay_start;
+		nl_replay_ncursors++;
+	}
+	i = c < nl_replay_ncursors ? nl_replay_cursor[c].next : nl_replay_start;
+	for (; i < nl_replay_cnt; i++) {
+		if (nl_replay[i].hdr->kind == NL_REC_MARK &&
+		    nl_replay[i].hdr->cmd > nl_replay_sample)
+			break;
+		if (!nl_replay[i].used && nl_replay[i].hdr->kind == (__u32)kind &&
+		    nl_replay[i].hdr->cmd == (__u32)cmd) {
+			nl_replay[i].used = 1;
+			if (c < nl_replay_ncursors)
+				nl_replay_cursor[c].next = i + 1;
+			return nl_replay[i].nlh;
+		}
+	}
+	return NULL;
+}
+
+/* Start sample n of a series taken every interval seconds: wait for its time,
+ * and mark its start in the record file with the wall clock time, returned in
+ * ts. On replay, switch to the recorded sample n without waiting, and return
+ * its recorded time. Returns -1 if the replay file has no sample n.
+ */
+int nl_sample(unsigned int n, unsigned int interval, struct timespec *ts)
+{
+	struct nl_rec_mark mark = {
+		.nlh = {
+			.nlmsg_type = NLMSG_NOOP,
+			.nlmsg_len = sizeof(mark),
+		},
+	};
+	struct timespec t;
+	int i;
+
+	if (nl_replay_active()) {
+		clock_gettime(CLOCK_REALTIME, ts);
+		for (i = 0; i < nl_replay_cnt; i++) {
+			if (nl_replay[i].hdr->kind == NL_REC_MARK &&
+			    nl_replay[i].hdr->cmd == n)
+				break;
+		}
+		if (i == nl_replay_cnt) {
+			/* recordings without marks hold a single sample */
+			if (n)
+				return -1;
+			i = 0;
+		} else {
+			memcpy(&mark, nl_replay[i].nlh, sizeof(mark));
+			ts->tv_sec = mark.sec;
+			ts->tv_nsec = mark.nsec;
+		}
+		nl_replay_start = i;
+		nl_replay_sample = n;
+		nl_replay_ncursors = 0;
+		return 0;
+	}
+
+	if (!n) {
+		clock_gettime(CLOCK_MONOTONIC, &nl_sample_base);
+	} else {
+		t.tv_sec = nl_sample_base.tv_sec + (time_t)n * interval;
+		t.tv_nsec = nl_sample_base.tv_nsec;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR)
+			;
+	}
+	clock_gettime(CLOCK_REALTIME, ts);
+	mark.sec = ts->tv_sec;
+	mark.nsec = ts->tv_nsec;
+	nl_record(NL_REC_MARK, n, &mark.nlh);
+	/* the previous samples are complete */
+	if (nl_rec_fp)
+		fflush(nl_rec_fp);
+
+	return 0;
+}
 
 /* Operations on sock_diag netlink socket */
 
@@ -44,6 +296,11 @@ int rtnl_open(struct rtnl_handle *rth)
 	int rcvbuf = 1024 * 1024;
 	int sndbuf = 32768;
 
+	if (nl_replay_active()) {
+		memset(rth, 0, sizeof(*rth));
+		rth->fd = -1;
+		return 0;
+	}
 	rth->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC,
 			 NETLINK_SOCK_DIAG);
 	if (rth->fd < 0) {
@@ -110,6 +367,25 @@ int rtnl_dump(struct rtnl_handle *rth, void (*handler)(struct nlmsghdr *nlh))
 	char buf[32768];
 	struct nlmsghdr *h = (struct nlmsghdr *)buf;
 
+	if (nl_replay_active()) {
+		while ((h = nl_replay_next(NL_REC_DIAG, diag_ext))) {
+			if (h->nlmsg_type == NLMSG_DONE)
+				return EXIT_SUCCESS;
+			if (h->nlmsg_type == NLMSG_ERROR) {
+				struct nlmsgerr *err = NLMSG_DATA(h);
+
+				if (h->nlmsg_len < NLMSG_LENGTH(sizeof(*err)))
+					break;
+				fprintf(stderr, "RTNETLINK answers: %s\n",
+					strerror(-err->error));
+				return EXIT_FAILURE;
+			}
+			(*handler)(h);
+		}
+		fprintf(stderr, "Error: No recorded sock_diag reply\n");
+		return EXIT_FAILURE;
+	}
+
 	memset(buf, 0, sizeof(buf));
 	iov.iov_base = buf;
 	iov.iov_len = sizeof(buf);
@@ -131,6 +407,7 @@ again:
 		if (h->nlmsg_flags & NLM_F_DUMP_INTR)
 			fprintf(stderr, "Error: Dump interrupted\n");
 		if (h->nlmsg_type == NLMSG_DONE) {
+			nl_record(NL_REC_DIAG, diag_ext, h);
 			found_done = 1;
 			break;
 		}
@@ -138,10 +415,12 @@ again:
 			if (h->nlmsg_len < NLMSG_LENGTH(sizeof(struct nlmsgerr))) {
 				fprintf(stderr, "Error: Incomplete message\n");
 			} else {
+				nl_record(NL_REC_DIAG, diag_ext, h);
 				perror("RTNETLINK answers");
 			}
 			return EXIT_FAILURE;
 		}
+		nl_record(NL_REC_DIAG, diag_ext, h);
 		(*handler)(h);
 		h = NLMSG_NEXT(h, msglen);
 	}
@@ -168,8 +447,10 @@ void parse_rtattr(struct rtattr *tb[], int max, struct rtattr *rta,
 			tb[type] = rta;
 		rta = RTA_NEXT(rta,len);
 	}
-	if (len)
+	if (len >= (int)sizeof(*rta))
 		fprintf(stderr, "Error: Deficit %d, rta_len=%d\n", len, rta->rta_len);
+	else if (len)
+		fprintf(stderr, "Error: Deficit %d\n", len);
 }
 
 int sockdiag_send(int fd, unsigned char cmd)
@@ -196,6 +477,9 @@ int sockdiag_send(int fd, unsigned char cmd)
 	};
 
 	req.r.diag_ext = cmd;
+	diag_ext = cmd;
+	if (nl_replay_active())
+		return 0;
 
 	if (sendmsg(fd, &msg, 0) < 0) {
 		close(fd);
@@ -207,10 +491,13 @@ int sockdiag_send(int fd, unsigned char cmd)
 
 /* Operations on generic netlink sockets */
 
+#ifndef SMC_NL_RAW
 int gen_nl_open(void)
 {
 	int rc = EXIT_FAILURE;
 
+	if (nl_replay_active())
+		return EXIT_SUCCESS;
 	/* Allocate a netlink socket and connect to it */
 	sk = nl_socket_alloc();
 	if (!sk) {
@@ -223,6 +510,13 @@ int gen_nl_open(void)
 		rc = EXIT_FAILURE;
 		goto err1;
 	}
+	/* room for the replies of a whole batch */
+	rc = nl_socket_set_buffer_size(sk, 1024 * 1024, 0);
+	if (rc) {
+		nl_perror(rc, "Error");
+		rc = EXIT_FAILURE;
+		goto err2;
+	}
 	smc_id = genl_ctrl_resolve(sk, SMC_GENL_FAMILY_NAME);
 	if (smc_id < 0) {
 		rc = EXIT_FAILURE;
@@ -241,66 +535,486 @@ err1:
 	return rc;
 
 }
+#endif
 
-int gen_nl_handle(int cmd, int nlmsg_flags,
-		  int (*cb_handler)(struct nl_msg *msg, void *arg), void *arg)
+/* Generic netlink requests
+ *
+ * gen_nl_batch_run() runs the requests of a batch one after another: it sends
+ * a request and passes its replies to the callback of the request, until
+ * NLMSG_DONE (dumps), the ACK (other requests) or an error. The kernel
+ * rejects a second dump on a socket while one is running, and it builds the
+ * dump in the sendmsg() and recvmsg() calls of the reader anyway, so sending
+ * the next request early saves no round trip.
+ */
+struct gen_nl_batch {
+	struct gen_nl_req	*cur;	/* request in flight */
+};
+
+static struct gen_nl_req *gen_nl_batch_find(struct gen_nl_batch *batch, __u32 seq)
+{
+	if (batch->cur && batch->cur->state == GEN_NL_REQ_SENT &&
+	    batch->cur->seq == seq)
+		return batch->cur;
+	return NULL;
+}
+
+static void gen_nl_batch_done(struct gen_nl_req *req, int err)
+{
+	req->state = GEN_NL_REQ_DONE;
+	req->err = err;
+}
+
+static int gen_nl_batch_valid(struct nl_msg *msg, void *arg)
+{
+	struct gen_nl_batch *batch = (struct gen_nl_batch *)arg;
+	struct gen_nl_req *req;
+
+	req = gen_nl_batch_find(batch, nlmsg_hdr(msg)->nlmsg_seq);
+	if (!req)
+		return NL_SKIP;
+	nl_record(NL_REC_GENL, req->cmd, nlmsg_hdr(msg));
+	if (req->stopped || !req->cb_handler)
+		return NL_SKIP;
+	/* NL_STOP ends the callbacks of this request only */
+	if (req->cb_handler(msg, req->arg) == NL_STOP)
+		req->stopped = 1;
+	return NL_OK;
+}
+
+static int gen_nl_batch_finish(struct nl_msg *msg, void *arg)
 {
+	struct gen_nl_batch *batch = (struct gen_nl_batch *)arg;
+	struct gen_nl_req *req;
+
+	req = gen_nl_batch_find(batch, nlmsg_hdr(msg)->nlmsg_seq);
+	if (req) {
+		nl_record(NL_REC_GENL, req->cmd, nlmsg_hdr(msg));
+		gen_nl_batch_done(req, 0);
+	}
+	return NL_OK;
+}
+
+static void gen_nl_batch_nlerr(struct gen_nl_batch *batch, struct nlmsgerr *e)
+{
+	struct gen_nl_req *req;
+
+	req = gen_nl_batch_find(batch, e->msg.nlmsg_seq);
+	if (!req)
+		return;
+	/* e is the payload of the NLMSG_ERROR message */
+	nl_record(NL_REC_GENL, req->cmd,
+		  (struct nlmsghdr *)((char *)e - NLMSG_HDRLEN));
+	gen_nl_batch_done(req, -nl_syserr2nlerr(e->error));
+}
+
+/* Answer the requests from the replay file */
+static int gen_nl_replay_run(struct gen_nl_req *reqs, int nreqs)
+{
+	int i, rc = EXIT_SUCCESS;
+	struct nlmsgerr *e;
+	struct nlmsghdr *h;
 	struct nl_msg *msg;
-	int rc;
 
-	nl_socket_modify_cb(sk, NL_CB_VALID, NL_CB_CUSTOM, cb_handler, arg);
+	for (i = 0; i < nreqs; i++) {
+		reqs[i].state = GEN_NL_REQ_DONE;
+		reqs[i].stopped = 0;
+		reqs[i].err = -NLE_OBJ_NOTFOUND;	/* nothing recorded */
+		while ((h = nl_replay_next(NL_REC_GENL, reqs[i].cmd))) {
+			if (h->nlmsg_type == NLMSG_DONE) {
+				reqs[i].err = 0;
+				break;
+			}
+			if (h->nlmsg_type == NLMSG_ERROR) {
+				e = NLMSG_DATA(h);
+				reqs[i].err = e->error ? -nl_syserr2nlerr(e->error) : 0;
+				break;
+			}
+			if (reqs[i].stopped || !reqs[i].cb_handler)
+				continue;
+			msg = nlmsg_convert(h);
+			if (!msg) {
+				reqs[i].err = -NLE_NOMEM;
+				break;
+			}
+			if (reqs[i].cb_handler(msg, reqs[i].arg) == NL_STOP)
+				reqs[i].stopped = 1;
+			nlmsg_free(msg);
+		}
+		if (reqs[i].err)
+			rc = EXIT_FAILURE;
+	}
+	return rc;
+}
+
+#ifndef SMC_NL_RAW
+static int gen_nl_batch_error(struct sockaddr_nl *nla, struct nlmsgerr *e, void *arg)
+{
+	gen_nl_batch_nlerr((struct gen_nl_batch *)arg, e);
+	return NL_SKIP;
+}
+
+static int gen_nl_batch_seq_check(struct nl_msg *msg, void *arg)
+{
+	return NL_OK;	/* replies are matched in gen_nl_batch_find() */
+}
+
+static int gen_nl_batch_send(struct gen_nl_batch *batch, struct gen_nl_req *req)
+{
+	struct nl_msg *msg;
+	int rc;
 
-	/* Allocate a netlink message and set header information. */
 	msg = nlmsg_alloc();
-	if (!msg) {
-		nl_perror(NLE_NOMEM, "Error");
-		goto errout;
+	if (!msg)
+		return -NLE_NOMEM;
+	req->seq = nl_socket_use_seq(sk);
+	/* dumps end with NLMSG_DONE, other requests with their ACK */
+	if (!genlmsg_put(msg, NL_AUTO_PORT, req->seq, smc_id, 0,
+			 req->flags | ((req->flags & NLM_F_DUMP) ? 0 : NLM_F_ACK),
+			 req->cmd, SMC_GENL_FAMILY_VERSION)) {
+		rc = -NLE_NOMEM;
+		goto out;
 	}
+	if (req->str && req->str[0]) {
+		rc = nla_put_string(msg, req->attr, req->str);
+		if (rc < 0)
+			goto out;
+	}
+	rc = nl_send_auto(sk, msg);
+	if (rc < 0)
+		goto out;
+	req->state = GEN_NL_REQ_SENT;
+	req->stopped = 0;
+	batch->cur = req;
+	rc = 0;
+out:
+	nlmsg_free(msg);
+	return rc;
+}
 
-	if (!genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, smc_id, 0, nlmsg_flags,
-			 cmd, SMC_GENL_FAMILY_VERSION)) {
-		nl_perror(NLE_NOMEM, "Error");
-		goto errout;
+/* Run all requests, returns EXIT_FAILURE if any of them failed.
+ * The error of each request is left in its err field.
+ */
+int gen_nl_batch_run(struct gen_nl_req *reqs, int nreqs)
+{
+	struct gen_nl_batch batch = { .cur = NULL };
+	int i, rc = EXIT_SUCCESS, err = 0;
+	struct nl_cb *cb;
+
+	if (nl_replay_active())
+		return gen_nl_replay_run(reqs, nreqs);
+	for (i = 0; i < nreqs; i++) {
+		reqs[i].state = GEN_NL_REQ_QUEUED;
+		reqs[i].err = 0;
 	}
+	cb = nl_cb_alloc(NL_CB_DEFAULT);
+	if (!cb) {
+		err = -NLE_NOMEM;
+		goto out;
+	}
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, gen_nl_batch_valid, &batch);
+	nl_cb_set(cb, NL_CB_FINISH, NL_CB_CUSTOM, gen_nl_batch_finish, &batch);
+	nl_cb_set(cb, NL_CB_ACK, NL_CB_CUSTOM, gen_nl_batch_finish, &batch);
+	nl_cb_set(cb, NL_CB_SEQ_CHECK, NL_CB_CUSTOM, gen_nl_batch_seq_check, NULL);
+	nl_cb_err(cb, NL_CB_CUSTOM, gen_nl_batch_error, &batch);
 
-	/* Send message */
-	rc = nl_send_auto(sk, msg);
-	if (rc < 0) {
-		nl_perror(rc, "Error");
+	for (i = 0; i < nreqs; i++) {
+		err = gen_nl_batch_send(&batch, &reqs[i]);
+		if (err)
+			goto out;
+		while (reqs[i].state != GEN_NL_REQ_DONE) {
+			err = nl_recvmsgs(sk, cb);
+			if (err < 0)
+				goto out;
+			err = 0;
+		}
+	}
+out:
+	for (i = 0; i < nreqs; i++) {
+		if (reqs[i].state != GEN_NL_REQ_DONE)
+			reqs[i].err = err;
+		if (reqs[i].err)
+			rc = EXIT_FAILURE;
+	}
+	if (err && batch.cur && batch.cur->state == GEN_NL_REQ_SENT) {
+		/* replies still pending on the socket, start over */
+		gen_nl_close();
+		if (gen_nl_open())
+			exit(EXIT_FAILURE);
+	}
+	if (cb)
+		nl_cb_put(cb);
+	return rc;
+}
+#else
+int gen_nl_open(void)
+{
+	struct sockaddr_nl local = { .nl_family = AF_NETLINK };
+	struct {
+		struct nlmsghdr		nlh;
+		struct genlmsghdr	genl;
+		struct nlattr		nla;
+		char			name[GENL_NAMSIZ];
+	} req = {
+		.nlh = {
+			.nlmsg_type = GENL_ID_CTRL,
+			.nlmsg_flags = NLM_F_REQUEST,
+		},
+		.genl = {
+			.cmd = CTRL_CMD_GETFAMILY,
+			.version = 1,
+		},
+		.nla = {
+			.nla_type = CTRL_ATTR_FAMILY_NAME,
+			.nla_len = NLA_HDRLEN + sizeof(SMC_GENL_FAMILY_NAME),
+		},
+		.name = SMC_GENL_FAMILY_NAME,
+	};
+	struct nlattr *tb[CTRL_ATTR_MAX + 1];
+	int len, rcvbuf = 1024 * 1024;
+	struct nlmsghdr *h;
+
+	if (nl_replay_active())
+		return EXIT_SUCCESS;
+	gen_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+	if (gen_fd < 0) {
+		perror("Error: Cannot open netlink socket");
+		return EXIT_FAILURE;
+	}
+	/* room for the replies of a whole batch */
+	if (setsockopt(gen_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0) {
+		perror("Error: SO_RCVBUF");
 		goto errout;
 	}
+	if (bind(gen_fd, (struct sockaddr *)&local, sizeof(local)) < 0) {
+		perror("Error: Cannot bind netlink socket");
+		goto errout;
+	}
+	gen_seq = time(NULL);
 
-	/* Receive reply message, returns number of cb invocations. */
-	rc = nl_recvmsgs_default(sk);
-	if (rc < 0) {
-		if (rc == -NLE_OPNOTSUPP) {
-			fprintf(stderr, "Error: Operation not supported by kernel\n");
-		} else {
-			nl_perror(rc, "Error");
-		}
+	/* resolve the SMC family id */
+	req.nlh.nlmsg_seq = ++gen_seq;
+	req.nlh.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN) + NLA_ALIGN(req.nla.nla_len);
+	if (send(gen_fd, &req, req.nlh.nlmsg_len, 0) < 0) {
+		perror("Error: Cannot send netlink message");
+		goto errout;
+	}
+	do {
+		len = recv(gen_fd, gen_buf, sizeof(gen_buf), 0);
+	} while (len < 0 && errno == EINTR);
+	h = (struct nlmsghdr *)gen_buf;
+	if (len < 0 || !NLMSG_OK(h, len)) {
+		fprintf(stderr, "Error: Netlink receive error\n");
+		goto errout;
+	}
+	if (h->nlmsg_type == NLMSG_ERROR) {
+		if (h->nlmsg_len >= NLMSG_LENGTH(sizeof(struct nlmsgerr)) &&
+		    ((struct nlmsgerr *)NLMSG_DATA(h))->error == -ENOENT)
+			fprintf(stderr, "Error: SMC module not loaded\n");
+		else
+			fprintf(stderr, "Error: Cannot resolve generic netlink family\n");
+		goto errout;
+	}
+	if (genlmsg_parse(h, 0, tb, CTRL_ATTR_MAX, NULL) < 0 ||
+	    !tb[CTRL_ATTR_FAMILY_ID] || nla_len(tb[CTRL_ATTR_FAMILY_ID]) < 2) {
+		fprintf(stderr, "Error: Cannot resolve generic netlink family\n");
 		goto errout;
 	}
+	smc_id = nla_get_u16(tb[CTRL_ATTR_FAMILY_ID]);
 
-	nlmsg_free(msg);
 	return EXIT_SUCCESS;
-
 errout:
-	nlmsg_free(msg);
+	close(gen_fd);
+	gen_fd = -1;
 	return EXIT_FAILURE;
 }
 
+/* Build the request on the stack, at most one string attribute */
+static int gen_nl_batch_send(struct gen_nl_batch *batch, struct gen_nl_req *req)
+{
+	struct {
+		struct nlmsghdr		nlh;
+		struct genlmsghdr	genl;
+		struct nlattr		nla;
+		char			str[256];
+	} msg;
+	int slen;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.nlh.nlmsg_type = smc_id;
+	msg.nlh.nlmsg_flags = NLM_F_REQUEST | req->flags |
+			      ((req->flags & NLM_F_DUMP) ? 0 : NLM_F_ACK);
+	msg.nlh.nlmsg_seq = req->seq = ++gen_seq;
+	msg.nlh.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+	msg.genl.cmd = req->cmd;
+	msg.genl.version = SMC_GENL_FAMILY_VERSION;
+	if (req->str && req->str[0]) {
+		slen = strlen(req->str) + 1;
+		if (slen > (int)sizeof(msg.str))
+			return -NLE_MSGSIZE;
+		msg.nla.nla_type = req->attr;
+		msg.nla.nla_len = NLA_HDRLEN + slen;
+		memcpy(msg.str, req->str, slen);
+		msg.nlh.nlmsg_len += NLA_ALIGN(msg.nla.nla_len);
+	}
+	if (send(gen_fd, &msg, msg.nlh.nlmsg_len, 0) < 0)
+		return -nl_syserr2nlerr(errno);
+	req->state = GEN_NL_REQ_SENT;
+	req->stopped = 0;
+	batch->cur = req;
+	return 0;
+}
+
+static int gen_nl_batch_recv(struct gen_nl_batch *batch)
+{
+	struct nlmsghdr *h = (struct nlmsghdr *)gen_buf;
+	struct nl_msg msg = { .nm_alloc = 0 };
+	int len;
+
+	do {
+		len = recv(gen_fd, gen_buf, sizeof(gen_buf), 0);
+	} while (len < 0 && errno == EINTR);
+	if (len < 0)
+		return -nl_syserr2nlerr(errno);
+	if (len == 0)
+		return -NLE_FAILURE;
+
+	for (; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+		msg.nm_nlh = h;
+		switch (h->nlmsg_type) {
+		case NLMSG_NOOP:
+		case NLMSG_OVERRUN:
+			break;
+		case NLMSG_DONE:
+			gen_nl_batch_finish(&msg, batch);
+			break;
+		case NLMSG_ERROR:
+			if (h->nlmsg_len < NLMSG_LENGTH(sizeof(struct nlmsgerr)))
+				return -NLE_MSG_TRUNC;
+			if (((struct nlmsgerr *)NLMSG_DATA(h))->error)
+				gen_nl_batch_nlerr(batch, NLMSG_DATA(h));
+			else
+				gen_nl_batch_finish(&msg, batch);	/* ACK */
+			break;
+		default:
+			gen_nl_batch_valid(&msg, batch);
+			break;
+		}
+	}
+	return 0;
+}
+
+/* Run all requests, returns EXIT_FAILURE if any of them failed.
+ * The error of each request is left in its err field.
+ */
+int gen_nl_batch_run(struct gen_nl_req *reqs, int nreqs)
+{
+	struct gen_nl_batch batch = { .cur = NULL };
+	int i, rc = EXIT_SUCCESS, err = 0;
+
+	if (nl_replay_active())
+		return gen_nl_replay_run(reqs, nreqs);
+	for (i = 0; i < nreqs; i++) {
+		reqs[i].state = GEN_NL_REQ_QUEUED;
+		reqs[i].err = 0;
+	}
+	for (i = 0; i < nreqs; i++) {
+		err = gen_nl_batch_send(&batch, &reqs[i]);
+		if (err)
+			goto out;
+		while (reqs[i].state != GEN_NL_REQ_DONE) {
+			err = gen_nl_batch_recv(&batch);
+			if (err)
+				goto out;
+		}
+	}
+out:
+	for (i = 0; i < nreqs; i++) {
+		if (reqs[i].state != GEN_NL_REQ_DONE)
+			reqs[i].err = err;
+		if (reqs[i].err)
+			rc = EXIT_FAILURE;
+	}
+	if (err && batch.cur && batch.cur->state == GEN_NL_REQ_SENT) {
+		/* replies still pending on the socket, start over */
+		gen_nl_close();
+		if (gen_nl_open())
+			exit(EXIT_FAILURE);
+	}
+	return rc;
+}
+#endif
+
+void gen_nl_perror(int err)
+{
+	if (err == -NLE_OPNOTSUPP)
+		fprintf(stderr, "Error: Operation not supported by kernel\n");
+	else
+		nl_perror(err, "Error");
+}
+
+int gen_nl_handle(int cmd, int nlmsg_flags,
+		  int (*cb_handler)(struct nl_msg *msg, void *arg), void *arg)
+{
+	struct gen_nl_req req = {
+		.cmd = cmd,
+		.flags = nlmsg_flags,
+		.cb_handler = cb_handler,
+		.arg = arg,
+	};
+
+	if (gen_nl_batch_run(&req, 1)) {
+		gen_nl_perror(req.err);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
 int gen_nl_handle_dump(int cmd, int (*cb_handler)(struct nl_msg *msg, void *arg), void *arg)
 {
 	return gen_nl_handle(cmd, NLM_F_DUMP, cb_handler, arg);
 }
 
+/* Run the dumps as one batch with a common callback */
+int gen_nl_handle_dumps(const int *cmds, int ncmds,
+			int (*cb_handler)(struct nl_msg *msg, void *arg), void *arg)
+{
+	struct gen_nl_req reqs[GEN_NL_BATCH_MAX] = {0};
+	int i;
+
+	if (ncmds > GEN_NL_BATCH_MAX)
+		return EXIT_FAILURE;
+	for (i = 0; i < ncmds; i++) {
+		reqs[i].cmd = cmds[i];
+		reqs[i].flags = NLM_F_DUMP;
+		reqs[i].cb_handler = cb_handler;
+		reqs[i].arg = arg;
+	}
+	if (gen_nl_batch_run(reqs, ncmds)) {
+		for (i = 0; i < ncmds; i++) {
+			if (reqs[i].err) {
+				gen_nl_perror(reqs[i].err);
+				break;
+			}
+		}
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
 void gen_nl_close()
 {
+#ifdef SMC_NL_RAW
+	if (gen_fd >= 0) {
+		close(gen_fd);
+		gen_fd = -1;
+	}
+#else
 	if (sk) {
 		nl_close(sk);
 		nl_socket_free(sk);
 		sk = NULL;
 	}
+#endif
 }
 
 uint64_t nl_attr_get_uint(const struct nlattr *nla)
@@ -309,3 +1023,195 @@ uint64_t nl_attr_get_uint(const struct nlattr *nla)
 		return nla_get_u32(nla);
 	return nla_get_u64(nla);
 }
+
+#ifdef SMC_NL_RAW
+/* Attribute parsing in place, validating against the nla_policy tables */
+
+static const uint16_t nla_attr_minlen[NLA_TYPE_MAX + 1] = {
+	[NLA_U8]	= sizeof(uint8_t),
+	[NLA_U16]	= sizeof(uint16_t),
+	[NLA_U32]	= sizeof(uint32_t),
+	[NLA_U64]	= sizeof(uint64_t),
+	[NLA_STRING]	= 1,
+	[NLA_NUL_STRING] = 1,
+};
+
+static int nla_ok(const struct nlattr *nla, int remaining)
+{
+	return remaining >= (int)sizeof(*nla) &&
+	       nla->nla_len >= sizeof(*nla) &&
+	       nla->nla_len <= remaining;
+}
+
+static struct nlattr *nla_next(const struct nlattr *nla, int *remaining)
+{
+	int totlen = NLA_ALIGN(nla->nla_len);
+
+	*remaining -= totlen;
+	return (struct nlattr *)((char *)nla + totlen);
+}
+
+static int nla_validate(const struct nlattr *nla, const struct nla_policy *pt)
+{
+	int minlen;
+	char *data;
+
+	if (pt->type > NLA_TYPE_MAX)
+		return 0;
+	minlen = pt->minlen ? pt->minlen : nla_attr_minlen[pt->type];
+	if (nla_len(nla) < minlen)
+		return -NLE_RANGE;
+	if (pt->maxlen && nla_len(nla) > pt->maxlen)
+		return -NLE_RANGE;
+	if (pt->type == NLA_STRING || pt->type == NLA_NUL_STRING) {
+		data = nla_data(nla);
+		if (data[nla_len(nla) - 1] != '\0')
+			return -NLE_INVAL;
+	}
+	return 0;
+}
+
+struct nlattr *nla_find(const struct nlattr *head, int len, int attrtype)
+{
+	const struct nlattr *nla;
+	int rem = len;
+
+	for (nla = head; nla_ok(nla, rem); nla = nla_next(nla, &rem)) {
+		if ((nla->nla_type & NLA_TYPE_MASK) == attrtype)
+			return (struct nlattr *)nla;
+	}
+	return NULL;
+}
+
+int nla_parse(struct nlattr *tb[], int maxtype, struct nlattr *head, int len,
+	      const struct nla_policy *policy)
+{
+	struct nlattr *nla;
+	int rem = len, type, rc;
+
+	memset(tb, 0, sizeof(struct nlattr *) * (maxtype + 1));
+	for (nla = head; nla_ok(nla, rem); nla = nla_next(nla, &rem)) {
+		type = nla->nla_type & NLA_TYPE_MASK;
+		if (type > maxtype)
+			continue;
+		if (policy) {
+			rc = nla_validate(nla, &policy[type]);
+			if (rc < 0)
+				return rc;
+		}
+		tb[type] = nla;
+	}
+	return 0;
+}
+
+int nla_parse_nested(struct nlattr *tb[], int maxtype, struct nlattr *nla,
+		     const struct nla_policy *policy)
+{
+	return nla_parse(tb, maxtype, nla_data(nla), nla_len(nla), policy);
+}
+
+int genlmsg_parse(struct nlmsghdr *nlh, int hdrlen, struct nlattr *tb[],
+		  int maxtype, const struct nla_policy *policy)
+{
+	int offset = NLMSG_LENGTH(GENL_HDRLEN + NLMSG_ALIGN(hdrlen));
+
+	if (nlh->nlmsg_len < (__u32)offset)
+		return -NLE_MSG_TOOSHORT;
+	return nla_parse(tb, maxtype, (struct nlattr *)((char *)nlh + offset),
+			 nlh->nlmsg_len - offset, policy);
+}
+
+struct nl_msg *nlmsg_convert(struct nlmsghdr *hdr)
+{
+	struct nl_msg *msg;
+
+	msg = malloc(sizeof(*msg) + hdr->nlmsg_len);
+	if (!msg)
+		return NULL;
+	msg->nm_nlh = (struct nlmsghdr *)(msg + 1);
+	msg->nm_alloc = 1;
+	memcpy(msg->nm_nlh, hdr, hdr->nlmsg_len);
+	return msg;
+}
+
+void nlmsg_free(struct nl_msg *msg)
+{
+	if (msg && msg->nm_alloc)
+		free(msg);
+}
+
+void nl_msg_dump(struct nl_msg *msg, FILE *ofd)
+{
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	unsigned char *data = (unsigned char *)nlh;
+	__u32 i;
+
+	fprintf(ofd, "--- netlink message: len %u type %u flags %#x seq %u pid %u\n",
+		nlh->nlmsg_len, nlh->nlmsg_type, nlh->nlmsg_flags,
+		nlh->nlmsg_seq, nlh->nlmsg_pid);
+	for (i = 0; i < nlh->nlmsg_len; i++)
+		fprintf(ofd, "%02x%s", data[i], (i % 16 == 15) ? "\n" : " ");
+	fprintf(ofd, "\n");
+}
+
+int nl_syserr2nlerr(int error)
+{
+	switch (abs(error)) {
+	case EBADF:		return NLE_BAD_SOCK;
+	case EADDRINUSE:	return NLE_EXIST;
+	case EEXIST:		return NLE_EXIST;
+	case EADDRNOTAVAIL:	return NLE_NOADDR;
+	case ESRCH:		/* fall through */
+	case ENOENT:		return NLE_OBJ_NOTFOUND;
+	case EINTR:		return NLE_INTR;
+	case EAGAIN:		return NLE_AGAIN;
+	case ENOTSOCK:		return NLE_BAD_SOCK;
+	case ENOPROTOOPT:	return NLE_INVAL;
+	case EFAULT:		return NLE_INVAL;
+	case EACCES:		return NLE_NOACCESS;
+	case EINVAL:		return NLE_INVAL;
+	case ENOBUFS:		return NLE_NOMEM;
+	case ENOMEM:		return NLE_NOMEM;
+	case EAFNOSUPPORT:	return NLE_AF_NOSUPPORT;
+	case EPROTONOSUPPORT:	return NLE_PROTO_MISMATCH;
+	case EOPNOTSUPP:	return NLE_OPNOTSUPP;
+	case EPERM:		return NLE_PERM;
+	case EBUSY:		return NLE_BUSY;
+	case ERANGE:		return NLE_RANGE;
+	case EMSGSIZE:		return NLE_MSGSIZE;
+	default:		return NLE_FAILURE;
+	}
+}
+
+void nl_perror(int error, const char *s)
+{
+	static const char *errmsg[] = {
+		[NLE_SUCCESS]		= "Success",
+		[NLE_FAILURE]		= "Unspecific failure",
+		[NLE_INTR]		= "Interrupted system call",
+		[NLE_BAD_SOCK]		= "Bad socket",
+		[NLE_AGAIN]		= "Try again",
+		[NLE_NOMEM]		= "Out of memory",
+		[NLE_EXIST]		= "Object exists",
+		[NLE_INVAL]		= "Invalid input data or parameter",
+		[NLE_RANGE]		= "Input data out of range",
+		[NLE_MSGSIZE]		= "Message size not sufficient",
+		[NLE_OPNOTSUPP]		= "Operation not supported",
+		[NLE_AF_NOSUPPORT]	= "Address family not supported",
+		[NLE_OBJ_NOTFOUND]	= "Object not found",
+		[NLE_MSG_TRUNC]		= "Message truncated",
+		[NLE_NOADDR]		= "No address",
+		[NLE_MSG_TOOSHORT]	= "Netlink message is too short",
+		[NLE_BUSY]		= "Object busy",
+		[NLE_PROTO_MISMATCH]	= "Protocol mismatch",
+		[NLE_NOACCESS]		= "No Access",
+		[NLE_PERM]		= "Operation not permitted",
+	};
+	const char *msg = NULL;
+
+	error = abs(error);
+	if (error < (int)(sizeof(errmsg) / sizeof(errmsg[0])))
+		msg = errmsg[error];
+	fprintf(stderr, "%s: %s\n", s, msg ? msg : "Unspecific failure");
+}
+#endif /* SMC_NL_RAW */
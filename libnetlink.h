@@ -20,9 +20,132 @@
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
 #include <arpa/inet.h>
+#include <time.h>
+#ifdef SMC_NL_RAW
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <linux/genetlink.h>
+#else
 #include <netlink/genl/genl.h>
 #include <netlink/handlers.h>
 #include <netlink/attr.h>
+#endif
+
+#ifdef SMC_NL_RAW
+/* Minimal replacement for the parts of libnl used by smc, smcd and smcr,
+ * see "make SMC_NL_RAW=1". Names and values follow libnl.
+ */
+#define NL_OK			0
+#define NL_SKIP			1
+#define NL_STOP			2
+
+#define NLE_SUCCESS		0
+#define NLE_FAILURE		1
+#define NLE_INTR		2
+#define NLE_BAD_SOCK		3
+#define NLE_AGAIN		4
+#define NLE_NOMEM		5
+#define NLE_EXIST		6
+#define NLE_INVAL		7
+#define NLE_RANGE		8
+#define NLE_MSGSIZE		9
+#define NLE_OPNOTSUPP		10
+#define NLE_AF_NOSUPPORT	11
+#define NLE_OBJ_NOTFOUND	12
+#define NLE_MSG_TRUNC		18
+#define NLE_NOADDR		19
+#define NLE_MSG_TOOSHORT	21
+#define NLE_BUSY		25
+#define NLE_PROTO_MISMATCH	26
+#define NLE_NOACCESS		27
+#define NLE_PERM		28
+
+enum {
+	NLA_UNSPEC,
+	NLA_U8,
+	NLA_U16,
+	NLA_U32,
+	NLA_U64,
+	NLA_STRING,
+	NLA_FLAG,
+	NLA_MSECS,
+	NLA_NESTED,
+	NLA_NESTED_COMPAT,
+	NLA_NUL_STRING,
+	NLA_BINARY,
+	__NLA_TYPE_MAX,
+};
+#define NLA_TYPE_MAX		(__NLA_TYPE_MAX - 1)
+
+struct nla_policy {
+	uint16_t	type;
+	uint16_t	minlen;
+	uint16_t	maxlen;
+};
+
+/* a received message, points into the receive buffer unless converted */
+struct nl_msg {
+	struct nlmsghdr	*nm_nlh;
+	int		nm_alloc;
+};
+
+static inline struct nlmsghdr *nlmsg_hdr(struct nl_msg *msg)
+{
+	return msg->nm_nlh;
+}
+
+static inline void *nla_data(const struct nlattr *nla)
+{
+	return (char *)nla + NLA_HDRLEN;
+}
+
+static inline int nla_len(const struct nlattr *nla)
+{
+	return nla->nla_len - NLA_HDRLEN;
+}
+
+static inline uint8_t nla_get_u8(const struct nlattr *nla)
+{
+	return *(uint8_t *)nla_data(nla);
+}
+
+static inline uint16_t nla_get_u16(const struct nlattr *nla)
+{
+	return *(uint16_t *)nla_data(nla);
+}
+
+static inline uint32_t nla_get_u32(const struct nlattr *nla)
+{
+	return *(uint32_t *)nla_data(nla);
+}
+
+static inline uint64_t nla_get_u64(const struct nlattr *nla)
+{
+	uint64_t tmp;
+
+	memcpy(&tmp, nla_data(nla), sizeof(tmp));	/* may be unaligned */
+	return tmp;
+}
+
+static inline char *nla_get_string(const struct nlattr *nla)
+{
+	return (char *)nla_data(nla);
+}
+
+struct nlattr *nla_find(const struct nlattr *head, int len, int attrtype);
+int nla_parse(struct nlattr *tb[], int maxtype, struct nlattr *head, int len,
+	      const struct nla_policy *policy);
+int nla_parse_nested(struct nlattr *tb[], int maxtype, struct nlattr *nla,
+		     const struct nla_policy *policy);
+int genlmsg_parse(struct nlmsghdr *nlh, int hdrlen, struct nlattr *tb[],
+		  int maxtype, const struct nla_policy *policy);
+struct nl_msg *nlmsg_convert(struct nlmsghdr *hdr);
+void nlmsg_free(struct nl_msg *msg);
+void nl_msg_dump(struct nl_msg *msg, FILE *ofd);
+int nl_syserr2nlerr(int error);
+void nl_perror(int error, const char *s);
+#endif /* SMC_NL_RAW */
 
 static const struct nla_policy smc_gen_net_policy[SMC_GEN_MAX + 1] = {
 	[SMC_GEN_UNSPEC]	= { .type = NLA_UNSPEC, },
@@ -54,6 +177,49 @@ struct rtnl_handle {
 		},                                                          \
 	}
 
+/* Records of a SMC_NL_RECORD file: a struct nl_rec_hdr followed by the netlink
+ * message, in host byte order
+ */
+#define NL_REC_GENL	1
+#define NL_REC_DIAG	2
+#define NL_REC_MARK	3	/* start of a sample, cmd is the sample number */
+
+struct nl_rec_hdr {
+	__u32	kind;		/* NL_REC_* */
+	__u32	cmd;		/* genl command or sock_diag extensions */
+	__u32	len;		/* length of the netlink message that follows */
+};
+
+/* message of a NL_REC_MARK record */
+struct nl_rec_mark {
+	struct nlmsghdr	nlh;
+	__u64		sec;		/* wall clock time of the sample */
+	__u64		nsec;
+};
+
+#define GEN_NL_BATCH_MAX	8
+
+enum {
+	GEN_NL_REQ_QUEUED,
+	GEN_NL_REQ_SENT,
+	GEN_NL_REQ_DONE,
+};
+
+/* one request of a gen_nl_batch_run() batch */
+struct gen_nl_req {
+	int		cmd;
+	int		flags;		/* NLM_F_DUMP or 0 */
+	int		(*cb_handler)(struct nl_msg *msg, void *arg);
+	void		*arg;
+	int		attr;		/* optional string attribute */
+	const char	*str;
+	int		err;		/* result: 0 or negative libnl error */
+	/* internal */
+	int		state;
+	int		stopped;
+	unsigned int	seq;
+};
+
 int rtnl_open(struct rtnl_handle *rth);
 void rtnl_close(struct rtnl_handle *rth);
 int rtnl_dump(struct rtnl_handle *rth, void (*handler)(struct nlmsghdr *nlh));
@@ -65,5 +231,10 @@ void gen_nl_close();
 int gen_nl_handle(int cmd, int nlmsg_flags,
 		  int (*cb_handler)(struct nl_msg *msg, void *arg), void *arg);
 int gen_nl_handle_dump(int cmd, int (*cb_handler)(struct nl_msg *msg, void *arg), void *arg);
+int gen_nl_handle_dumps(const int *cmds, int ncmds,
+			int (*cb_handler)(struct nl_msg *msg, void *arg), void *arg);
+int gen_nl_batch_run(struct gen_nl_req *reqs, int nreqs);
+void gen_nl_perror(int err);
 uint64_t nl_attr_get_uint(const struct nlattr *nla);
+int nl_sample(unsigned int n, unsigned int interval, struct timespec *ts);
 #endif /* SMC_LIBNETLINK_H_ */
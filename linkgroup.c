@@ -14,18 +14,23 @@
  */
 #include <ctype.h>
 #include <errno.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 
 #include "smctools_common.h"
 #include "util.h"
 #include "libnetlink.h"
 #include "linkgroup.h"
+#include "topology.h"
 
 #define SMC_MASK_LINK_ID 0xFFFFFF00
 #define SMC_INVALID_LINK_ID 0xFFFFFFFF
+#define SMC_BALANCE_THRESHOLD_DFT 1.5
+#define SMC_LINK_STATE_ACTIVE 3
 
 static __u32 unmasked_trgt_lgid = 0;
 static int netdev_entered = 0;
@@ -34,6 +39,13 @@ static int ibdev_entered = 0;
 static int type_entered = 0;
 static int all_entered = 0;
 static int show_links = 0;
+static int watch_cmd = 0;
+static double watch_interval = 1;
+#if !defined(SMCD)
+static int balance_cmd = 0;
+static int balance_interval = 0;
+static double balance_threshold = SMC_BALANCE_THRESHOLD_DFT;
+#endif
 #if defined(SMCD)
 static int lgr_smcr = 0;
 static int lgr_smcd = 1;
@@ -46,6 +58,7 @@ static int d_level = 0;
 static char target_ibdev[IB_DEVICE_NAME_MAX] = {0};
 static char target_type[SMC_TYPE_STR_MAX] = {0};
 static char target_ndev[IFNAMSIZ] = {0};
+static unsigned int target_ifindex = 0;
 
 static struct nla_policy smc_gen_lgr_smcr_sock_policy[SMC_NLA_LGR_R_MAX + 1] = {
 	[SMC_NLA_LGR_R_UNSPEC]		= { .type = NLA_UNSPEC },
@@ -65,6 +78,7 @@ static struct nla_policy smc_gen_lgr_smcd_sock_policy[SMC_NLA_LGR_D_MAX + 1] = {
 					    .maxlen = SMC_MAX_PNETID_LEN + 1 },
 	[SMC_NLA_LGR_D_VLAN_ID]		= { .type = NLA_U8 },
 	[SMC_NLA_LGR_D_CONNS_NUM]	= { .type = NLA_U32 },
+	[SMC_NLA_LGR_D_CHID]		= { .type = NLA_U16 },
 };
 
 static struct nla_policy smc_gen_link_smcr_sock_policy[SMC_NLA_LINK_MAX + 1] = {
@@ -104,14 +118,19 @@ static void usage(void)
 	fprintf(stderr,
 #if defined(SMCD)
 		"Usage: smcd linkgroup [show] [all | LG-ID]\n"
+		"       smcd linkgroup watch [interval <sec>]\n"
 #elif defined(SMCR)
 		"Usage: smcr linkgroup [show | link-show] [all | LG-ID]\n"
 		"                                         [ibdev <dev>]\n"
 		"                                         [netdev <dev>]\n"
+		"       smcr linkgroup balance [interval <sec>] [threshold <ratio>]\n"
+		"       smcr linkgroup watch [interval <sec>]\n"
 #else
 		"Usage: smc linkgroup [show | link-show] [all | LG-ID] [type {smcd | smcr}]\n"
 		"                                                      [ibdev <dev>]\n"
 		"                                                      [netdev <dev>]\n"
+		"       smc linkgroup balance [interval <sec>] [threshold <ratio>]\n"
+		"       smc linkgroup watch [interval <sec>] [type {smcd | smcr}]\n"
 #endif
 	);
 	exit(-1);
@@ -172,7 +191,7 @@ static const char *smc_peer_os(unsigned int x)
 	}
 }
 
-static const char *smc_link_state(unsigned int x)
+const char *smc_link_state(unsigned int x)
 {
 	static char buf[16];
 
@@ -185,7 +204,7 @@ static const char *smc_link_state(unsigned int x)
 	}
 }
 
-static const char *smc_lgr_type(unsigned int x)
+const char *smc_lgr_type(unsigned int x)
 {
 	static char buf[16];
 
@@ -238,7 +257,68 @@ static int filter_smcr_item(struct smc_diag_linkinfo_v2 *link, struct smc_diag_l
 	return ignore;
 }
 
-static int fill_link_struct(struct smc_diag_linkinfo_v2 *link, struct nlattr **attrs)
+/* Cheap check of the LG-ID, netdev and ibdev filters on the raw attributes,
+ * before any struct is filled. Only skips items that definitely do not match,
+ * filter_smcr_item() still decides on the filled structs. Links of a skipped
+ * link group are skipped as well.
+ */
+static int prefilter_smcr_item(struct nlattr **attrs)
+{
+	static int skip_links = 0;
+	struct nlattr *nest, *nla;
+	char *name;
+
+	if (attrs[SMC_GEN_LGR_SMCR]) {
+		skip_links = 0;
+		if (!unmasked_trgt_lgid ||
+		    (show_links && (!is_str_empty(target_ndev) || !is_str_empty(target_ibdev))))
+			return 0;
+		nest = attrs[SMC_GEN_LGR_SMCR];
+		nla = nla_find(nla_data(nest), nla_len(nest), SMC_NLA_LGR_R_ID);
+		if (nla && nla_len(nla) >= (int)sizeof(__u32) && nla_get_u32(nla) != target_lgid)
+			skip_links = 1;
+		return skip_links;
+	}
+	if (skip_links)
+		return 1;
+	if (!show_links || !attrs[SMC_GEN_LINK_SMCR])
+		return 0;
+
+	nest = attrs[SMC_GEN_LINK_SMCR];
+	if (!is_str_empty(target_ndev)) {
+		if (!target_ifindex)
+			return 0;
+		nla = nla_find(nla_data(nest), nla_len(nest), SMC_NLA_LINK_NET_DEV);
+		return nla && nla_len(nla) >= (int)sizeof(__u32) &&
+		       nla_get_u32(nla) != target_ifindex;
+	}
+	if (!is_str_empty(target_ibdev)) {
+		nla = nla_find(nla_data(nest), nla_len(nest), SMC_NLA_LINK_IB_DEV);
+		if (!nla || nla_len(nla) < 1 || nla_len(nla) > IB_DEVICE_NAME_MAX)
+			return 0;
+		name = nla_data(nla);
+		if (name[nla_len(nla) - 1] != '\0')
+			return 0;
+		return strcmp(target_ibdev, name) != 0;
+	}
+
+	return 0;
+}
+
+static int prefilter_smcd_item(struct nlattr **attrs)
+{
+	struct nlattr *nest = attrs[SMC_GEN_LGR_SMCD];
+	struct nlattr *nla;
+
+	if (!unmasked_trgt_lgid || !nest)
+		return 0;
+	nla = nla_find(nla_data(nest), nla_len(nest), SMC_NLA_LGR_D_ID);
+
+	return nla && nla_len(nla) >= (int)sizeof(__u32) &&
+	       nla_get_u32(nla) != unmasked_trgt_lgid;
+}
+
+int fill_link_struct(struct smc_diag_linkinfo_v2 *link, struct nlattr **attrs)
 {
 	struct nlattr *link_attrs[SMC_NLA_LINK_MAX + 1];
 	__u32 temp_link_uid;
@@ -249,6 +329,8 @@ static int fill_link_struct(struct smc_diag_linkinfo_v2 *link, struct nlattr **a
 		fprintf(stderr, "Error: Failed to parse nested attributes: smc_gen_link_smcr_sock_policy\n");
 		return NL_STOP;
 	}
+	if (link_attrs[SMC_NLA_LINK_ID])
+		link->v1.link_id = nla_get_u8(link_attrs[SMC_NLA_LINK_ID]);
 	if (link_attrs[SMC_NLA_LINK_STATE])
 		link->link_state = nla_get_u32(link_attrs[SMC_NLA_LINK_STATE]);
 	if (link_attrs[SMC_NLA_LINK_CONN_CNT])
@@ -263,8 +345,8 @@ static int fill_link_struct(struct smc_diag_linkinfo_v2 *link, struct nlattr **a
 		temp_link_uid = nla_get_u32(link_attrs[SMC_NLA_LINK_PEER_UID]);
 		memcpy(&link->peer_link_uid[0], &temp_link_uid, sizeof(temp_link_uid));
 	}
-	if (link_attrs[SMC_NLA_LINK_NET_DEV] && nla_get_u32(link_attrs[SMC_NLA_LINK_NET_DEV]))
-		if_indextoname(nla_get_u32(link_attrs[SMC_NLA_LINK_NET_DEV]), (char*)link->netdev);
+	if (link_attrs[SMC_NLA_LINK_NET_DEV])
+		smc_ifname(nla_get_u32(link_attrs[SMC_NLA_LINK_NET_DEV]), (char*)link->netdev);
 	if (link_attrs[SMC_NLA_LINK_IB_DEV])
 		snprintf((char*)link->v1.ibname, sizeof(link->v1.ibname), "%s",
 			 nla_get_string(link_attrs[SMC_NLA_LINK_IB_DEV]));
@@ -296,7 +378,7 @@ static void fill_lgr_v2_common_struct(struct smc_v2_lgr_info *v2_lgr_info, struc
 	v2_lgr_info->v2_lgr_info_received = 1;
 }
 
-static int fill_lgr_struct(struct smc_diag_lgr *lgr, struct nlattr **attrs)
+int fill_lgr_struct(struct smc_diag_lgr *lgr, struct nlattr **attrs)
 {
 	struct nlattr *lgr_attrs[SMC_NLA_LGR_R_MAX + 1];
 
@@ -350,7 +432,7 @@ static int fill_lgr_struct(struct smc_diag_lgr *lgr, struct nlattr **attrs)
 	return NL_OK;
 }
 
-static int fill_lgr_smcd_struct(struct smcd_diag_dmbinfo_v2 *lgr, struct nlattr **attrs)
+int fill_lgr_smcd_struct(struct smcd_diag_dmbinfo_v2 *lgr, struct nlattr **attrs)
 {
 	struct nlattr *lgr_attrs[SMC_NLA_LGR_D_MAX + 1];
 
@@ -366,6 +448,8 @@ static int fill_lgr_smcd_struct(struct smcd_diag_dmbinfo_v2 *lgr, struct nlattr
 		lgr->vlan_id = nla_get_u8(lgr_attrs[SMC_NLA_LGR_D_VLAN_ID]);
 	if (lgr_attrs[SMC_NLA_LGR_D_CONNS_NUM])
 		lgr->conns_num = nla_get_u32(lgr_attrs[SMC_NLA_LGR_D_CONNS_NUM]);
+	if (lgr_attrs[SMC_NLA_LGR_D_CHID])
+		lgr->chid = nla_get_u16(lgr_attrs[SMC_NLA_LGR_D_CHID]);
 	if (lgr_attrs[SMC_NLA_LGR_D_PNETID])
 		snprintf((char*)lgr->pnet_id, sizeof(lgr->pnet_id), "%s",
 			 nla_get_string(lgr_attrs[SMC_NLA_LGR_D_PNETID]));
@@ -420,6 +504,9 @@ static int show_lgr_smcr_info(struct nlattr **attr)
 	static struct smc_diag_lgr lgr = {0};
 	int rc = NL_OK;
 
+	if (prefilter_smcr_item(attr))
+		return rc;
+
 	if (attr[SMC_GEN_LGR_SMCR])
 		rc = fill_lgr_struct(&lgr, attr);
 
@@ -501,6 +588,9 @@ static int show_lgr_smcd_info(struct nlattr **attr)
 	struct smcd_diag_dmbinfo_v2 lgr = {0};
 	int rc = NL_OK;
 
+	if (prefilter_smcd_item(attr))
+		return rc;
+
 	if (attr[SMC_GEN_LGR_SMCD])
 		rc = fill_lgr_smcd_struct(&lgr, attr);
 
@@ -552,9 +642,450 @@ static int handle_gen_lgr_reply(struct nl_msg *msg, void *arg)
 	return rc;
 }
 
+#if !defined(SMCD)
+#define SMC_BALANCE_MAX_LINKS 8
+/* byte rate per link below which the byte skew is noise, bytes/s */
+#define SMC_BALANCE_MIN_RATE (1024 * 1024)
+
+/* Bytes a cursor moved between two samples of a buffer of the given size */
+static __u64 cursor_diff(struct smc_diag_cursor *old, struct smc_diag_cursor *new,
+			 __u32 size)
+{
+	__u16 wraps = new->wrap - old->wrap;
+
+	if (!wraps)
+		return new->count >= old->count ? new->count - old->count : 0;
+	return (__u64)(wraps - 1) * size + (size - old->count) + new->count;
+}
+
+/* Bytes sent and received by the sockets of a link since the previous sample */
+static __u64 link_bytes(struct topology *prev, struct topo_link *link)
+{
+	struct topo_sock *sock, *old;
+	__u64 bytes = 0;
+
+	if (!prev)
+		return 0;
+	for (sock = link->socks; sock; sock = sock->next) {
+		if (!sock->has_cinfo)
+			continue;
+		old = topology_find_sock(prev, sock->tkey[1], sock->tkey[0]);
+		if (!old || !old->has_cinfo)
+			continue;	/* new connection, no baseline */
+		bytes += cursor_diff(&old->cinfo.tx_sent, &sock->cinfo.tx_sent,
+				     sock->cinfo.sndbuf_size);
+		bytes += cursor_diff(&old->cinfo.rx_prod, &sock->cinfo.rx_prod,
+				     sock->cinfo.rmbe_size);
+	}
+	return bytes;
+}
+
+/* Load of the busiest entry relative to the average, 0 if not applicable */
+static double get_skew(__u64 *val, int cnt)
+{
+	__u64 max = 0, sum = 0;
+	int i;
+
+	for (i = 0; i < cnt; i++) {
+		sum += val[i];
+		if (val[i] > max)
+			max = val[i];
+	}
+	if (cnt < 2 || !sum)
+		return 0;
+	return max * cnt / (double)sum;
+}
+
+static void print_skew(double skew)
+{
+	if (skew)
+		printf("%9.2f  ", skew);
+	else
+		printf("%9s  ", "-");
+}
+
+static void print_rate(__u64 bytes)
+{
+	char buf[7];
+
+	if (!balance_interval) {
+		printf("%7s  ", "-");
+		return;
+	}
+	get_abbreviated(bytes / balance_interval, 6, buf);
+	printf("%7s  ", buf);
+}
+
+static void show_lgr_balance(struct topology *topo, struct topology *prev)
+{
+	__u64 conns[SMC_BALANCE_MAX_LINKS], bytes[SMC_BALANCE_MAX_LINKS];
+	__u64 conn_sum, byte_sum;
+	double conn_skew, byte_skew;
+	struct topo_link *link;
+	struct topo_lgr *lgr;
+	int n, imbalanced;
+
+	printf("LG-ID    LG-Type  #Links  #Conns  Conn-Skew  Bytes/s  Byte-Skew  Status\n");
+	for (lgr = topo->lgrs; lgr; lgr = lgr->next) {
+		/* only SYM, ASYMP and ASYML link groups have redundant links */
+		if (lgr->smcd || lgr->r.lgr_type < 2 || lgr->r.lgr_type > 4)
+			continue;
+		n = 0;
+		conn_sum = 0;
+		byte_sum = 0;
+		for (link = lgr->links; link && n < SMC_BALANCE_MAX_LINKS; link = link->next_lgr) {
+			if (link->info.link_state != SMC_LINK_STATE_ACTIVE)
+				continue;
+			conns[n] = link->info.conn_cnt;
+			bytes[n] = link_bytes(prev, link);
+			conn_sum += conns[n];
+			byte_sum += bytes[n];
+			n++;
+		}
+		conn_skew = get_skew(conns, n);
+		byte_skew = get_skew(bytes, n);
+		/* a handful of connections or bytes cannot be spread evenly */
+		imbalanced = (conn_sum >= 2 * n && conn_skew >= balance_threshold) ||
+			     (byte_sum >= (__u64)SMC_BALANCE_MIN_RATE * n * balance_interval &&
+			      byte_skew >= balance_threshold);
+
+		printf("%08x ", lgr->key[0]);
+		printf("%-8s ", smc_lgr_type(lgr->r.lgr_type));
+		printf("%6d  ", n);
+		printf("%6llu  ", conn_sum);
+		print_skew(conn_skew);
+		print_rate(byte_sum);
+		print_skew(byte_skew);
+		printf("%s\n", imbalanced ? "IMBALANCED" : "OK");
+		if (d_level < SMC_DETAIL_LEVEL_V)
+			continue;
+		for (link = lgr->links; link; link = link->next_lgr) {
+			printf("  Link-UID %08x ", ntohl(*(__u32 *)link->info.link_uid));
+			printf("%-8s %4d ", link->info.v1.ibname, link->info.v1.ibport);
+			printf("%-15s ", smc_link_state(link->info.link_state));
+			printf("%6d  ", link->info.conn_cnt);
+			print_rate(link_bytes(prev, link));
+			printf("\n");
+		}
+	}
+}
+
+/* Compare each port against the average of the ports in the same PNET */
+static void show_port_balance(struct topology *topo, struct topology *prev)
+{
+	double conn_avg, byte_avg, conn_skew, byte_skew;
+	__u64 conn_sum, byte_sum, *conns, *bytes;
+	struct topo_port **ports;
+	struct topo_link *link;
+	struct topo_dev *dev;
+	int i, j, n = 0, grp;
+
+	for (dev = topo->devs; dev; dev = dev->next)
+		if (!dev->smcd)
+			n += SMC_MAX_PORTS;
+	ports = calloc(n + 1, sizeof(*ports));
+	conns = calloc(n + 1, sizeof(*conns));
+	bytes = calloc(n + 1, sizeof(*bytes));
+	if (!ports || !conns || !bytes) {
+		perror("Error: Cannot allocate memory");
+		goto out;
+	}
+
+	n = 0;
+	for (dev = topo->devs; dev; dev = dev->next) {
+		if (dev->smcd)
+			continue;
+		for (i = 0; i < SMC_MAX_PORTS; i++) {
+			/* an idle active port is part of the imbalance */
+			if (!dev->port[i].links &&
+			    (!dev->port[i].valid || dev->info.port_state[i] != 1))
+				continue;
+			ports[n] = &dev->port[i];
+			for (link = ports[n]->links; link; link = link->next_port) {
+				if (link->info.link_state != SMC_LINK_STATE_ACTIVE)
+					continue;
+				conns[n] += link->info.conn_cnt;
+				bytes[n] += link_bytes(prev, link);
+			}
+			n++;
+		}
+	}
+
+	printf("\nIB-Dev   IB-P  PNET-ID           #Conns  Conn-Skew  Bytes/s  Byte-Skew  Status\n");
+	for (i = 0; i < n; i++) {
+		dev = ports[i]->dev;
+		grp = 0;
+		conn_sum = 0;
+		byte_sum = 0;
+		for (j = 0; j < n; j++) {
+			if (strncmp((char *)ports[j]->dev->info.pnet_id[ports[j]->key.ibport - 1],
+				    (char *)dev->info.pnet_id[ports[i]->key.ibport - 1],
+				    SMC_MAX_PNETID_LEN))
+				continue;
+			grp++;
+			conn_sum += conns[j];
+			byte_sum += bytes[j];
+		}
+		conn_avg = conn_sum / (double)grp;
+		byte_avg = byte_sum / (double)grp;
+		conn_skew = (grp > 1 && conn_sum) ? conns[i] / conn_avg : 0;
+		byte_skew = (grp > 1 && byte_sum) ? bytes[i] / byte_avg : 0;
+
+		printf("%-8s %4d  ", dev->info.dev_name, ports[i]->key.ibport);
+		printf("%-16s ", trim_space((char *)dev->info.pnet_id[ports[i]->key.ibport - 1]));
+		printf("%6llu  ", conns[i]);
+		print_skew(conn_skew);
+		print_rate(bytes[i]);
+		print_skew(byte_skew);
+		printf("%s\n", ((conn_sum >= 2 * grp && conn_skew >= balance_threshold) ||
+				(byte_sum >= (__u64)SMC_BALANCE_MIN_RATE * grp * balance_interval &&
+				 byte_skew >= balance_threshold)) ? "OVERLOADED" : "OK");
+	}
+out:
+	free(ports);
+	free(conns);
+	free(bytes);
+}
+
+static int show_balance(void)
+{
+	struct topology *topo, *prev = NULL;
+
+	/* byte rates need two samples of the connection cursors */
+	if (balance_interval) {
+		prev = topology_build(1, 0, TOPO_SOCK_CONNINFO);
+		if (!prev)
+			return EXIT_FAILURE;
+		sleep(balance_interval);
+	}
+	topo = topology_build(1, 0, balance_interval ? TOPO_SOCK_CONNINFO : 0);
+	if (!topo) {
+		topology_free(prev);
+		return EXIT_FAILURE;
+	}
+	show_lgr_balance(topo, prev);
+	show_port_balance(topo, prev);
+	topology_free(topo);
+	topology_free(prev);
+
+	return EXIT_SUCCESS;
+}
+
+static void handle_balance_params(int argc, char **argv)
+{
+	char *endptr = NULL;
+
+	while (NEXT_ARG_OK()) {
+		NEXT_ARG();
+		if (contains(argv[0], "help") == 0) {
+			usage();
+		} else if (contains(argv[0], "interval") == 0) {
+			if (!NEXT_ARG_OK())
+				usage();
+			NEXT_ARG();
+			balance_interval = atoi(argv[0]);
+			if (balance_interval <= 0)
+				usage();
+		} else if (contains(argv[0], "threshold") == 0) {
+			if (!NEXT_ARG_OK())
+				usage();
+			NEXT_ARG();
+			balance_threshold = strtod(argv[0], &endptr);
+			if (endptr == argv[0] || *endptr || balance_threshold <= 1)
+				usage();
+		} else {
+			usage();
+		}
+	}
+}
+#endif
+
+static void print_event(const char *fmt, ...)
+	__attribute__((format(printf, 1, 2)));
+
+/* Print one timestamped event line */
+static void print_event(const char *fmt, ...)
+{
+	struct timespec ts;
+	char tstamp[32];
+	struct tm tm;
+	va_list ap;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	localtime_r(&ts.tv_sec, &tm);
+	strftime(tstamp, sizeof(tstamp), "%Y-%m-%d %H:%M:%S", &tm);
+	printf("%s.%03ld  ", tstamp, ts.tv_nsec / 1000000);
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+	printf("\n");
+}
+
+static void diff_links(struct topology *prev, struct topology *topo)
+{
+	struct topo_link *link, *old;
+	struct topo_lgr *lgr;
+
+	for (lgr = topo->lgrs; lgr; lgr = lgr->next) {
+		for (link = lgr->links; link; link = link->next_lgr) {
+			old = topology_find_link(prev, link->info.link_uid);
+			if (!old) {
+				print_event("LG-ID %08x Link-UID %08x added: %s %s/%d %s, %d conns",
+					    lgr->key[0], ntohl(*(__u32 *)link->info.link_uid),
+					    smc_link_state(link->info.link_state),
+					    link->info.v1.ibname, link->info.v1.ibport,
+					    link->info.netdev, link->info.conn_cnt);
+				continue;
+			}
+			if (old->info.link_state != link->info.link_state)
+				print_event("LG-ID %08x Link-UID %08x state %s -> %s",
+					    lgr->key[0], ntohl(*(__u32 *)link->info.link_uid),
+					    smc_link_state(old->info.link_state),
+					    smc_link_state(link->info.link_state));
+			if (old->info.conn_cnt != link->info.conn_cnt)
+				print_event("LG-ID %08x Link-UID %08x conns %d -> %d",
+					    lgr->key[0], ntohl(*(__u32 *)link->info.link_uid),
+					    old->info.conn_cnt, link->info.conn_cnt);
+		}
+	}
+	for (lgr = prev->lgrs; lgr; lgr = lgr->next) {
+		for (old = lgr->links; old; old = old->next_lgr) {
+			if (!topology_find_link(topo, old->info.link_uid))
+				print_event("LG-ID %08x Link-UID %08x removed",
+					    lgr->key[0], ntohl(*(__u32 *)old->info.link_uid));
+		}
+	}
+}
+
+static void diff_lgrs(struct topology *prev, struct topology *topo)
+{
+	struct topo_lgr *lgr, *old;
+
+	for (lgr = topo->lgrs; lgr; lgr = lgr->next) {
+		old = topology_find_lgr(prev, lgr->key[0], lgr->smcd);
+		if (lgr->smcd) {
+			if (!old)
+				print_event("LG-ID %08x created: SMC-D, VLAN %#x, PNET-ID %s, %d conns",
+					    lgr->key[0], lgr->d.vlan_id,
+					    trim_space((char *)lgr->d.pnet_id), lgr->d.conns_num);
+			else if (old->d.conns_num != lgr->d.conns_num)
+				print_event("LG-ID %08x conns %d -> %d", lgr->key[0],
+					    old->d.conns_num, lgr->d.conns_num);
+			continue;
+		}
+		if (!old) {
+			print_event("LG-ID %08x created: SMC-R %s %s, VLAN %#x, PNET-ID %s, %d conns",
+				    lgr->key[0], lgr->r.lgr_role ? "SERV" : "CLNT",
+				    smc_lgr_type(lgr->r.lgr_type), lgr->r.vlan_id,
+				    trim_space((char *)lgr->r.pnet_id), lgr->r.conns_num);
+			continue;
+		}
+		if (old->r.lgr_type != lgr->r.lgr_type)
+			print_event("LG-ID %08x type %s -> %s", lgr->key[0],
+				    smc_lgr_type(old->r.lgr_type), smc_lgr_type(lgr->r.lgr_type));
+		if (old->r.conns_num != lgr->r.conns_num)
+			print_event("LG-ID %08x conns %d -> %d", lgr->key[0],
+				    old->r.conns_num, lgr->r.conns_num);
+	}
+	for (old = prev->lgrs; old; old = old->next) {
+		if (!topology_find_lgr(topo, old->key[0], old->smcd))
+			print_event("LG-ID %08x destroyed", old->key[0]);
+	}
+}
+
+/* Re-dump the link groups every interval and print what changed */
+static int watch_lgs(void)
+{
+	struct topology *prev, *topo;
+	struct timespec ts;
+	struct topo_lgr *lgr;
+	int nlgrs = 0, nlinks = 0;
+
+	ts.tv_sec = (time_t)watch_interval;
+	ts.tv_nsec = (watch_interval - ts.tv_sec) * 1000000000;
+	prev = topology_build(lgr_smcr, lgr_smcd, TOPO_NO_SOCKS);
+	if (!prev)
+		return EXIT_FAILURE;
+	for (lgr = prev->lgrs; lgr; lgr = lgr->next) {
+		nlgrs++;
+		nlinks += lgr->nlinks;
+	}
+	print_event("watching %d link groups with %d links", nlgrs, nlinks);
+	fflush(stdout);
+	while (1) {
+		nanosleep(&ts, NULL);
+		smc_ifname_flush();
+		topo = topology_build(lgr_smcr, lgr_smcd, TOPO_NO_SOCKS);
+		if (!topo) {
+			topology_free(prev);
+			return EXIT_FAILURE;
+		}
+		diff_lgrs(prev, topo);
+		diff_links(prev, topo);
+		fflush(stdout);
+		topology_free(prev);
+		prev = topo;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+static void handle_watch_params(int argc, char **argv)
+{
+	char *endptr = NULL;
+
+	while (NEXT_ARG_OK()) {
+		NEXT_ARG();
+		if (type_entered) {
+			snprintf(target_type, sizeof(target_type), "%s", argv[0]);
+			if (strncmp(target_type, "smcd", SMC_TYPE_STR_MAX) == 0) {
+				lgr_smcd = 1;
+				lgr_smcr = 0;
+			} else if ((strnlen(target_type, sizeof(target_type)) < 4) ||
+				   (strncmp(target_type, "smcr", SMC_TYPE_STR_MAX) != 0)) {
+				print_type_error();
+			}
+			type_entered = 0;
+		} else if (contains(argv[0], "help") == 0) {
+			usage();
+		} else if (contains(argv[0], "interval") == 0) {
+			if (!NEXT_ARG_OK())
+				usage();
+			NEXT_ARG();
+			watch_interval = strtod(argv[0], &endptr);
+			if (endptr == argv[0] || *endptr || watch_interval < 0.1)
+				usage();
+#if !defined(SMCD) && !defined(SMCR)
+		} else if (contains(argv[0], "type") == 0) {
+			type_entered = 1;
+#endif
+		} else {
+			usage();
+		}
+	}
+	if (type_entered)
+		usage();
+}
+
 static void handle_cmd_params(int argc, char **argv)
 {
-	if (((argc == 1) && (contains(argv[0], "help") == 0)) || (argc > 4))
+	if ((argc == 1) && (contains(argv[0], "help") == 0))
+		usage();
+
+	/* watch and balance check their own, longer argument lists */
+	if (argc > 0 && contains(argv[0], "watch") == 0) {
+		watch_cmd = 1;
+		handle_watch_params(argc, argv);
+		return;
+	}
+#if !defined(SMCD)
+	if (argc > 0 && contains(argv[0], "balance") == 0) {
+		balance_cmd = 1;
+		handle_balance_params(argc, argv);
+		return;
+	}
+#endif
+	if (argc > 4)
 		usage();
 
 	if (argc > 0) {
@@ -625,6 +1156,14 @@ int invoke_lgs(int argc, char **argv, int detail_level)
 
 	d_level = detail_level;
 	handle_cmd_params(argc, argv);
+	if (watch_cmd)
+		return watch_lgs();
+#if !defined(SMCD)
+	if (balance_cmd)
+		return show_balance();
+#endif
+	if (!is_str_empty(target_ndev))
+		target_ifindex = if_nametoindex(target_ndev);
 	if (lgr_smcd)
 		rc = gen_nl_handle_dump(SMC_NETLINK_GET_LGR_SMCD, handle_gen_lgr_reply, NULL);
 	else if (show_links)
@@ -18,5 +18,10 @@
 extern struct rtnl_handle rth;
 
 int invoke_lgs(int argc, char **argv, int detail_level);
+int fill_link_struct(struct smc_diag_linkinfo_v2 *link, struct nlattr **attrs);
+int fill_lgr_struct(struct smc_diag_lgr *lgr, struct nlattr **attrs);
+int fill_lgr_smcd_struct(struct smcd_diag_dmbinfo_v2 *lgr, struct nlattr **attrs);
+const char *smc_link_state(unsigned int x);
+const char *smc_lgr_type(unsigned int x);
 
 #endif /* LINKGROUP_H_ */
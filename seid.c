@@ -26,8 +26,6 @@ static int enable_cmd = 0;
 static int disable_cmd = 0;
 static int show_cmd = 0;
 
-extern int smc_id;
-extern struct nl_sock *sk;
 
 const struct nla_policy
 smc_gen_seid_policy[SMC_NLA_SEID_TABLE_MAX + 1] = {
@@ -107,39 +105,17 @@ static int handle_gen_seid_reply(struct nl_msg *msg, void *arg)
 
 int gen_nl_seid_handle(int cmd, char dump, int (*cb_handler)(struct nl_msg *msg, void *arg))
 {
-	int rc = EXIT_FAILURE, nlmsg_flags = 0;
-	struct nl_msg *msg;
-
-	nl_socket_modify_cb(sk, NL_CB_VALID, NL_CB_CUSTOM, cb_handler, NULL);
-
-	/* Allocate a netlink message and set header information. */
-	msg = nlmsg_alloc();
-	if (!msg) {
-		nl_perror(NLE_NOMEM, "Error");
-		rc = EXIT_FAILURE;
-		goto err;
-	}
+	struct gen_nl_req req = {
+		.cmd = cmd,
+		.cb_handler = cb_handler,
+	};
+	int rc;
 
 	if (dump)
-		nlmsg_flags = NLM_F_DUMP;
+		req.flags = NLM_F_DUMP;
 
-	if (!genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, smc_id, 0, nlmsg_flags,
-			 cmd, SMC_GENL_FAMILY_VERSION)) {
-		nl_perror(rc, "Error");
-		rc = EXIT_FAILURE;
-		goto err;
-	}
-
-	/* Send message */
-	rc = nl_send_auto(sk, msg);
-	if (rc < 0) {
-		nl_perror(rc, "Error");
-		rc = EXIT_FAILURE;
-		goto err;
-	}
-
-	/* Receive reply message, returns number of cb invocations. */
-	rc = nl_recvmsgs_default(sk);
+	gen_nl_batch_run(&req, 1);
+	rc = req.err;
 
 	if (rc < 0) {
 		/* For cmd "SEID disable" the kernel might return ENOENT when
@@ -153,15 +129,10 @@ int gen_nl_seid_handle(int cmd, char dump, int (*cb_handler)(struct nl_msg *msg,
 		} else {
 			nl_perror(rc, "Error");
 		}
-		rc = EXIT_FAILURE;
-		goto err;
+		return EXIT_FAILURE;
 	}
 
-	nlmsg_free(msg);
 	return EXIT_SUCCESS;
-err:
-	nlmsg_free(msg);
-	return rc;
 }
 
 static void handle_cmd_params(int argc, char **argv)
@@ -16,6 +16,18 @@
 #include <sys/types.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/param.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/io_uring.h>
 #include <gnu/lib-names.h>
 #include <netdb.h>
 #include <dlfcn.h>
@@ -23,6 +35,13 @@
 #include <search.h>
 #include <ctype.h>
 #include <pthread.h>
+#include <signal.h>
+#include <inttypes.h>
+#include <sys/resource.h>
+#include <sys/auxv.h>
+#include <dirent.h>
+
+#include "smctools_common.h"
 
 #define DLOPEN_FLAG RTLD_LAZY
 
@@ -30,18 +49,46 @@
 #define AF_SMC 43
 #endif
 
+/* IORING_OP_SOCKET came with 128 byte SQEs */
+#if defined(__NR_io_uring_setup) && defined(IORING_SETUP_SQE128)
+#define SMC_IO_URING
+#endif
+
 #ifndef SMCPROTO_SMC
 #define SMCPROTO_SMC		0	/* SMC protocol, IPv4 */
 #define SMCPROTO_SMC6		1	/* SMC protocol, IPv6 */
 #endif
 
 int (*orig_socket)(int domain, int type, int protocol) = NULL;
+int (*orig_connect)(int sockfd, const struct sockaddr *addr, socklen_t addrlen) = NULL;
+int (*orig_listen)(int sockfd, int backlog) = NULL;
+int (*orig_getsockopt)(int sockfd, int level, int optname, void *optval,
+		       socklen_t *optlen) = NULL;
+ssize_t (*orig_send)(int sockfd, const void *buf, size_t len, int flags) = NULL;
+ssize_t (*orig_recv)(int sockfd, void *buf, size_t len, int flags) = NULL;
+ssize_t (*orig_sendmsg)(int sockfd, const struct msghdr *msg, int flags) = NULL;
+ssize_t (*orig_recvmsg)(int sockfd, struct msghdr *msg, int flags) = NULL;
+ssize_t (*orig_write)(int fd, const void *buf, size_t count) = NULL;
+ssize_t (*orig_read)(int fd, void *buf, size_t count) = NULL;
+int (*orig_close)(int fd) = NULL;
+long (*orig_syscall)(long number, ...) = NULL;
 static void *dl_handle = NULL;
-static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
 
 static void initialize(void);
 
-static int debug_mode = 0;
+/* Configuration from the environment, parsed once when the library is
+ * loaded and never changed afterwards
+ */
+static struct {
+	int	debug;
+	int	sndbuf;		/* 0 if not set */
+	int	rcvbuf;		/* 0 if not set */
+	int	policy;		/* a policy file is loaded */
+	int	learn_ttl;	/* seconds, 0 if not learning */
+	int	stats;		/* telemetry file is mapped */
+	int	latency;	/* latency histograms are kept */
+} cfg;
 
 #define GET_FUNC(x) \
 if (dl_handle) { \
@@ -56,11 +103,22 @@ if (dl_handle) { \
 	orig_ ## x=&emergency_ ## x; \
 }
 
+/* The library is installed setuid, so that it is preloaded into setuid
+ * programs as well. Variables that make it create or read files are ignored
+ * there, the files would be accessed with the privileges of the program.
+ */
+static char *getenv_nosuid(const char *name)
+{
+	if (getauxval(AT_SECURE))
+		return NULL;
+	return getenv(name);
+}
+
 static void dbg_msg(FILE *f, const char *format, ...)
 {
 	va_list vl;
 
-	if (debug_mode) {
+	if (cfg.debug) {
 		va_start(vl, format);
 		vfprintf(f, format, vl);
 		va_end(vl);
@@ -73,81 +131,1837 @@ static int emergency_socket(int domain, int type, int protocol)
 	return -1;
 }
 
-static void set_bufsize(int socket, int opt, const char *envname) {
-	char *val, *end;
-	int size;
-	int rc;
+static int emergency_connect(int sockfd, const struct sockaddr *addr,
+			     socklen_t addrlen)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static int emergency_listen(int sockfd, int backlog)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static int emergency_getsockopt(int sockfd, int level, int optname,
+				void *optval, socklen_t *optlen)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static ssize_t emergency_send(int sockfd, const void *buf, size_t len,
+			      int flags)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static ssize_t emergency_recv(int sockfd, void *buf, size_t len, int flags)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static ssize_t emergency_sendmsg(int sockfd, const struct msghdr *msg,
+				 int flags)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static ssize_t emergency_recvmsg(int sockfd, struct msghdr *msg, int flags)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static ssize_t emergency_write(int fd, const void *buf, size_t count)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static ssize_t emergency_read(int fd, void *buf, size_t count)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static int emergency_close(int fd)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+static long emergency_syscall(long number, ...)
+{
+	errno = ENOSYS;
+	return -1;
+}
+
+/* size with optional k or m suffix, -1 if invalid */
+static int parse_size(const char *val)
+{
+	char *end;
+	long size;
 
-	val = getenv(envname);
-	if (!val)
-		return;
 	size = strtol(val, &end, 10);
-	if (end != NULL) {
-		switch (toupper(*end)) {
-		case 'K': size *= 1024;
-			  break;
-		case 'M': size *= 1048576;
-			  break;
-		default:  break;
+	if (end == val || size < 0)
+		return -1;
+	switch (toupper(*end)) {
+	case 'K': size *= 1024;
+		  end++;
+		  break;
+	case 'M': size *= 1048576;
+		  end++;
+		  break;
+	default:  break;
+	}
+	if (*end || size > 0x7fffffff)
+		return -1;
+	return size;
+}
+
+/* Destination policy
+ *
+ * The file named by SMC_POLICY lists which destinations are worth an SMC
+ * handshake and which buffer sizes to use, one rule per line:
+ *
+ *	smc|tcp <address>[/<prefix length>]|any [port <port>[-<port>]]
+ *		[sndbuf <size>] [rcvbuf <size>]
+ *	listen [port <port>[-<port>]] [sndbuf <size>] [rcvbuf <size>]
+ *
+ * The rules are compiled into one binary trie per address family at init.
+ * connect() takes the rule of the longest matching prefix, among rules of
+ * the same prefix the first one matching the port. Destinations without a
+ * matching rule use SMC. listen() takes the first listen rule matching the
+ * local port.
+ */
+struct smc_rule {
+	struct smc_rule	*next;		/* next rule of the same prefix */
+	int		port_lo;
+	int		port_hi;
+	int		use_smc;
+	int		sndbuf;		/* 0 if not set */
+	int		rcvbuf;		/* 0 if not set */
+};
+
+struct smc_trie_node {
+	int		child[2];	/* node index, 0 if none */
+	struct smc_rule	*rules;
+};
+
+struct smc_trie {
+	struct smc_trie_node	*nodes;	/* nodes[0] is the root */
+	int			cnt;
+	int			size;
+};
+
+static struct smc_trie policy_v4, policy_v6;
+static struct smc_rule *listen_rules;
+static struct smc_rule **listen_tail = &listen_rules;
+
+static int trie_new_node(struct smc_trie *t)
+{
+	struct smc_trie_node *nodes;
+
+	if (t->cnt == t->size) {
+		nodes = realloc(t->nodes, (t->size ? 2 * t->size : 64) *
+				sizeof(*nodes));
+		if (!nodes)
+			return -1;
+		t->nodes = nodes;
+		t->size = t->size ? 2 * t->size : 64;
+	}
+	memset(&t->nodes[t->cnt], 0, sizeof(*nodes));
+
+	return t->cnt++;
+}
+
+static inline int addr_bit(const unsigned char *addr, int i)
+{
+	return (addr[i / 8] >> (7 - i % 8)) & 1;
+}
+
+static int trie_insert(struct smc_trie *t, const unsigned char *addr,
+		       int plen, struct smc_rule *rule)
+{
+	struct smc_rule **pp;
+	int n = 0, i, b, c;
+
+	if (!t->cnt && trie_new_node(t) < 0)
+		return -1;
+	for (i = 0; i < plen; i++) {
+		b = addr_bit(addr, i);
+		if (!t->nodes[n].child[b]) {
+			c = trie_new_node(t);
+			if (c < 0)
+				return -1;
+			t->nodes[n].child[b] = c;
 		}
+		n = t->nodes[n].child[b];
 	}
-	rc = setsockopt(socket, SOL_SOCKET, opt, &size, sizeof(size));
-	dbg_msg(stderr, "sockopt %d set to %d\n", opt, size, rc);
+	for (pp = &t->nodes[n].rules; *pp; pp = &(*pp)->next)
+		;
+	*pp = rule;
+
+	return 0;
 }
 
-int socket(int domain, int type, int protocol)
+/* rule of the longest prefix matching addr and port, walks at most bits
+ * nodes
+ */
+static struct smc_rule *trie_lookup(const struct smc_trie *t,
+				    const unsigned char *addr, int bits,
+				    int port)
 {
-	int rc;
+	struct smc_rule *best = NULL, *r;
+	int n = 0, i = 0;
 
-	if (!orig_socket)
-		initialize();
+	if (!t->cnt)
+		return NULL;
+	while (1) {
+		for (r = t->nodes[n].rules; r; r = r->next) {
+			if (port >= r->port_lo && port <= r->port_hi) {
+				best = r;
+				break;
+			}
+		}
+		if (i == bits)
+			break;
+		n = t->nodes[n].child[addr_bit(addr, i++)];
+		if (!n)
+			break;
+	}
 
-	/* check if socket is eligible for AF_SMC */
-	if ((domain == AF_INET || domain == AF_INET6) &&
-	    // see kernel code, include/linux/net.h, SOCK_TYPE_MASK
-	    (type & 0xf) == SOCK_STREAM &&
-	    (protocol == IPPROTO_IP || protocol == IPPROTO_TCP)) {
-		dbg_msg(stderr, "libsmc-preload: map sock to AF_SMC\n");
-		if (domain == AF_INET)
-			protocol = SMCPROTO_SMC;
-		else /* AF_INET6 */
-			protocol = SMCPROTO_SMC6;
+	return best;
+}
 
-		domain = AF_SMC;
+#define POLICY_DELIM	" \t\n"
+
+static int parse_policy_line(char *line, const char *fname, int lineno)
+{
+	char *tok, *val, *save, *slash, *end;
+	struct smc_rule *rule, *rule6;
+	unsigned char addr[16];
+	int family, plen;
+	long lo, hi;
+
+	tok = strtok_r(line, POLICY_DELIM, &save);
+	if (!tok || tok[0] == '#')
+		return 0;
+	rule = calloc(1, sizeof(*rule));
+	if (!rule)
+		return -1;
+	rule->port_hi = 65535;
+	family = AF_UNSPEC;
+	plen = 0;
+	if (!strcmp(tok, "smc"))
+		rule->use_smc = 1;
+	else if (!strcmp(tok, "listen"))
+		family = -1;
+	else if (strcmp(tok, "tcp"))
+		goto errout;
+
+	if (family != -1) {
+		tok = strtok_r(NULL, POLICY_DELIM, &save);
+		if (!tok)
+			goto errout;
+		memset(addr, 0, sizeof(addr));
+		slash = strchr(tok, '/');
+		if (slash)
+			*slash++ = '\0';
+		if (!strcmp(tok, "any") && !slash)
+			family = AF_UNSPEC;
+		else if (inet_pton(AF_INET, tok, addr) == 1)
+			family = AF_INET;
+		else if (inet_pton(AF_INET6, tok, addr) == 1)
+			family = AF_INET6;
+		else
+			goto errout;
+		if (family != AF_UNSPEC)
+			plen = family == AF_INET ? 32 : 128;
+		if (slash) {
+			lo = strtol(slash, &end, 10);
+			if (*end || end == slash || lo < 0 || lo > plen)
+				goto errout;
+			plen = lo;
+		}
 	}
 
-	rc = (*orig_socket)(domain, type, protocol);
-	if (rc != -1) {
-		set_bufsize(rc, SO_SNDBUF, "SMC_SNDBUF");
-		set_bufsize(rc, SO_RCVBUF, "SMC_RCVBUF");
+	while ((tok = strtok_r(NULL, POLICY_DELIM, &save))) {
+		val = strtok_r(NULL, POLICY_DELIM, &save);
+		if (!val)
+			goto errout;
+		if (!strcmp(tok, "port")) {
+			lo = strtol(val, &end, 10);
+			hi = lo;
+			if (*end == '-')
+				hi = strtol(end + 1, &end, 10);
+			if (*end || end == val || lo < 0 || hi > 65535 || lo > hi)
+				goto errout;
+			rule->port_lo = lo;
+			rule->port_hi = hi;
+		} else if (!strcmp(tok, "sndbuf")) {
+			rule->sndbuf = parse_size(val);
+			if (rule->sndbuf <= 0)
+				goto errout;
+		} else if (!strcmp(tok, "rcvbuf")) {
+			rule->rcvbuf = parse_size(val);
+			if (rule->rcvbuf <= 0)
+				goto errout;
+		} else {
+			goto errout;
+		}
+	}
+
+	switch (family) {
+	case -1:
+		*listen_tail = rule;
+		listen_tail = &rule->next;
+		return 0;
+	case AF_INET:
+		return trie_insert(&policy_v4, addr, plen, rule);
+	case AF_INET6:
+		return trie_insert(&policy_v6, addr, plen, rule);
+	default:	/* any */
+		rule6 = malloc(sizeof(*rule6));
+		if (!rule6)
+			return -1;
+		memcpy(rule6, rule, sizeof(*rule6));
+		if (trie_insert(&policy_v4, addr, 0, rule))
+			return -1;
+		return trie_insert(&policy_v6, addr, 0, rule6);
+	}
+errout:
+	fprintf(stderr, "libsmc-preload: %s:%d: invalid rule ignored\n",
+		fname, lineno);
+	free(rule);
+	return 0;
+}
+
+static void load_policy(const char *var_name)
+{
+	char *fname, line[256];
+	int lineno = 0;
+	FILE *fp;
+
+	fname = getenv_nosuid(var_name);
+	if (!fname || !fname[0])
+		return;
+	fp = fopen(fname, "re");
+	if (!fp) {
+		fprintf(stderr, "libsmc-preload: cannot open policy file %s: %s\n",
+			fname, strerror(errno));
+		return;
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		if (parse_policy_line(line, fname, ++lineno) < 0) {
+			fprintf(stderr, "libsmc-preload: out of memory\n");
+			break;
+		}
+	}
+	fclose(fp);
+	cfg.policy = policy_v4.cnt || policy_v6.cnt || listen_rules;
+	dbg_msg(stderr, "libsmc-preload: policy %s loaded, %d/%d trie nodes\n",
+		fname, policy_v4.cnt, policy_v6.cnt);
+}
+
+/* rule for a connect() destination, NULL if none matches */
+static struct smc_rule *policy_lookup(const struct sockaddr *addr,
+				      socklen_t addrlen)
+{
+	const struct sockaddr_in6 *sin6;
+	const struct sockaddr_in *sin;
+
+	if (addr->sa_family == AF_INET && addrlen >= sizeof(*sin)) {
+		sin = (const struct sockaddr_in *)addr;
+		return trie_lookup(&policy_v4,
+				   (const unsigned char *)&sin->sin_addr, 32,
+				   ntohs(sin->sin_port));
+	}
+	if (addr->sa_family == AF_INET6 && addrlen >= sizeof(*sin6)) {
+		sin6 = (const struct sockaddr_in6 *)addr;
+		if (IN6_IS_ADDR_V4MAPPED(&sin6->sin6_addr))
+			return trie_lookup(&policy_v4,
+					   &sin6->sin6_addr.s6_addr[12], 32,
+					   ntohs(sin6->sin6_port));
+		return trie_lookup(&policy_v6, sin6->sin6_addr.s6_addr, 128,
+				   ntohs(sin6->sin6_port));
+	}
+
+	return NULL;
+}
+
+#define SMC_FDS_MAX		1048576
+
+/* number of descriptors covered by tables indexed by descriptor */
+static int fd_table_size(void)
+{
+	struct rlimit rl;
+
+	if (getrlimit(RLIMIT_NOFILE, &rl) || rl.rlim_cur > SMC_FDS_MAX)
+		return SMC_FDS_MAX;
+	return rl.rlim_cur;
+}
+
+/* Learned fallbacks
+ *
+ * With SMC_LEARN=<seconds> set, the mode of an AF_SMC socket connected to a
+ * peer (address and port) not seen within that time is looked up via
+ * sock_diag. The lookup dumps the SMC sockets of the host, it is therefore
+ * done with the first send or receive call on the socket rather than in
+ * connect(), which covers non-blocking connects as well, and only one lookup
+ * per peer is in flight at a time. Peers that fell back to TCP
+ * SMC_LEARN_FAILS times in a row are connected via TCP for the given time,
+ * peers that did SMC are not looked up again for that time. With SMC_STATS
+ * set, every connect is looked up to count the fallbacks. The table is a
+ * direct mapped cache shared by all threads, its fields are accessed with
+ * relaxed atomics only: a collision evicts the older peer, a torn read yields
+ * stale data.
+ */
+#define SMC_LEARN_SLOTS		1024
+#define SMC_LEARN_FAILS		2
+#define SMC_LEARN_CLAIM		5	/* seconds a lookup may stay pending */
+
+struct smc_learn_slot {
+	unsigned long	tag;		/* hash of the peer, 0 if unused */
+	uint32_t	expires;	/* CLOCK_MONOTONIC seconds */
+	uint32_t	fails;		/* fallbacks in a row, 0 if SMC worked */
+	uint32_t	claim;		/* lookup pending until, seconds */
+};
+
+static struct smc_learn_slot learn_tab[SMC_LEARN_SLOTS];
+/* peer tag of the connected socket per descriptor, 0 if no lookup pending */
+static unsigned long *learn_fds;
+static int learn_nfds;
+
+static uint32_t now_sec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	return ts.tv_sec;
+}
+
+static uint64_t hash_bytes(uint64_t h, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	while (len--) {
+		h ^= *p++;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+/* hash of a connect() destination, 0 if it is not an IP address */
+static unsigned long peer_tag(const struct sockaddr *addr, socklen_t addrlen)
+{
+	const struct sockaddr_in6 *sin6;
+	const struct sockaddr_in *sin;
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	if (addr->sa_family == AF_INET && addrlen >= sizeof(*sin)) {
+		sin = (const struct sockaddr_in *)addr;
+		h = hash_bytes(h, &sin->sin_addr, 4);
+		h = hash_bytes(h, &sin->sin_port, 2);
+	} else if (addr->sa_family == AF_INET6 && addrlen >= sizeof(*sin6)) {
+		sin6 = (const struct sockaddr_in6 *)addr;
+		if (IN6_IS_ADDR_V4MAPPED(&sin6->sin6_addr))
+			h = hash_bytes(h, &sin6->sin6_addr.s6_addr[12], 4);
+		else
+			h = hash_bytes(h, &sin6->sin6_addr, 16);
+		h = hash_bytes(h, &sin6->sin6_port, 2);
+	} else {
+		return 0;
+	}
+
+	return (unsigned long)h | 1;
+}
+
+/* fallbacks in a row of a peer, -1 if unknown or expired */
+static int learn_state(unsigned long tag)
+{
+	struct smc_learn_slot *slot = &learn_tab[tag % SMC_LEARN_SLOTS];
+
+	if (__atomic_load_n(&slot->tag, __ATOMIC_RELAXED) != tag ||
+	    (int32_t)(__atomic_load_n(&slot->expires, __ATOMIC_RELAXED) -
+		      now_sec()) <= 0)
+		return -1;
+
+	return __atomic_load_n(&slot->fails, __ATOMIC_RELAXED);
+}
+
+static void learn_result(unsigned long tag, int fallback)
+{
+	struct smc_learn_slot *slot = &learn_tab[tag % SMC_LEARN_SLOTS];
+	int fails = 0;
+
+	if (fallback) {
+		fails = learn_state(tag);
+		fails = fails < 0 ? 1 : fails + 1;
 	}
+	__atomic_store_n(&slot->tag, tag, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->fails, fails, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->expires, now_sec() + cfg.learn_ttl, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->claim, 0, __ATOMIC_RELAXED);
+}
+
+/* return 1 if the caller may look up the mode of a connect to the peer,
+ * a claim not released, e.g. for a socket closed without any data
+ * transferred, expires after SMC_LEARN_CLAIM seconds
+ */
+static int learn_claim(unsigned long tag)
+{
+	struct smc_learn_slot *slot = &learn_tab[tag % SMC_LEARN_SLOTS];
+	uint32_t now = now_sec(), claim;
+
+	claim = __atomic_load_n(&slot->claim, __ATOMIC_RELAXED);
+	if ((int32_t)(claim - now) > 0)
+		return 0;
+
+	return __atomic_compare_exchange_n(&slot->claim, &claim,
+					   now + SMC_LEARN_CLAIM, 0,
+					   __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+static void learn_unclaim(unsigned long tag)
+{
+	__atomic_store_n(&learn_tab[tag % SMC_LEARN_SLOTS].claim, 0,
+			 __ATOMIC_RELAXED);
+}
 
+/* Look up the mode of the connected AF_SMC socket sockfd via sock_diag,
+ * return 1 if it fell back to TCP, 0 if it uses SMC and -1 on errors
+ */
+static int smc_fell_back(int sockfd)
+{
+	struct sockaddr_nl nladdr = { .nl_family = AF_NETLINK };
+	struct {
+		struct nlmsghdr		nlh;
+		struct smc_diag_req	r;
+	} req;
+	long buf[8192 / sizeof(long)];
+	struct smc_diag_msg *msg;
+	struct nlmsghdr *h;
+	int fd, len, rc = -1;
+	struct stat st;
+
+	if (fstat(sockfd, &st))
+		return -1;
+	fd = (*orig_socket)(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC,
+			    NETLINK_SOCK_DIAG);
+	if (fd < 0)
+		return -1;
+	memset(&req, 0, sizeof(req));
+	req.nlh.nlmsg_len = sizeof(req);
+	req.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+	req.nlh.nlmsg_flags = NLM_F_ROOT | NLM_F_MATCH | NLM_F_REQUEST;
+	req.r.diag_family = PF_SMC;
+	if (sendto(fd, &req, sizeof(req), 0, (struct sockaddr *)&nladdr,
+		   sizeof(nladdr)) < 0)
+		goto out;
+	while ((len = recv(fd, buf, sizeof(buf), 0)) > 0) {
+		for (h = (struct nlmsghdr *)buf; NLMSG_OK(h, len);
+		     h = NLMSG_NEXT(h, len)) {
+			if (h->nlmsg_type == NLMSG_DONE ||
+			    h->nlmsg_type == NLMSG_ERROR)
+				goto out;
+			if (h->nlmsg_len < NLMSG_LENGTH(sizeof(*msg)))
+				continue;
+			msg = NLMSG_DATA(h);
+			if (msg->diag_inode == st.st_ino) {
+				/* the rest of the dump is dropped with fd */
+				rc = msg->diag_mode == SMC_DIAG_MODE_FALLBACK_TCP;
+				goto out;
+			}
+		}
+	}
+out:
+	close(fd);
 	return rc;
 }
 
-static void set_debug_mode(const char *var_name)
+/* Telemetry
+ *
+ * With SMC_STATS set, the library counts its decisions in the file
+ * /dev/shm/smc_run.<pid> while the process runs, smc_run -s <pid> shows them.
+ * The file is created with the first count.
+ * Each thread counts in a slot of its own, so a count is a plain increment.
+ * The slots of exited threads are added to the retired slot and reused.
+ * The file consists of 64 bit words: the header, the retired slot and
+ * SMC_STAT_SLOTS thread slots, each slot is a word telling whether it is
+ * used followed by SMC_STAT_MAX counters.
+ */
+#define SMC_STAT_MAGIC		0x534d4353544154ULL	/* "SMCSTAT" */
+#define SMC_STAT_VERSION	1
+#define SMC_STAT_SLOTS		256
+#define SMC_STAT_LAT_BUCKETS	20	/* log2 buckets of microseconds */
+
+enum {
+	SMC_STAT_MAPPED,	/* sockets mapped to AF_SMC */
+	SMC_STAT_CONNECTS,	/* connects of AF_SMC sockets */
+	SMC_STAT_POLICY_TCP,	/* switched to TCP by the policy */
+	SMC_STAT_LEARNED_TCP,	/* switched to TCP by learned fallbacks */
+	SMC_STAT_FALLBACKS,	/* fallbacks to TCP detected */
+	SMC_STAT_LAT,		/* connect latency histogram */
+	SMC_STAT_MAX = SMC_STAT_LAT + SMC_STAT_LAT_BUCKETS
+};
+
+struct smc_stat_slot {
+	uint64_t	used;
+	uint64_t	cnt[SMC_STAT_MAX];
+};
+
+struct smc_stat_file {
+	uint64_t		magic;
+	uint64_t		version;
+	uint64_t		nslots;
+	uint64_t		nstats;
+	struct smc_stat_slot	retired;
+	struct smc_stat_slot	slot[SMC_STAT_SLOTS];
+};
+
+static struct smc_stat_file *stat_file;
+static __thread struct smc_stat_slot *stat_slot;
+static pthread_once_t stat_once = PTHREAD_ONCE_INIT;
+static pthread_key_t stat_key;
+static char stat_path[64];
+
+static void stat_map(void);
+
+/* thread exit: hand the counts over to the retired slot */
+static void stat_release(void *arg)
 {
-	char *var_value;
+	struct smc_stat_slot *slot = arg;
+	int i;
 
-	var_value = getenv(var_name);
-	debug_mode = 0;
-	if (var_value != NULL)
-		debug_mode = (var_value[0] != '0');
+	for (i = 0; i < SMC_STAT_MAX; i++) {
+		__atomic_fetch_add(&stat_file->retired.cnt[i], slot->cnt[i],
+				   __ATOMIC_RELAXED);
+		slot->cnt[i] = 0;
+	}
+	__atomic_store_n(&slot->used, 0, __ATOMIC_RELEASE);
 }
 
-static void initialize(void)
+static struct smc_stat_slot *stat_claim(void)
+{
+	uint64_t unused;
+	int i;
+
+	for (i = 0; i < SMC_STAT_SLOTS; i++) {
+		unused = 0;
+		if (__atomic_compare_exchange_n(&stat_file->slot[i].used,
+						&unused, 1, 0, __ATOMIC_ACQUIRE,
+						__ATOMIC_RELAXED)) {
+			stat_slot = &stat_file->slot[i];
+			pthread_setspecific(stat_key, stat_slot);
+			return stat_slot;
+		}
+	}
+	/* all slots taken, count in the retired one */
+	return NULL;
+}
+
+static inline void stat_add(int stat, uint64_t val)
 {
-	pthread_mutex_lock(&mutex);
-	if (orig_socket) {
-		pthread_mutex_unlock(&mutex);
+	struct smc_stat_slot *slot = stat_slot;
+
+	if (!cfg.stats)
 		return;
+	if (!slot) {
+		if (!stat_file)
+			pthread_once(&stat_once, stat_map);
+		if (!stat_file)
+			return;
+		slot = stat_claim();
+		if (!slot) {
+			__atomic_fetch_add(&stat_file->retired.cnt[stat], val,
+					   __ATOMIC_RELAXED);
+			return;
+		}
 	}
+	slot->cnt[stat] += val;
+}
 
-	set_debug_mode("SMC_DEBUG");
+static inline void stat_inc(int stat)
+{
+	stat_add(stat, 1);
+}
 
-	dl_handle = dlopen(LIBC_SO, DLOPEN_FLAG);
-	if (!dl_handle)
-		dbg_msg(stderr, "dlopen failed: %s\n", dlerror());
-	GET_FUNC(socket);
-	pthread_mutex_unlock(&mutex);
+static uint64_t now_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void stat_latency(uint64_t usec)
+{
+	int b = 0;
+
+	while (usec > 1 && b < SMC_STAT_LAT_BUCKETS - 1) {
+		usec >>= 1;
+		b++;
+	}
+	stat_inc(SMC_STAT_LAT + b);
+}
+
+static void stat_map(void)
+{
+	struct smc_stat_file *file;
+	int fd;
+
+	snprintf(stat_path, sizeof(stat_path), "/dev/shm/smc_run.%d", getpid());
+	/* left over from an earlier process with this pid; never open a file
+	 * that someone else created there
+	 */
+	unlink(stat_path);
+	fd = open(stat_path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+		  0600);
+	if (fd < 0)
+		goto errout;
+	if (ftruncate(fd, sizeof(*file))) {
+		close(fd);
+		goto errunlink;
+	}
+	file = mmap(NULL, sizeof(*file), PROT_READ | PROT_WRITE, MAP_SHARED,
+		    fd, 0);
+	close(fd);
+	if (file == MAP_FAILED)
+		goto errunlink;
+	file->version = SMC_STAT_VERSION;
+	file->nslots = SMC_STAT_SLOTS;
+	file->nstats = SMC_STAT_MAX;
+	__atomic_store_n(&file->magic, SMC_STAT_MAGIC, __ATOMIC_RELEASE);
+	stat_file = file;
+	return;
+
+errunlink:
+	unlink(stat_path);
+errout:
+	fprintf(stderr, "libsmc-preload: cannot create %s: %s\n", stat_path,
+		strerror(errno));
+	cfg.stats = 0;
+}
+
+/* a forked child counts in a file of its own */
+static void stat_atfork_child(void)
+{
+	if (stat_file)
+		munmap(stat_file, sizeof(*stat_file));
+	stat_file = NULL;
+	stat_slot = NULL;
+	/* the slot is gone, stat_release() must not run on thread exit */
+	pthread_setspecific(stat_key, NULL);
+	stat_once = PTHREAD_ONCE_INIT;
+}
+
+static void set_stats(const char *var_name)
+{
+	char *val;
+
+	val = getenv_nosuid(var_name);
+	if (!val || !val[0] || val[0] == '0')
+		return;
+	if (pthread_key_create(&stat_key, stat_release))
+		return;
+	pthread_atfork(NULL, NULL, stat_atfork_child);
+	cfg.stats = 1;
+}
+
+static void __attribute__((destructor)) stat_unlink(void)
+{
+	if (stat_file)
+		unlink(stat_path);
+}
+
+/* Connect latency
+ *
+ * With SMC_LATENCY=<file> set, the library measures for each peer how long
+ * connects take until the connection is established, separately for SMC and
+ * TCP sockets. A connect that does not complete right away, e.g. a
+ * non-blocking one waited for with poll or epoll, completes when the program
+ * checks its result with getsockopt(SO_ERROR) and finds the socket connected.
+ * Connects whose result is not checked that way, but found with the first
+ * send or receive call, are not measured: that call comes after whatever the
+ * program did in between. Histograms are log-linear: each power of two of
+ * microseconds is split into SMC_LAT_SUB buckets. They are written to
+ * <file>.<pid> at exit and on SIGUSR2 if the program does not handle that
+ * signal itself, with the next intercepted call after the signal.
+ */
+#define SMC_LAT_PEERS		256
+#define SMC_LAT_HASH		(2 * SMC_LAT_PEERS)	/* power of two */
+#define SMC_LAT_SUB		4	/* buckets per power of two */
+#define SMC_LAT_BUCKETS		100	/* up to 2^26 us, about 67 seconds */
+
+struct smc_lat_peer {
+	int		smc;		/* AF_SMC socket */
+	unsigned char	addr[16];	/* IPv4 addresses are mapped */
+	int		port;
+	uint64_t	count;
+	uint64_t	sum;
+	uint64_t	min;
+	uint64_t	max;
+	uint32_t	bucket[SMC_LAT_BUCKETS];
+};
+
+/* measurement in progress on a socket */
+struct smc_lat_fd {
+	uint64_t	start;		/* usec, 0 if none */
+	int		peer;		/* index into lat_peers */
+};
+
+static struct smc_lat_peer lat_peers[SMC_LAT_PEERS];
+static int lat_npeers;
+/* open addressing, index into lat_peers + 1, 0 if free */
+static short lat_hash[SMC_LAT_HASH];
+static uint64_t lat_dropped;	/* measurements of peers not in the table */
+static struct smc_lat_fd *lat_fds;
+static int lat_nfds;
+static pthread_mutex_t lat_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile sig_atomic_t lat_dump_req;
+static char *lat_path;
+
+static int lat_bucket(uint64_t usec)
+{
+	int e;
+
+	if (usec < SMC_LAT_SUB)
+		return usec;
+	for (e = 63; !(usec >> e); e--)
+		;
+	/* e >= 2, the two bits below the top one select the bucket */
+	e = SMC_LAT_SUB * (e - 1) + ((usec >> (e - 2)) & (SMC_LAT_SUB - 1));
+
+	return e < SMC_LAT_BUCKETS ? e : SMC_LAT_BUCKETS - 1;
+}
+
+/* lowest value of bucket b */
+static uint64_t lat_bucket_lo(int b)
+{
+	if (b < SMC_LAT_SUB)
+		return b;
+	return (uint64_t)(SMC_LAT_SUB + b % SMC_LAT_SUB) << (b / SMC_LAT_SUB - 1);
+}
+
+/* peer index for addr, -1 if the table is full or addr is not IP */
+static int lat_peer(const struct sockaddr *addr, int smc)
+{
+	const struct sockaddr_in6 *sin6;
+	const struct sockaddr_in *sin;
+	struct smc_lat_peer *p;
+	unsigned char a[16];
+	int i, port;
+	uint64_t h;
+
+	if (addr->sa_family == AF_INET) {
+		sin = (const struct sockaddr_in *)addr;
+		memset(a, 0, 10);
+		a[10] = a[11] = 0xff;
+		memcpy(&a[12], &sin->sin_addr, 4);
+		port = ntohs(sin->sin_port);
+	} else if (addr->sa_family == AF_INET6) {
+		sin6 = (const struct sockaddr_in6 *)addr;
+		memcpy(a, &sin6->sin6_addr, 16);
+		port = ntohs(sin6->sin6_port);
+	} else {
+		return -1;
+	}
+	h = hash_bytes(0xcbf29ce484222325ULL, a, 16);
+	h = hash_bytes(h, &port, sizeof(port));
+	h = hash_bytes(h, &smc, sizeof(smc));
+
+	pthread_mutex_lock(&lat_mutex);
+	/* at most half of the slots are used, the probing ends */
+	for (h &= SMC_LAT_HASH - 1; lat_hash[h]; h = (h + 1) & (SMC_LAT_HASH - 1)) {
+		i = lat_hash[h] - 1;
+		p = &lat_peers[i];
+		if (p->smc == smc && p->port == port && !memcmp(p->addr, a, 16))
+			goto out;
+	}
+	if (lat_npeers == SMC_LAT_PEERS) {
+		i = -1;
+		goto out;
+	}
+	p = &lat_peers[lat_npeers];
+	memset(p, 0, sizeof(*p));
+	p->smc = smc;
+	p->port = port;
+	memcpy(p->addr, a, 16);
+	i = lat_npeers++;
+	lat_hash[h] = lat_npeers;
+out:
+	pthread_mutex_unlock(&lat_mutex);
+	return i;
+}
+
+static void lat_record(int peer, uint64_t usec)
+{
+	struct smc_lat_peer *p;
+
+	pthread_mutex_lock(&lat_mutex);
+	if (peer < 0) {
+		lat_dropped++;
+		goto out;
+	}
+	p = &lat_peers[peer];
+	if (!p->count || usec < p->min)
+		p->min = usec;
+	if (usec > p->max)
+		p->max = usec;
+	p->count++;
+	p->sum += usec;
+	p->bucket[lat_bucket(usec)]++;
+out:
+	pthread_mutex_unlock(&lat_mutex);
+}
+
+/* upper end of the bucket holding quantile q of p, capped at the maximum */
+static uint64_t lat_quantile(const struct smc_lat_peer *p, double q)
+{
+	uint64_t n = 0, rank;
+	int b;
+
+	rank = q * p->count + 0.5;
+	if (!rank)
+		rank = 1;
+	for (b = 0; b < SMC_LAT_BUCKETS - 1; b++) {
+		n += p->bucket[b];
+		if (n >= rank)
+			break;
+	}
+	if (b == SMC_LAT_BUCKETS - 1)
+		return p->max;
+
+	return MIN(lat_bucket_lo(b + 1) - 1, p->max);
+}
+
+static void lat_dump(void)
+{
+	char path[PATH_MAX], tmp[PATH_MAX + 8], addr[INET6_ADDRSTRLEN];
+	const struct smc_lat_peer *p;
+	int i, b, fd;
+	FILE *fp;
+
+	lat_dump_req = 0;
+	snprintf(path, sizeof(path), "%s.%d", lat_path, getpid());
+	/* written to a new file that replaces the old one, so that an existing
+	 * file or symlink of that name is never written to
+	 */
+	snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+	fd = mkstemp(tmp);
+	if (fd < 0 || fcntl(fd, F_SETFD, FD_CLOEXEC) || fchmod(fd, 0644) ||
+	    !(fp = fdopen(fd, "w"))) {
+		fprintf(stderr, "libsmc-preload: cannot write %s: %s\n", path,
+			strerror(errno));
+		if (fd >= 0) {
+			close(fd);
+			unlink(tmp);
+		}
+		return;
+	}
+	pthread_mutex_lock(&lat_mutex);
+	fprintf(fp, "# connect latency of process %d in microseconds\n",
+		getpid());
+	for (i = 0; i < lat_npeers; i++) {
+		p = &lat_peers[i];
+		if (!p->count)
+			continue;
+		if (IN6_IS_ADDR_V4MAPPED((const struct in6_addr *)p->addr))
+			inet_ntop(AF_INET, &p->addr[12], addr, sizeof(addr));
+		else
+			inet_ntop(AF_INET6, p->addr, addr, sizeof(addr));
+		fprintf(fp, "connect %s %s port %d count %" PRIu64 " min %" PRIu64 " avg %" PRIu64
+			" p50 %" PRIu64 " p90 %" PRIu64 " p99 %" PRIu64
+			" max %" PRIu64 "\n", p->smc ? "smc" : "tcp", addr,
+			p->port, p->count, p->min, p->sum / p->count,
+			lat_quantile(p, 0.5), lat_quantile(p, 0.9),
+			lat_quantile(p, 0.99), p->max);
+		for (b = 0; b < SMC_LAT_BUCKETS; b++) {
+			if (!p->bucket[b])
+				continue;
+			if (b < SMC_LAT_BUCKETS - 1)
+				fprintf(fp, "\t%" PRIu64 "-%" PRIu64 " %u\n",
+					lat_bucket_lo(b), lat_bucket_lo(b + 1) - 1,
+					p->bucket[b]);
+			else
+				fprintf(fp, "\t%" PRIu64 "- %u\n",
+					lat_bucket_lo(b), p->bucket[b]);
+		}
+	}
+	if (lat_dropped)
+		fprintf(fp, "# %" PRIu64 " measurements of further peers dropped\n",
+			lat_dropped);
+	pthread_mutex_unlock(&lat_mutex);
+	if (fclose(fp) || rename(tmp, path)) {
+		fprintf(stderr, "libsmc-preload: cannot write %s: %s\n", path,
+			strerror(errno));
+		unlink(tmp);
+	}
+}
+
+static void lat_signal(int sig)
+{
+	lat_dump_req = 1;
+}
+
+/* a connect to addr on sockfd started at start */
+static void lat_connect(int sockfd, const struct sockaddr *addr,
+			uint64_t start, int rc, int err)
+{
+	int domain, type, peer;
+	socklen_t len;
+
+	if ((addr->sa_family != AF_INET && addr->sa_family != AF_INET6) ||
+	    (rc && err != EINPROGRESS && err != EINTR))
+		return;
+	len = sizeof(type);
+	if (getsockopt(sockfd, SOL_SOCKET, SO_TYPE, &type, &len) ||
+	    type != SOCK_STREAM)
+		return;
+	len = sizeof(domain);
+	if (getsockopt(sockfd, SOL_SOCKET, SO_DOMAIN, &domain, &len))
+		return;
+	peer = lat_peer(addr, domain == AF_SMC);
+	if (!rc) {
+		lat_record(peer, now_usec() - start);
+	} else if (sockfd < lat_nfds) {
+		lat_fds[sockfd].peer = peer;
+		lat_fds[sockfd].start = start;
+	}
+}
+
+/* getsockopt(SO_ERROR) on fd returned soerr */
+static void lat_so_error(int fd, int soerr)
+{
+	struct sockaddr_storage peer;
+	struct smc_lat_fd *p;
+	socklen_t len;
+
+	if (fd < 0 || fd >= lat_nfds || !lat_fds[fd].start)
+		return;
+	p = &lat_fds[fd];
+	/* 0 while connecting, too */
+	len = sizeof(peer);
+	if (!soerr && getpeername(fd, (struct sockaddr *)&peer, &len)) {
+		if (errno == ENOTCONN)
+			return;
+	} else if (!soerr) {
+		lat_record(p->peer, now_usec() - p->start);
+	}
+	p->start = 0;
+}
+
+/* a send or receive call on fd */
+static void lat_io(int fd)
+{
+	int err = errno;
+
+	if (lat_dump_req)
+		lat_dump();
+	/* the connect result was not checked with SO_ERROR */
+	if (fd >= 0 && fd < lat_nfds && lat_fds[fd].start)
+		lat_fds[fd].start = 0;
+	errno = err;
+}
+
+static inline void lat_forget(int fd)
+{
+	if (fd >= 0 && fd < lat_nfds)
+		lat_fds[fd].start = 0;
+}
+
+/* no other thread may hold lat_mutex while forking, it would stay locked
+ * in the child
+ */
+static void lat_atfork_prepare(void)
+{
+	pthread_mutex_lock(&lat_mutex);
+}
+
+static void lat_atfork_parent(void)
+{
+	pthread_mutex_unlock(&lat_mutex);
+}
+
+/* a forked child measures in a file of its own */
+static void lat_atfork_child(void)
+{
+	lat_npeers = 0;
+	lat_dropped = 0;
+	memset(lat_hash, 0, sizeof(lat_hash));
+	memset(lat_fds, 0, lat_nfds * sizeof(*lat_fds));
+	pthread_mutex_unlock(&lat_mutex);
+}
+
+static void set_latency(const char *var_name)
+{
+	struct sigaction sa;
+	char *val;
+	int nfds;
+
+	val = getenv_nosuid(var_name);
+	if (!val || !val[0])
+		return;
+	nfds = fd_table_size();
+	lat_fds = calloc(nfds, sizeof(*lat_fds));
+	if (!lat_fds) {
+		fprintf(stderr, "libsmc-preload: out of memory\n");
+		return;
+	}
+	lat_nfds = nfds;
+	lat_path = val;
+	pthread_atfork(lat_atfork_prepare, lat_atfork_parent,
+		       lat_atfork_child);
+	if (!sigaction(SIGUSR2, NULL, &sa) && sa.sa_handler == SIG_DFL) {
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_handler = lat_signal;
+		sa.sa_flags = SA_RESTART;
+		sigaction(SIGUSR2, &sa, NULL);
+	}
+	cfg.latency = 1;
+}
+
+/* no file for processes that did not connect */
+static void __attribute__((destructor)) lat_exit(void)
+{
+	if (cfg.latency && (lat_npeers || lat_dropped))
+		lat_dump();
+}
+
+/* a connect of sockfd to the peer with tag returned rc with errno err, look
+ * up its mode with the first send or receive call
+ */
+static void learn_defer(int sockfd, unsigned long tag, int rc, int err)
+{
+	if (sockfd < learn_nfds &&
+	    (!rc || err == EINPROGRESS || err == EINTR))
+		__atomic_store_n(&learn_fds[sockfd], tag, __ATOMIC_RELAXED);
+	else
+		learn_unclaim(tag);
+}
+
+/* a send or receive call on fd returned rc */
+static void learn_io(int fd, ssize_t rc)
+{
+	unsigned long tag;
+	int err = errno;
+	int state;
+
+	if (fd < 0 || fd >= learn_nfds ||
+	    !__atomic_load_n(&learn_fds[fd], __ATOMIC_RELAXED))
+		return;
+	/* send and receive fail with EAGAIN while connecting, too */
+	if (rc < 0 && (err == EAGAIN || err == EWOULDBLOCK || err == EINTR))
+		return;
+	tag = __atomic_exchange_n(&learn_fds[fd], 0, __ATOMIC_RELAXED);
+	if (!tag)
+		return;
+	/* a failed connect leaves nothing to learn */
+	state = rc < 0 ? -1 : smc_fell_back(fd);
+	if (state < 0) {
+		learn_unclaim(tag);
+		goto out;
+	}
+	if (cfg.learn_ttl)
+		learn_result(tag, state);
+	if (state > 0)
+		stat_inc(SMC_STAT_FALLBACKS);
+	dbg_msg(stderr, "libsmc-preload: sock %d %s\n", fd,
+		state > 0 ? "fell back to TCP" : "uses SMC");
+out:
+	errno = err;
+}
+
+static inline void learn_forget(int fd)
+{
+	unsigned long tag;
+
+	if (fd >= 0 && fd < learn_nfds &&
+	    (tag = __atomic_exchange_n(&learn_fds[fd], 0, __ATOMIC_RELAXED)))
+		learn_unclaim(tag);
+}
+
+/* socket options carried over when an AF_SMC socket is replaced */
+static const struct {
+	int level;
+	int opt;
+} copy_opts[] = {
+	{ SOL_SOCKET,	SO_REUSEADDR },
+	{ SOL_SOCKET,	SO_KEEPALIVE },
+	{ SOL_SOCKET,	SO_SNDBUF },
+	{ SOL_SOCKET,	SO_RCVBUF },
+	{ SOL_SOCKET,	SO_LINGER },
+	{ SOL_SOCKET,	SO_RCVTIMEO },
+	{ SOL_SOCKET,	SO_SNDTIMEO },
+	{ IPPROTO_TCP,	TCP_NODELAY },
+};
+
+/* Replace the not yet connected AF_SMC socket sockfd by a TCP socket of
+ * the given family, keeping descriptor number, file flags and the common
+ * socket options. Sockets already bound by the application stay as they
+ * are. Return 1 if the socket was replaced.
+ */
+static int smc_to_tcp(int sockfd, int family)
+{
+	struct sockaddr_storage local;
+	socklen_t len = sizeof(local);
+	int fl, fdfl, type, newfd;
+	char val[32];
+	size_t i;
+
+	if (getsockname(sockfd, (struct sockaddr *)&local, &len) ||
+	    (local.ss_family == AF_INET &&
+	     ((struct sockaddr_in *)&local)->sin_port) ||
+	    (local.ss_family == AF_INET6 &&
+	     ((struct sockaddr_in6 *)&local)->sin6_port))
+		return 0;
+	fl = fcntl(sockfd, F_GETFL);
+	fdfl = fcntl(sockfd, F_GETFD);
+	if (fl < 0 || fdfl < 0)
+		return 0;
+	type = SOCK_STREAM;
+	if (fl & O_NONBLOCK)
+		type |= SOCK_NONBLOCK;
+	newfd = (*orig_socket)(family, type, IPPROTO_TCP);
+	if (newfd < 0)
+		return 0;
+	for (i = 0; i < sizeof(copy_opts) / sizeof(copy_opts[0]); i++) {
+		len = sizeof(val);
+		if (getsockopt(sockfd, copy_opts[i].level, copy_opts[i].opt,
+			       val, &len))
+			continue;
+		/* the kernel reports twice the requested buffer size */
+		if (copy_opts[i].level == SOL_SOCKET &&
+		    (copy_opts[i].opt == SO_SNDBUF ||
+		     copy_opts[i].opt == SO_RCVBUF))
+			*(int *)val /= 2;
+		setsockopt(newfd, copy_opts[i].level, copy_opts[i].opt, val, len);
+	}
+	if (dup2(newfd, sockfd) < 0) {
+		close(newfd);
+		return 0;
+	}
+	close(newfd);
+	if (fdfl & FD_CLOEXEC)
+		fcntl(sockfd, F_SETFD, fdfl);
+	dbg_msg(stderr, "libsmc-preload: destination not eligible, map sock %d to TCP\n",
+		sockfd);
+
+	return 1;
+}
+
+static void set_bufsize(int socket, int opt, int size)
+{
+	int rc;
+
+	rc = setsockopt(socket, SOL_SOCKET, opt, &size, sizeof(size));
+	dbg_msg(stderr, "sockopt %d set to %d, rc %d\n", opt, size, rc);
+}
+
+static void apply_rule_bufsizes(int sockfd, const struct smc_rule *rule)
+{
+	if (rule->sndbuf)
+		set_bufsize(sockfd, SO_SNDBUF, rule->sndbuf);
+	if (rule->rcvbuf)
+		set_bufsize(sockfd, SO_RCVBUF, rule->rcvbuf);
+}
+
+/* check if socket is eligible for AF_SMC */
+static inline int smc_eligible(int domain, int type, int protocol)
+{
+	return (domain == AF_INET || domain == AF_INET6) &&
+	       // see kernel code, include/linux/net.h, SOCK_TYPE_MASK
+	       (type & 0xf) == SOCK_STREAM &&
+	       (protocol == IPPROTO_IP || protocol == IPPROTO_TCP);
+}
+
+/* orig_socket is set last by initialize(), a non-NULL value means that the
+ * configuration is complete and pthread_once() can be skipped
+ */
+int socket(int domain, int type, int protocol)
+{
+	int rc;
+
+	if (!orig_socket)
+		pthread_once(&init_once, initialize);
+
+	if (smc_eligible(domain, type, protocol)) {
+		dbg_msg(stderr, "libsmc-preload: map sock to AF_SMC\n");
+		stat_inc(SMC_STAT_MAPPED);
+		if (domain == AF_INET)
+			protocol = SMCPROTO_SMC;
+		else /* AF_INET6 */
+			protocol = SMCPROTO_SMC6;
+
+		domain = AF_SMC;
+	}
+
+	rc = (*orig_socket)(domain, type, protocol);
+	if (rc != -1) {
+		if (cfg.sndbuf)
+			set_bufsize(rc, SO_SNDBUF, cfg.sndbuf);
+		if (cfg.rcvbuf)
+			set_bufsize(rc, SO_RCVBUF, cfg.rcvbuf);
+	}
+
+	return rc;
+}
+
+int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen)
+{
+	int domain, rc, state, err, smc = 0;
+	struct smc_rule *rule = NULL;
+	unsigned long tag = 0;
+	uint64_t start = 0;
+	socklen_t len;
+
+	if (!orig_socket)
+		pthread_once(&init_once, initialize);
+
+	len = sizeof(domain);
+	if ((cfg.policy || cfg.learn_ttl || cfg.stats) && addr &&
+	    !getsockopt(sockfd, SOL_SOCKET, SO_DOMAIN, &domain, &len) &&
+	    domain == AF_SMC) {
+		smc = 1;
+		stat_inc(SMC_STAT_CONNECTS);
+		if (cfg.policy)
+			rule = policy_lookup(addr, addrlen);
+		if (cfg.learn_ttl || cfg.stats)
+			tag = peer_tag(addr, addrlen);
+		if (rule && !rule->use_smc) {
+			if (smc_to_tcp(sockfd, addr->sa_family)) {
+				stat_inc(SMC_STAT_POLICY_TCP);
+				smc = 0;
+			}
+		} else if (cfg.learn_ttl && tag) {
+			state = learn_state(tag);
+			if (state >= SMC_LEARN_FAILS) {
+				if (smc_to_tcp(sockfd, addr->sa_family)) {
+					stat_inc(SMC_STAT_LEARNED_TCP);
+					smc = 0;
+				}
+			} else if (!cfg.stats &&
+				   (state == 0 || !learn_claim(tag))) {
+				/* did SMC recently, or another connect to the
+				 * peer is looked up already; with telemetry,
+				 * every connect is looked up to count fallbacks
+				 */
+				tag = 0;
+			}
+		}
+		if (!smc)
+			tag = 0;
+		/* buffer sizes of SMC connections are fixed at connect */
+		if (rule)
+			apply_rule_bufsizes(sockfd, rule);
+	}
+
+	if ((smc && cfg.stats) || (cfg.latency && addr))
+		start = now_usec();
+	rc = (*orig_connect)(sockfd, addr, addrlen);
+	err = errno;
+	if (smc && cfg.stats && !rc)
+		stat_latency(now_usec() - start);
+	if (cfg.latency && addr)
+		lat_connect(sockfd, addr, start, rc, err);
+	if (tag)
+		learn_defer(sockfd, tag, rc, err);
+	errno = err;
+
+	return rc;
+}
+
+int listen(int sockfd, int backlog)
+{
+	struct sockaddr_storage local;
+	struct smc_rule *rule;
+	socklen_t len;
+	int domain, port;
+
+	if (!orig_socket)
+		pthread_once(&init_once, initialize);
+
+	len = sizeof(domain);
+	if (listen_rules &&
+	    !getsockopt(sockfd, SOL_SOCKET, SO_DOMAIN, &domain, &len) &&
+	    domain == AF_SMC) {
+		len = sizeof(local);
+		if (getsockname(sockfd, (struct sockaddr *)&local, &len))
+			goto out;
+		if (local.ss_family == AF_INET)
+			port = ntohs(((struct sockaddr_in *)&local)->sin_port);
+		else if (local.ss_family == AF_INET6)
+			port = ntohs(((struct sockaddr_in6 *)&local)->sin6_port);
+		else
+			goto out;
+		for (rule = listen_rules; rule; rule = rule->next) {
+			if (port >= rule->port_lo && port <= rule->port_hi) {
+				/* inherited by the accepted sockets */
+				apply_rule_bufsizes(sockfd, rule);
+				break;
+			}
+		}
+	}
+out:
+	return (*orig_listen)(sockfd, backlog);
+}
+
+int getsockopt(int sockfd, int level, int optname, void *optval,
+	       socklen_t *optlen)
+{
+	int rc, err;
+
+	if (!orig_getsockopt)
+		pthread_once(&init_once, initialize);
+
+	rc = (*orig_getsockopt)(sockfd, level, optname, optval, optlen);
+	if (cfg.latency && !rc && level == SOL_SOCKET &&
+	    optname == SO_ERROR && *optlen >= sizeof(int)) {
+		err = errno;
+		lat_so_error(sockfd, *(int *)optval);
+		errno = err;
+	}
+
+	return rc;
+}
+
+ssize_t send(int sockfd, const void *buf, size_t len, int flags)
+{
+	ssize_t rc;
+
+	if (!orig_send)
+		pthread_once(&init_once, initialize);
+
+	rc = (*orig_send)(sockfd, buf, len, flags);
+	if (cfg.latency)
+		lat_io(sockfd);
+	if (learn_nfds)
+		learn_io(sockfd, rc);
+
+	return rc;
+}
+
+ssize_t recv(int sockfd, void *buf, size_t len, int flags)
+{
+	ssize_t rc;
+
+	if (!orig_recv)
+		pthread_once(&init_once, initialize);
+
+	rc = (*orig_recv)(sockfd, buf, len, flags);
+	if (cfg.latency)
+		lat_io(sockfd);
+	if (learn_nfds)
+		learn_io(sockfd, rc);
+
+	return rc;
+}
+
+ssize_t sendmsg(int sockfd, const struct msghdr *msg, int flags)
+{
+	ssize_t rc;
+
+	if (!orig_sendmsg)
+		pthread_once(&init_once, initialize);
+
+	rc = (*orig_sendmsg)(sockfd, msg, flags);
+	if (cfg.latency)
+		lat_io(sockfd);
+	if (learn_nfds)
+		learn_io(sockfd, rc);
+
+	return rc;
+}
+
+ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags)
+{
+	ssize_t rc;
+
+	if (!orig_recvmsg)
+		pthread_once(&init_once, initialize);
+
+	rc = (*orig_recvmsg)(sockfd, msg, flags);
+	if (cfg.latency)
+		lat_io(sockfd);
+	if (learn_nfds)
+		learn_io(sockfd, rc);
+
+	return rc;
+}
+
+ssize_t write(int fd, const void *buf, size_t count)
+{
+	ssize_t rc;
+
+	if (!orig_write)
+		pthread_once(&init_once, initialize);
+
+	rc = (*orig_write)(fd, buf, count);
+	if (cfg.latency)
+		lat_io(fd);
+	if (learn_nfds)
+		learn_io(fd, rc);
+
+	return rc;
+}
+
+ssize_t read(int fd, void *buf, size_t count)
+{
+	ssize_t rc;
+
+	if (!orig_read)
+		pthread_once(&init_once, initialize);
+
+	rc = (*orig_read)(fd, buf, count);
+	if (cfg.latency)
+		lat_io(fd);
+	if (learn_nfds)
+		learn_io(fd, rc);
+
+	return rc;
+}
+
+#ifdef SMC_IO_URING
+/* io_uring socket creation
+ *
+ * Sockets created with IORING_OP_SOCKET never pass socket(). For rings set up
+ * through the io_uring_setup system call of the C library, i.e. by liburing on
+ * architectures using its generic system call layer or by raw syscall()
+ * users, the library maps its own view of the submission queue. Before each
+ * io_uring_enter, the pending socket SQEs that are eligible for AF_SMC are
+ * rewritten. The view is dropped when the ring descriptor is closed. Rings
+ * with a kernel submission thread (IORING_SETUP_SQPOLL) or with application
+ * provided memory (IORING_SETUP_NO_MMAP) are not handled, neither are rings
+ * set up with inline system calls, as liburing does on x86_64 and aarch64.
+ * With SMC_DEBUG set, rings the library does not handle are reported at exit.
+ * uring_cnt is read without uring_mutex to skip the lookup if there are no
+ * rings, the slots are only accessed with uring_mutex held.
+ */
+#define SMC_URING_MAX	16
+
+struct smc_uring {
+	int			used;
+	int			fd;
+	void			*ring;		/* SQ ring */
+	size_t			ring_sz;
+	struct io_uring_sqe	*sqes;
+	size_t			sqes_sz;
+	unsigned int		sqe_shift;	/* 1 for 128 byte SQEs */
+	unsigned int		entries;
+	struct io_sqring_offsets off;
+	int			no_array;
+};
+
+static struct smc_uring urings[SMC_URING_MAX];
+static int uring_cnt = 0;
+static pthread_mutex_t uring_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* the child inherits the rings and their mappings, but must not inherit
+ * uring_mutex held by another thread
+ */
+static void uring_atfork_prepare(void)
+{
+	pthread_mutex_lock(&uring_mutex);
+}
+
+static void uring_atfork_release(void)
+{
+	pthread_mutex_unlock(&uring_mutex);
+}
+
+static void uring_unmap(struct smc_uring *u)
+{
+	munmap(u->ring, u->ring_sz);
+	munmap(u->sqes, u->sqes_sz);
+	u->used = 0;
+	__atomic_store_n(&uring_cnt, uring_cnt - 1, __ATOMIC_RELAXED);
+}
+
+static void uring_forget(int fd)
+{
+	int i;
+
+	pthread_mutex_lock(&uring_mutex);
+	for (i = 0; i < SMC_URING_MAX; i++) {
+		if (urings[i].used && urings[i].fd == fd)
+			uring_unmap(&urings[i]);
+	}
+	pthread_mutex_unlock(&uring_mutex);
+}
+
+static void uring_track(int fd, const struct io_uring_params *p)
+{
+	struct smc_uring *u = NULL;
+	unsigned int flags = p->flags;
+	int i;
+
+	if (flags & IORING_SETUP_SQPOLL)
+		return;
+#ifdef IORING_SETUP_NO_MMAP
+	if (flags & IORING_SETUP_NO_MMAP)
+		return;
+#endif
+	uring_forget(fd);
+	pthread_mutex_lock(&uring_mutex);
+	for (i = 0; i < SMC_URING_MAX && !u; i++) {
+		if (!urings[i].used)
+			u = &urings[i];
+	}
+	if (!u) {
+		dbg_msg(stderr, "libsmc-preload: too many io_urings, ring %d not mapped\n",
+			fd);
+		goto out;
+	}
+	memset(u, 0, sizeof(*u));
+	u->fd = fd;
+	u->entries = p->sq_entries;
+	u->off = p->sq_off;
+#ifdef IORING_SETUP_NO_SQARRAY
+	u->no_array = !!(flags & IORING_SETUP_NO_SQARRAY);
+#endif
+	u->sqe_shift = (flags & IORING_SETUP_SQE128) ? 1 : 0;
+	u->ring_sz = u->no_array ? MAX(p->sq_off.head, p->sq_off.tail) +
+				   sizeof(unsigned int) :
+				   p->sq_off.array + p->sq_entries * sizeof(unsigned int);
+	u->ring_sz = MAX(u->ring_sz, p->sq_off.ring_mask + sizeof(unsigned int));
+	u->sqes_sz = (p->sq_entries * sizeof(struct io_uring_sqe)) << u->sqe_shift;
+	u->ring = mmap(NULL, u->ring_sz, PROT_READ, MAP_SHARED, fd,
+		       IORING_OFF_SQ_RING);
+	if (u->ring == MAP_FAILED)
+		goto out;
+	u->sqes = mmap(NULL, u->sqes_sz, PROT_READ | PROT_WRITE, MAP_SHARED,
+		       fd, IORING_OFF_SQES);
+	if (u->sqes == MAP_FAILED) {
+		munmap(u->ring, u->ring_sz);
+		goto out;
+	}
+	u->used = 1;
+	__atomic_store_n(&uring_cnt, uring_cnt + 1, __ATOMIC_RELAXED);
+out:
+	pthread_mutex_unlock(&uring_mutex);
+}
+
+/* rewrite the SQEs not yet consumed by the kernel */
+static void uring_rewrite(int fd)
+{
+	unsigned int head, tail, mask, idx, *array;
+	struct io_uring_sqe *sqe;
+	struct smc_uring *u;
+	int i;
+
+	pthread_mutex_lock(&uring_mutex);
+	for (i = 0; i < SMC_URING_MAX; i++) {
+		u = &urings[i];
+		if (u->used && u->fd == fd)
+			break;
+	}
+	if (i == SMC_URING_MAX)
+		goto out;
+	head = __atomic_load_n((unsigned int *)((char *)u->ring + u->off.head),
+			       __ATOMIC_ACQUIRE);
+	tail = *(unsigned int *)((char *)u->ring + u->off.tail);
+	mask = *(unsigned int *)((char *)u->ring + u->off.ring_mask);
+	array = (unsigned int *)((char *)u->ring + u->off.array);
+	for (; head != tail; head++) {
+		idx = u->no_array ? head & mask : array[head & mask];
+		if (idx >= u->entries)
+			continue;
+		sqe = &u->sqes[idx << u->sqe_shift];
+		if (sqe->opcode != IORING_OP_SOCKET ||
+		    !smc_eligible(sqe->fd, sqe->off, sqe->len))
+			continue;
+		dbg_msg(stderr, "libsmc-preload: map io_uring sock to AF_SMC\n");
+		stat_inc(SMC_STAT_MAPPED);
+		sqe->len = sqe->fd == AF_INET ? SMCPROTO_SMC : SMCPROTO_SMC6;
+		sqe->fd = AF_SMC;
+	}
+out:
+	pthread_mutex_unlock(&uring_mutex);
+}
+
+/* report the rings of the process that are not handled */
+static void __attribute__((destructor)) uring_report(void)
+{
+	char path[PATH_MAX], link[32];
+	struct dirent *d;
+	ssize_t len;
+	int fd, i;
+	DIR *dir;
+
+	if (!cfg.debug)
+		return;
+	dir = opendir("/proc/self/fd");
+	if (!dir)
+		return;
+	while ((d = readdir(dir)) != NULL) {
+		snprintf(path, sizeof(path), "/proc/self/fd/%s", d->d_name);
+		len = readlink(path, link, sizeof(link) - 1);
+		if (len < 0)
+			continue;
+		link[len] = '\0';
+		if (strcmp(link, "anon_inode:[io_uring]"))
+			continue;
+		fd = atoi(d->d_name);
+		pthread_mutex_lock(&uring_mutex);
+		for (i = 0; i < SMC_URING_MAX; i++) {
+			if (urings[i].used && urings[i].fd == fd)
+				break;
+		}
+		pthread_mutex_unlock(&uring_mutex);
+		if (i == SMC_URING_MAX)
+			fprintf(stderr, "libsmc-preload: io_uring %d not handled, its sockets were not mapped to AF_SMC\n",
+				fd);
+	}
+	closedir(dir);
+}
+
+long syscall(long number, ...)
+{
+	long a1, a2, a3, a4, a5, a6, rc;
+	va_list vl;
+
+	if (!orig_syscall)
+		pthread_once(&init_once, initialize);
+
+	va_start(vl, number);
+	a1 = va_arg(vl, long);
+	a2 = va_arg(vl, long);
+	a3 = va_arg(vl, long);
+	a4 = va_arg(vl, long);
+	a5 = va_arg(vl, long);
+	a6 = va_arg(vl, long);
+	va_end(vl);
+
+	if (number == __NR_io_uring_enter &&
+	    __atomic_load_n(&uring_cnt, __ATOMIC_RELAXED))
+		uring_rewrite(a1);
+	rc = (*orig_syscall)(number, a1, a2, a3, a4, a5, a6);
+	if (number == __NR_io_uring_setup && rc >= 0)
+		uring_track(rc, (struct io_uring_params *)a2);
+
+	return rc;
+}
+#endif /* SMC_IO_URING */
+
+/* initialize() closes files itself, close(), syscall() and the calls moving
+ * data therefore test their own function pointer which is set before the
+ * configuration is read
+ */
+int close(int fd)
+{
+	if (!orig_close)
+		pthread_once(&init_once, initialize);
+
+	if (cfg.latency)
+		lat_forget(fd);
+	if (learn_nfds)
+		learn_forget(fd);
+#ifdef SMC_IO_URING
+	if (__atomic_load_n(&uring_cnt, __ATOMIC_RELAXED))
+		uring_forget(fd);
+#endif
+
+	return (*orig_close)(fd);
+}
+
+static void set_debug_mode(const char *var_name)
+{
+	char *var_value;
+
+	var_value = getenv(var_name);
+	cfg.debug = 0;
+	if (var_value != NULL)
+		cfg.debug = (var_value[0] != '0');
+}
+
+/* buffer size in bytes from an environment variable, 0 if not set */
+static int get_bufsize(const char *var_name)
+{
+	char *val;
+	int size;
+
+	val = getenv(var_name);
+	if (!val)
+		return 0;
+	size = parse_size(val);
+	return size > 0 ? size : 0;
+}
+
+static void set_learn_ttl(const char *var_name)
+{
+	char *val, *end;
+	long ttl;
+
+	val = getenv(var_name);
+	if (!val || !val[0])
+		return;
+	ttl = strtol(val, &end, 10);
+	if (*end || ttl <= 0 || ttl > 86400) {
+		fprintf(stderr, "libsmc-preload: invalid %s ignored\n", var_name);
+		return;
+	}
+	cfg.learn_ttl = ttl;
+}
+
+/* the mode of connected sockets is looked up for learning and telemetry */
+static void set_lookup(void)
+{
+	int nfds;
+
+	if (!cfg.learn_ttl && !cfg.stats)
+		return;
+	nfds = fd_table_size();
+	learn_fds = calloc(nfds, sizeof(*learn_fds));
+	if (!learn_fds) {
+		fprintf(stderr, "libsmc-preload: out of memory\n");
+		return;
+	}
+	learn_nfds = nfds;
+}
+
+/* Runs once, from the constructor or from the first intercepted call if
+ * that comes earlier, e.g. from the constructor of another library
+ */
+static void initialize(void)
+{
+	set_debug_mode("SMC_DEBUG");
+
+	dl_handle = dlopen(LIBC_SO, DLOPEN_FLAG);
+	if (!dl_handle)
+		dbg_msg(stderr, "dlopen failed: %s\n", dlerror());
+	GET_FUNC(connect);
+	GET_FUNC(listen);
+	GET_FUNC(getsockopt);
+	GET_FUNC(send);
+	GET_FUNC(recv);
+	GET_FUNC(sendmsg);
+	GET_FUNC(recvmsg);
+	GET_FUNC(write);
+	GET_FUNC(read);
+	GET_FUNC(close);
+#ifdef SMC_IO_URING
+	GET_FUNC(syscall);
+	pthread_atfork(uring_atfork_prepare, uring_atfork_release,
+		       uring_atfork_release);
+#endif
+
+	cfg.sndbuf = get_bufsize("SMC_SNDBUF");
+	cfg.rcvbuf = get_bufsize("SMC_RCVBUF");
+	load_policy("SMC_POLICY");
+	set_learn_ttl("SMC_LEARN");
+	set_stats("SMC_STATS");
+	set_lookup();
+	set_latency("SMC_LATENCY");
+	GET_FUNC(socket);
+}
+
+static void __attribute__((constructor)) smc_preload_init(void)
+{
+	pthread_once(&init_once, initialize);
 }
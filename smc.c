@@ -22,6 +22,7 @@
 #include <string.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <time.h>
 
 #include "smctools_common.h"
 #include "libnetlink.h"
@@ -32,8 +33,11 @@
 #include "seid.h"
 #include "info.h"
 #include "stats.h"
+#include "topology.h"
 
 static int option_detail = 0;
+static int sample_interval = 0;
+static int sample_count = 0;
 #if defined(SMCD)
 char *myname = "smcd";
 #elif defined(SMCR)
@@ -53,11 +57,13 @@ static void usage(void)
 	fprintf(stderr,
 		"Usage: %s  [ OPTIONS ] OBJECT {COMMAND | help}\n"
 #if defined(SMCD)
-		"where  OBJECT := {info | linkgroup | device | stats | ueid | seid}\n"
-		"       OPTIONS := {-v[ersion] | -d[etails] | -a[bsolute]}\n", myname);
+		"where  OBJECT := {info | linkgroup | device | topology | stats | ueid | seid}\n"
+		"       OPTIONS := {-v[ersion] | -d[etails] | -a[bsolute] |\n"
+		"                   -i[nterval] SEC | -c[ount] NUM}\n", myname);
 #else
-		"where  OBJECT := {info | linkgroup | device | stats | ueid}\n"
-		"       OPTIONS := {-v[ersion] | -d[etails] | -dd[etails] | -a[bsolute]}\n", myname);
+		"where  OBJECT := {info | linkgroup | device | topology | stats | ueid}\n"
+		"       OPTIONS := {-v[ersion] | -d[etails] | -dd[etails] | -a[bsolute] |\n"
+		"                   -i[nterval] SEC | -c[ount] NUM}\n", myname);
 #endif
 }
 
@@ -74,6 +80,7 @@ static const struct cmd {
 	{ "device",	invoke_devs },
 	{ "linkgroup",	invoke_lgs },
 	{ "info",	invoke_info },
+	{ "topology",	invoke_topology },
 	{ "stats",	invoke_stats },
 	{ "ueid",	invoke_ueid },
 #if defined(SMCD)
@@ -106,6 +113,36 @@ static int run_cmd(const char *argv0, int argc, char **argv)
 	return EXIT_FAILURE;
 }
 
+/* Run the command every sample_interval seconds on the same netlink session,
+ * like vmstat: without count until interrupted, or until the replay file ends.
+ */
+static int run_cmd_samples(const char *argv0, int argc, char **argv)
+{
+	struct timespec ts;
+	char tstamp[32];
+	unsigned int n;
+	int rc = 0;
+
+	if (!sample_interval)
+		sample_interval = 1;
+	for (n = 0; !sample_count || n < (unsigned int)sample_count; n++) {
+		if (nl_sample(n, sample_interval, &ts))
+			break;
+		strftime(tstamp, sizeof(tstamp), "%Y-%m-%d %H:%M:%S",
+			 localtime(&ts.tv_sec));
+		printf("%sSample %u at %s.%03ld\n", n ? "\n" : "", n, tstamp,
+		       ts.tv_nsec / 1000000);
+		fflush(stdout);
+		/* device data changes between samples */
+		dev_inventory_reset();
+		rc = run_cmd(argv0, argc, argv);
+		fflush(stdout);
+		if (rc)
+			break;
+	}
+	return rc;
+}
+
 int main(int argc, char **argv)
 {
 	int rc = 0;
@@ -135,6 +172,19 @@ int main(int argc, char **argv)
 		} else if (contains(opt, "-help") == 0) {
 			usage();
 			goto out;
+		} else if (contains(opt, "-interval") == 0 ||
+			   contains(opt, "-count") == 0) {
+			if (argc < 3 || atoi(argv[2]) <= 0) {
+				fprintf(stderr,
+					"Error: Option \"%s\" requires a positive number.\n",
+					opt);
+				exit(-1);
+			}
+			if (opt[1] == 'i')
+				sample_interval = atoi(argv[2]);
+			else
+				sample_count = atoi(argv[2]);
+			argc--;	argv++;
 		} else {
 			fprintf(stderr,
 				"Error: Option \"%s\" is unknown, try \"%s help\".\n",
@@ -147,7 +197,10 @@ int main(int argc, char **argv)
 	if (gen_nl_open())
 		exit(1);
 	if (argc > 1) {
-		rc = run_cmd(argv[1], argc-1, argv+1);
+		if (sample_interval || sample_count)
+			rc = run_cmd_samples(argv[1], argc-1, argv+1);
+		else
+			rc = run_cmd(argv[1], argc-1, argv+1);
 		goto out;
 	}
 	usage();
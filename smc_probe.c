@@ -0,0 +1,1323 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * User space program to probe SMC connectivity and throughput
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <endian.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+
+#include "smctools_common.h"
+#include "libnetlink.h"
+
+#ifndef AF_SMC
+#define AF_SMC		PF_SMC
+#endif
+#ifndef SMCPROTO_SMC
+#define SMCPROTO_SMC	0	/* SMC protocol, IPv4 */
+#define SMCPROTO_SMC6	1	/* SMC protocol, IPv6 */
+#endif
+
+#define PROBE_PORT_DFT		37373
+#define PROBE_TIMEOUT_DFT	10000	/* connect timeout in ms */
+#define PROBE_GREET_TIMEOUT	1000	/* wait for the server greeting, ms */
+#define PROBE_BULK_DFT		500	/* bulk transfer time in ms */
+#define PROBE_BUF_SIZE		65536
+#define PROBE_MAX_MSG		1048576	/* largest ping-pong message */
+#define BENCH_MAX_BUFS		16
+#define BENCH_MAX_SAMPLES	1000000
+
+/* Protocol: the server greets each connection with PROBE_MAGIC, the client
+ * then sends a request and runs the requested operation
+ */
+#define PROBE_MAGIC		"SMCPRB01"
+#define PROBE_MAGIC_LEN		8
+
+enum {
+	PROBE_OP_BULK = 1,	/* client sends until EOF, server replies with
+				 * the number of bytes received (u64)
+				 */
+	PROBE_OP_PINGPONG,	/* server echoes messages of size bytes */
+	PROBE_OP_LISTEN,	/* server listens with buffer size bytes on a
+				 * free port, replies with the port (u32) and
+				 * keeps listening until the connection closes
+				 */
+	PROBE_OP_LISTEN_TCP,	/* as PROBE_OP_LISTEN, with a TCP socket */
+};
+
+struct probe_req {
+	uint32_t	op;
+	uint32_t	size;
+};
+
+/* mode of the client socket as reported by sock_diag */
+struct probe_result {
+	int		found;
+	int		mode;
+	uint32_t	reason;
+	uint32_t	peer_reason;
+	uint32_t	sndbuf;		/* buffer sizes of SMC connections */
+	uint32_t	rmbe;
+};
+
+static const struct {
+	uint32_t	code;
+	const char	*text;
+} fallback_reasons[] = {
+	{ 0x01010000, "Out of memory" },
+	{ 0x02010000, "Timeout while waiting for confirm link message over RDMA device" },
+	{ 0x02020000, "Timeout while waiting for RDMA device to be added" },
+	{ 0x03000000, "Configuration error" },
+	{ 0x03010000, "Peer does not support SMC" },
+	{ 0x03020000, "Connection uses IPsec" },
+	{ 0x03030000, "No SMC devices found (R and D)" },
+	{ 0x03030001, "No ISM device for SMC-D found" },
+	{ 0x03030002, "No RDMA device for SMC-R found" },
+	{ 0x03030003, "Hardware has no ISMv2 support" },
+	{ 0x03030004, "Peer sent no SMCv2 extension" },
+	{ 0x03030005, "Peer sent no SMC-Dv2 extension" },
+	{ 0x03030006, "Peer sent no ISMv2 SEID" },
+	{ 0x03030007, "No SMC-Dv2 device found, but required" },
+	{ 0x03030008, "Peer sent no UEID" },
+	{ 0x03040000, "SMC modes mismatch (R or D)" },
+	{ 0x03050000, "Peer has eyecatcher in RMBE" },
+	{ 0x03060000, "Fastopen sockopt not supported" },
+	{ 0x03070000, "IP prefix / subnet mismatch" },
+	{ 0x03080000, "Error retrieving VLAN ID of IP device" },
+	{ 0x03090000, "Error while registering VLAN ID on ISM device" },
+	{ 0x030a0000, "No active SMC-R link in link group" },
+	{ 0x030b0000, "SMC-R link from server not found" },
+	{ 0x030c0000, "SMC version mismatch" },
+	{ 0x030d0000, "SMC-D connection limit reached" },
+	{ 0x030e0000, "SMC-Rv2 connection found no route to peer" },
+	{ 0x030f0000, "SMC-Rv2 connection mismatch direct/indirect with peer" },
+	{ 0x04000000, "Synchronization error" },
+	{ 0x05000000, "Peer declined during handshake" },
+	{ 0x09990000, "Internal error" },
+	{ 0x09990001, "rtoken handling failed" },
+	{ 0x09990002, "RDMA link failed" },
+	{ 0x09990003, "RMB registration failed" },
+};
+
+static char *progname;
+static int ipv6;
+static int port = PROBE_PORT_DFT;
+static int timeout = PROBE_TIMEOUT_DFT;
+static int bulk_time = PROBE_BULK_DFT;
+static int bench_bufs[BENCH_MAX_BUFS] = { 0 };	/* 0: system default */
+static int bench_nbufs = 1;
+static unsigned long long probe_inode;
+static struct probe_result probe_res;
+
+static double now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static const char *fallback_text(uint32_t code)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(fallback_reasons) / sizeof(fallback_reasons[0]); i++) {
+		if (fallback_reasons[i].code == code)
+			return fallback_reasons[i].text;
+	}
+	return "Unknown error code or non-Linux OS";
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	ssize_t rc;
+
+	while (len) {
+		rc = write(fd, p, len);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += rc;
+		len -= rc;
+	}
+	return 0;
+}
+
+static int read_all(int fd, void *buf, size_t len)
+{
+	char *p = buf;
+	ssize_t rc;
+
+	while (len) {
+		rc = read(fd, p, len);
+		if (rc < 0 && errno == EINTR)
+			continue;
+		if (rc <= 0)
+			return -1;
+		p += rc;
+		len -= rc;
+	}
+	return 0;
+}
+
+/* SMC or TCP socket with buffer size bufsize, 0 for the default */
+static int probe_socket(int family, int smc, int bufsize)
+{
+	int fd;
+
+	if (smc)
+		fd = socket(AF_SMC, SOCK_STREAM,
+			    family == AF_INET6 ? SMCPROTO_SMC6 : SMCPROTO_SMC);
+	else
+		fd = socket(family, SOCK_STREAM, IPPROTO_TCP);
+	if (fd < 0) {
+		fprintf(stderr, "Error: Cannot create %s socket: %s\n",
+			smc ? "SMC" : "TCP", strerror(errno));
+		return -1;
+	}
+	if (bufsize) {
+		setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(bufsize));
+		setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+	}
+	return fd;
+}
+
+/* Server side */
+
+static void serve_listen(int fd, int smc, int bufsize);
+
+static void *serve_conn(void *arg)
+{
+	int fd = (long)arg;
+	uint64_t total = 0;
+	struct probe_req req;
+	uint32_t size;
+	char *buf;
+	ssize_t rc;
+
+	buf = malloc(PROBE_MAX_MSG);
+	if (!buf)
+		goto out;
+	if (write_all(fd, PROBE_MAGIC, PROBE_MAGIC_LEN) ||
+	    read_all(fd, &req, sizeof(req)))
+		goto out;
+	size = ntohl(req.size);
+	switch (ntohl(req.op)) {
+	case PROBE_OP_PINGPONG:
+		if (!size || size > PROBE_MAX_MSG)
+			break;
+		while (!read_all(fd, buf, size) && !write_all(fd, buf, size))
+			;
+		break;
+	case PROBE_OP_BULK:
+		while ((rc = read(fd, buf, PROBE_MAX_MSG)) != 0) {
+			if (rc < 0) {
+				if (errno == EINTR)
+					continue;
+				goto out;
+			}
+			total += rc;
+		}
+		total = htobe64(total);
+		write_all(fd, &total, sizeof(total));
+		break;
+	case PROBE_OP_LISTEN:
+	case PROBE_OP_LISTEN_TCP:
+		if (size <= 0x40000000)
+			serve_listen(fd, ntohl(req.op) == PROBE_OP_LISTEN, size);
+		break;
+	default:
+		break;
+	}
+out:
+	free(buf);
+	close(fd);
+	return NULL;
+}
+
+/* listening socket on port, 0 for any port */
+static int probe_listen(int family, const char *addr, int lport, int smc,
+			int bufsize)
+{
+	struct sockaddr_storage sa;
+	struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&sa;
+	struct sockaddr_in *sin = (struct sockaddr_in *)&sa;
+	int fd, on = 1;
+
+	fd = probe_socket(family, smc, bufsize);
+	if (fd < 0)
+		return -1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	memset(&sa, 0, sizeof(sa));
+	if (family == AF_INET6) {
+		sin6->sin6_family = AF_INET6;
+		sin6->sin6_port = htons(lport);
+		if (addr)
+			inet_pton(AF_INET6, addr, &sin6->sin6_addr);
+	} else {
+		sin->sin_family = AF_INET;
+		sin->sin_port = htons(lport);
+		if (addr)
+			inet_pton(AF_INET, addr, &sin->sin_addr);
+	}
+	if (bind(fd, (struct sockaddr *)&sa, family == AF_INET6 ?
+		 sizeof(*sin6) : sizeof(*sin)) ||
+	    listen(fd, 128)) {
+		fprintf(stderr, "Error: Cannot listen on port %d: %s\n", lport,
+			strerror(errno));
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static int probe_local_port(int fd)
+{
+	struct sockaddr_storage sa;
+	socklen_t len = sizeof(sa);
+
+	if (getsockname(fd, (struct sockaddr *)&sa, &len))
+		return -1;
+	if (sa.ss_family == AF_INET6)
+		return ntohs(((struct sockaddr_in6 *)&sa)->sin6_port);
+	return ntohs(((struct sockaddr_in *)&sa)->sin_port);
+}
+
+/* SMC or TCP listener with buffer size bufsize on the local address of
+ * connection fd, runs until fd is closed by the peer
+ */
+static void serve_listen(int fd, int smc, int bufsize)
+{
+	struct pollfd pfd[2] = { { .fd = fd, .events = POLLIN },
+				 { .events = POLLIN } };
+	struct sockaddr_storage sa;
+	socklen_t salen = sizeof(sa);
+	char addr[INET6_ADDRSTRLEN];
+	uint32_t lport;
+	pthread_t tid;
+	int lfd, cfd;
+
+	if (getsockname(fd, (struct sockaddr *)&sa, &salen) ||
+	    !inet_ntop(sa.ss_family, sa.ss_family == AF_INET6 ?
+		       (void *)&((struct sockaddr_in6 *)&sa)->sin6_addr :
+		       (void *)&((struct sockaddr_in *)&sa)->sin_addr,
+		       addr, sizeof(addr)))
+		return;
+	lfd = probe_listen(sa.ss_family, addr, 0, smc, bufsize);
+	if (lfd < 0)
+		return;
+	lport = htonl(probe_local_port(lfd));
+	if (write_all(fd, &lport, sizeof(lport)))
+		goto out;
+	pfd[1].fd = lfd;
+	while (1) {
+		if (poll(pfd, 2, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if (pfd[0].revents)	/* EOF, the client is done */
+			break;
+		if (!(pfd[1].revents & POLLIN))
+			continue;
+		cfd = accept(lfd, NULL, NULL);
+		if (cfd < 0)
+			continue;
+		if (pthread_create(&tid, NULL, serve_conn, (void *)(long)cfd)) {
+			close(cfd);
+			continue;
+		}
+		pthread_detach(tid);
+	}
+out:
+	close(lfd);
+}
+
+static void *serve(void *arg)
+{
+	int lfd = (long)arg, fd;
+	pthread_t tid;
+
+	while (1) {
+		fd = accept(lfd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			fprintf(stderr, "Error: accept failed: %s\n",
+				strerror(errno));
+			break;
+		}
+		if (pthread_create(&tid, NULL, serve_conn, (void *)(long)fd)) {
+			close(fd);
+			continue;
+		}
+		pthread_detach(tid);
+	}
+	return NULL;
+}
+
+/* Client side */
+
+static void probe_diag_one(struct nlmsghdr *nlh)
+{
+	struct smc_diag_msg *r = NLMSG_DATA(nlh);
+	struct rtattr *tb[SMC_DIAG_MAX + 1];
+	struct smc_diag_conninfo ci;
+	struct smc_diag_fallback fb;
+
+	if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(*r)) ||
+	    r->diag_inode != probe_inode)
+		return;
+	probe_res.found = 1;
+	probe_res.mode = r->diag_mode;
+	parse_rtattr(tb, SMC_DIAG_MAX, (struct rtattr *)(r + 1),
+		     nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*r)));
+	if (tb[SMC_DIAG_CONNINFO] &&
+	    RTA_PAYLOAD(tb[SMC_DIAG_CONNINFO]) >= sizeof(ci)) {
+		memcpy(&ci, RTA_DATA(tb[SMC_DIAG_CONNINFO]), sizeof(ci));
+		probe_res.sndbuf = ci.sndbuf_size;
+		probe_res.rmbe = ci.rmbe_size;
+	}
+	if (r->diag_mode != SMC_DIAG_MODE_FALLBACK_TCP)
+		return;
+	if (tb[SMC_DIAG_FALLBACK] &&
+	    RTA_PAYLOAD(tb[SMC_DIAG_FALLBACK]) >= sizeof(fb)) {
+		memcpy(&fb, RTA_DATA(tb[SMC_DIAG_FALLBACK]), sizeof(fb));
+		probe_res.reason = fb.reason;
+		probe_res.peer_reason = fb.peer_diagnosis;
+	}
+}
+
+/* look up the mode of the connected socket fd via sock_diag */
+static int probe_diag(int fd)
+{
+	struct rtnl_handle rth;
+	struct stat st;
+	int rc;
+
+	if (fstat(fd, &st))
+		return EXIT_FAILURE;
+	probe_inode = st.st_ino;
+	memset(&probe_res, 0, sizeof(probe_res));
+	if ((rc = rtnl_open(&rth)))
+		return EXIT_FAILURE;
+	rth.dump = MAGIC_SEQ;
+	if ((rc = sockdiag_send(rth.fd, 1 << (SMC_DIAG_CONNINFO - 1))))
+		goto exit;
+	rc = rtnl_dump(&rth, probe_diag_one);
+exit:
+	rtnl_close(&rth);
+	return rc || !probe_res.found;
+}
+
+/* connect within timeout ms, return the socket or -1 */
+static int probe_connect(const struct sockaddr *sa, socklen_t salen, int smc,
+			 int bufsize, double *elapsed)
+{
+	struct pollfd pfd;
+	socklen_t len;
+	int fd, fl, err;
+	double start;
+
+	fd = probe_socket(sa->sa_family, smc, bufsize);
+	if (fd < 0)
+		return -1;
+	fl = fcntl(fd, F_GETFL);
+	fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+	start = now_ms();
+	if (connect(fd, sa, salen)) {
+		if (errno != EINPROGRESS) {
+			err = errno;
+			goto errout;
+		}
+		pfd.fd = fd;
+		pfd.events = POLLOUT;
+		if (poll(&pfd, 1, timeout) <= 0) {
+			err = ETIMEDOUT;
+			goto errout;
+		}
+		len = sizeof(err);
+		if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len))
+			err = errno;
+		if (err)
+			goto errout;
+	}
+	*elapsed = now_ms() - start;
+	fcntl(fd, F_SETFL, fl);
+	return fd;
+
+errout:
+	fprintf(stderr, "Error: Cannot connect: %s\n", strerror(err));
+	close(fd);
+	return -1;
+}
+
+/* 1 if the peer greets like a probe server */
+static int probe_greeted(int fd)
+{
+	char magic[PROBE_MAGIC_LEN];
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	size_t got = 0;
+	ssize_t rc;
+
+	while (got < sizeof(magic)) {
+		if (poll(&pfd, 1, PROBE_GREET_TIMEOUT) <= 0)
+			return 0;
+		rc = read(fd, magic + got, sizeof(magic) - got);
+		if (rc <= 0)
+			return 0;
+		got += rc;
+	}
+	return !memcmp(magic, PROBE_MAGIC, PROBE_MAGIC_LEN);
+}
+
+/* send messages of size bytes for bulk_time ms, return MB/s or -1 */
+static double probe_bulk(int fd, int size)
+{
+	struct probe_req req = { htonl(PROBE_OP_BULK), htonl(size) };
+	double start, end, mbps = -1;
+	uint64_t total;
+	char *buf;
+
+	buf = calloc(1, size);
+	if (!buf)
+		return -1;
+	if (write_all(fd, &req, sizeof(req)))
+		goto out;
+	start = now_ms();
+	end = start + bulk_time;
+	do {
+		if (write_all(fd, buf, size))
+			goto out;
+	} while (now_ms() < end);
+	shutdown(fd, SHUT_WR);
+	if (read_all(fd, &total, sizeof(total)))
+		goto out;
+	mbps = be64toh(total) / (now_ms() - start) / 1000.0;
+out:
+	free(buf);
+	return mbps;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int cmp_int(const void *a, const void *b)
+{
+	int x = *(const int *)a, y = *(const int *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* exchange messages of size bytes for bulk_time ms, the round trip times
+ * in microseconds go to samples, sorted. Return the number of samples or -1
+ */
+static int probe_pingpong(int fd, int size, double *samples)
+{
+	struct probe_req req = { htonl(PROBE_OP_PINGPONG), htonl(size) };
+	double start, end, t;
+	int n = 0;
+	char *buf;
+
+	buf = calloc(1, size);
+	if (!buf)
+		return -1;
+	if (write_all(fd, &req, sizeof(req)))
+		goto errout;
+	start = now_ms();
+	end = start + bulk_time;
+	do {
+		t = now_ms();
+		if (write_all(fd, buf, size) || read_all(fd, buf, size))
+			goto errout;
+		samples[n++] = (now_ms() - t) * 1000.0;
+	} while (n < BENCH_MAX_SAMPLES && now_ms() < end);
+	free(buf);
+	qsort(samples, n, sizeof(*samples), cmp_double);
+	return n;
+
+errout:
+	free(buf);
+	return -1;
+}
+
+static int probe_resolve(const char *host, struct sockaddr_storage *sa,
+			 socklen_t *salen)
+{
+	struct addrinfo hints, *ai;
+	char portstr[16];
+	int rc;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = ipv6 ? AF_INET6 : AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	snprintf(portstr, sizeof(portstr), "%d", port);
+	if ((rc = getaddrinfo(host, portstr, &hints, &ai))) {
+		fprintf(stderr, "Error: Unknown destination '%s': %s\n", host,
+			gai_strerror(rc));
+		return -1;
+	}
+	memcpy(sa, ai->ai_addr, ai->ai_addrlen);
+	*salen = ai->ai_addrlen;
+	freeaddrinfo(ai);
+	return 0;
+}
+
+static void set_port(struct sockaddr_storage *sa, int lport)
+{
+	if (sa->ss_family == AF_INET6)
+		((struct sockaddr_in6 *)sa)->sin6_port = htons(lport);
+	else
+		((struct sockaddr_in *)sa)->sin_port = htons(lport);
+}
+
+/* connection to lport ready for a request, -1 on errors */
+static int probe_open(struct sockaddr_storage *sa, socklen_t salen, int lport,
+		      int smc, int bufsize)
+{
+	double elapsed;
+	int fd;
+
+	set_port(sa, lport);
+	fd = probe_connect((struct sockaddr *)sa, salen, smc, bufsize, &elapsed);
+	if (fd < 0)
+		return -1;
+	if (!probe_greeted(fd)) {
+		fprintf(stderr, "Error: Peer is no smc_probe server\n");
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/* control connection to the server, which listens for SMC or TCP connections
+ * with buffer size bufsize on port *lport until the control connection is
+ * closed, -1 on errors
+ */
+static int probe_server_listen(struct sockaddr_storage *sa, socklen_t salen,
+			       int smc, int bufsize, int *lport)
+{
+	struct probe_req req = {
+		htonl(smc ? PROBE_OP_LISTEN : PROBE_OP_LISTEN_TCP),
+		htonl(bufsize)
+	};
+	uint32_t val;
+	int fd;
+
+	fd = probe_open(sa, salen, port, 0, 0);
+	if (fd < 0)
+		return -1;
+	if (write_all(fd, &req, sizeof(req)) ||
+	    read_all(fd, &val, sizeof(val))) {
+		fprintf(stderr, "Error: Server cannot listen with buffer size %d\n",
+			bufsize);
+		close(fd);
+		return -1;
+	}
+	*lport = ntohl(val);
+	return fd;
+}
+
+/* return 0 if SMC was used, 2 on fallback to TCP, 1 on errors */
+static int probe(const char *host)
+{
+	struct sockaddr_storage sa;
+	socklen_t salen;
+	double elapsed, mbps;
+	int fd, rc;
+
+	if (probe_resolve(host, &sa, &salen))
+		return EXIT_FAILURE;
+	fd = probe_connect((struct sockaddr *)&sa, salen, 1, 0, &elapsed);
+	if (fd < 0)
+		return EXIT_FAILURE;
+	printf("Handshake:   %.3f ms\n", elapsed);
+	if (probe_diag(fd)) {
+		fprintf(stderr, "Error: Cannot determine the socket mode\n");
+		close(fd);
+		return EXIT_FAILURE;
+	}
+	switch (probe_res.mode) {
+	case SMC_DIAG_MODE_SMCD:
+		printf("Mode:        SMC-D\n");
+		rc = 0;
+		break;
+	case SMC_DIAG_MODE_SMCR:
+		printf("Mode:        SMC-R\n");
+		rc = 0;
+		break;
+	default:
+		printf("Mode:        TCP (fallback)\n");
+		printf("Client:      0x%08x %s\n", probe_res.reason,
+		       fallback_text(probe_res.reason));
+		if (probe_res.peer_reason)
+			printf("Server:      0x%08x %s\n", probe_res.peer_reason,
+			       fallback_text(probe_res.peer_reason));
+		rc = 2;
+		break;
+	}
+	if (bulk_time) {
+		if (!probe_greeted(fd)) {
+			printf("Throughput:  not measured, peer is no smc_probe server\n");
+		} else if ((mbps = probe_bulk(fd, PROBE_BUF_SIZE)) < 0) {
+			fprintf(stderr, "Error: Throughput measurement failed: %s\n",
+				strerror(errno));
+			rc = EXIT_FAILURE;
+		} else {
+			printf("Throughput:  %.1f MB/s\n", mbps);
+		}
+	}
+	close(fd);
+
+	return rc;
+}
+
+/* Benchmark
+ *
+ * Runs ping-pong and streaming tests over TCP and SMC for message sizes from
+ * 64 bytes to 1 MiB, once per buffer size. Each test uses a connection of
+ * its own and runs for bulk_time ms. Each transport and buffer size gets a
+ * listener of its own, so that both ends of the connections use the buffer
+ * size: started locally in loopback mode, otherwise opened by the peer's
+ * smc_probe server on request for the tests of one buffer size.
+ */
+#define BENCH_MIN_MSG		64
+
+struct bench_res {
+	double	p50;		/* round trip times in us */
+	double	p99;
+	double	p999;
+	double	mbps;
+};
+
+/* [smc][buffer], 0 for listeners opened by a remote server */
+static int bench_ports[2][BENCH_MAX_BUFS];
+
+static double percentile(const double *samples, int n, double q)
+{
+	int i = q * n;
+
+	return samples[i < n ? i : n - 1];
+}
+
+/* connection ready for the request of a test */
+static int bench_connect(struct sockaddr_storage *sa, socklen_t salen, int smc,
+			 int buf)
+{
+	return probe_open(sa, salen, bench_ports[smc][buf], smc,
+			  bench_bufs[buf]);
+}
+
+static int bench_one(struct sockaddr_storage *sa, socklen_t salen, int smc,
+		     int buf, int size, double *samples, struct bench_res *res)
+{
+	int fd, n;
+
+	fd = bench_connect(sa, salen, smc, buf);
+	if (fd < 0)
+		return -1;
+	n = probe_pingpong(fd, size, samples);
+	close(fd);
+	if (n <= 0)
+		goto errout;
+	res->p50 = percentile(samples, n, 0.5);
+	res->p99 = percentile(samples, n, 0.99);
+	res->p999 = percentile(samples, n, 0.999);
+
+	fd = bench_connect(sa, salen, smc, buf);
+	if (fd < 0)
+		return -1;
+	res->mbps = probe_bulk(fd, size);
+	close(fd);
+	if (res->mbps < 0)
+		goto errout;
+	return 0;
+
+errout:
+	fprintf(stderr, "Error: %s test with %d byte messages failed: %s\n",
+		smc ? "SMC" : "TCP", size, strerror(errno));
+	return -1;
+}
+
+/* mode of the SMC connections for buffer buf */
+static const char *bench_mode(struct sockaddr_storage *sa, socklen_t salen,
+			      int buf)
+{
+	const char *mode = "unknown mode";
+	int fd;
+
+	fd = bench_connect(sa, salen, 1, buf);
+	if (fd < 0)
+		return NULL;
+	if (!probe_diag(fd)) {
+		if (probe_res.mode == SMC_DIAG_MODE_SMCD)
+			mode = "SMC-D";
+		else if (probe_res.mode == SMC_DIAG_MODE_SMCR)
+			mode = "SMC-R";
+		else
+			mode = "TCP fallback";
+	}
+	close(fd);
+	return mode;
+}
+
+static void print_size(char *str, size_t len, int size)
+{
+	if (!size)
+		snprintf(str, len, "default");
+	else if (size % 1048576 == 0)
+		snprintf(str, len, "%dM", size / 1048576);
+	else if (size % 1024 == 0)
+		snprintf(str, len, "%dK", size / 1024);
+	else
+		snprintf(str, len, "%d", size);
+}
+
+static int bench(const char *host)
+{
+	int buf, size, smc, remote, ctl[2] = { -1, -1 }, rc = EXIT_FAILURE;
+	struct bench_res res[2];
+	struct sockaddr_storage sa;
+	const char *mode;
+	char sizestr[16];
+	double *samples;
+	socklen_t salen;
+
+	if (!bulk_time) {
+		fprintf(stderr, "Error: Benchmark needs a test time\n");
+		return EXIT_FAILURE;
+	}
+	if (probe_resolve(host, &sa, &salen))
+		return EXIT_FAILURE;
+	samples = malloc(BENCH_MAX_SAMPLES * sizeof(*samples));
+	if (!samples)
+		return EXIT_FAILURE;
+	remote = !bench_ports[1][0];
+	for (buf = 0; buf < bench_nbufs; buf++) {
+		for (smc = 0; smc < 2 && remote; smc++) {
+			if (ctl[smc] >= 0)
+				close(ctl[smc]);
+			ctl[smc] = probe_server_listen(&sa, salen, smc,
+						       bench_bufs[buf],
+						       &bench_ports[smc][buf]);
+			if (ctl[smc] < 0)
+				goto out;
+		}
+		mode = bench_mode(&sa, salen, buf);
+		if (!mode)
+			goto out;
+		print_size(sizestr, sizeof(sizestr), bench_bufs[buf]);
+		printf("%sBuffer size %s, SMC connections use %s\n",
+		       buf ? "\n" : "", sizestr, mode);
+		printf("%8s%-37s  %-37s  SMC/TCP\n", "",
+		       "---------------- TCP ----------------",
+		       "---------------- SMC ----------------");
+		printf("%7s %8s %8s %8s %10s  %8s %8s %8s %10s  %6s %6s\n",
+		       "Size", "p50 us", "p99 us", "p99.9 us", "MB/s",
+		       "p50 us", "p99 us", "p99.9 us", "MB/s", "p50", "MB/s");
+		for (size = BENCH_MIN_MSG; size <= PROBE_MAX_MSG; size *= 4) {
+			if (bench_one(&sa, salen, 0, buf, size, samples, &res[0]) ||
+			    bench_one(&sa, salen, 1, buf, size, samples, &res[1]))
+				goto out;
+			print_size(sizestr, sizeof(sizestr), size);
+			printf("%7s %8.1f %8.1f %8.1f %10.1f  %8.1f %8.1f %8.1f %10.1f  %6.2f %6.2f\n",
+			       sizestr, res[0].p50, res[0].p99, res[0].p999,
+			       res[0].mbps, res[1].p50, res[1].p99, res[1].p999,
+			       res[1].mbps, res[1].p50 / res[0].p50,
+			       res[1].mbps / res[0].mbps);
+			fflush(stdout);
+		}
+	}
+	rc = 0;
+out:
+	for (smc = 0; smc < 2; smc++) {
+		if (ctl[smc] >= 0)
+			close(ctl[smc]);
+	}
+	free(samples);
+	return rc;
+}
+
+/* Buffer size tuning
+ *
+ * Runs a ping-pong and a streaming test with TUNE_MSG byte messages over SMC
+ * for each buffer size, 16 KiB to 4 MiB unless given with -s. For each size
+ * the server opens a listener of its own, so both ends of the connections
+ * use it. The rmb_tx counters of the SMC statistics are sampled around each
+ * streaming test. They count all SMC connections of the host, so other SMC
+ * traffic shows up in them, too.
+ */
+#define TUNE_MIN_BUF		16384
+#define TUNE_MAX_BUF		4194304
+#define TUNE_MSG		PROBE_BUF_SIZE
+#define TUNE_PLATEAU		0.95	/* share of the best throughput */
+
+/* SMC_TYPE_R and SMC_TYPE_D of stats.h */
+enum {
+	TUNE_SMCR,
+	TUNE_SMCD,
+	TUNE_TYPES,
+};
+
+struct tune_stats {
+	uint64_t	tx_cnt;
+	uint64_t	buf_full;	/* rmb_tx.buf_full_cnt */
+	uint64_t	buf_small;	/* rmb_tx.buf_size_small_cnt */
+};
+
+struct tune_res {
+	int		bufsize;	/* requested */
+	uint32_t	sndbuf;		/* in use by the kernel */
+	uint32_t	rmbe;
+	double		mbps;
+	double		p50;		/* round trip times in us */
+	double		p99;
+	int		have_stats;
+	struct tune_stats delta;
+};
+
+static int tune_nl;	/* SMC statistics are available */
+
+static void tune_stats_tech(struct nlattr *attr, struct tune_stats *st)
+{
+	struct nlattr *tech[SMC_NLA_STATS_T_MAX + 1];
+	struct nlattr *rmb[SMC_NLA_STATS_RMB_MAX + 1];
+
+	if (nla_parse_nested(tech, SMC_NLA_STATS_T_MAX, attr, NULL))
+		return;
+	if (tech[SMC_NLA_STATS_T_TX_CNT])
+		st->tx_cnt = nla_get_u64(tech[SMC_NLA_STATS_T_TX_CNT]);
+	if (!tech[SMC_NLA_STATS_T_TX_RMB_STATS] ||
+	    nla_parse_nested(rmb, SMC_NLA_STATS_RMB_MAX,
+			     tech[SMC_NLA_STATS_T_TX_RMB_STATS], NULL))
+		return;
+	if (rmb[SMC_NLA_STATS_RMB_FULL_CNT])
+		st->buf_full = nla_get_u64(rmb[SMC_NLA_STATS_RMB_FULL_CNT]);
+	if (rmb[SMC_NLA_STATS_RMB_SIZE_SM_CNT])
+		st->buf_small = nla_get_u64(rmb[SMC_NLA_STATS_RMB_SIZE_SM_CNT]);
+}
+
+static int handle_tune_stats(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *stats[SMC_NLA_STATS_MAX + 1];
+	struct nlattr *attrs[SMC_GEN_MAX + 1];
+	struct tune_stats *st = arg;
+
+	if (genlmsg_parse(nlmsg_hdr(msg), 0, attrs, SMC_GEN_MAX,
+			  (struct nla_policy *)smc_gen_net_policy) < 0 ||
+	    !attrs[SMC_GEN_STATS] ||
+	    nla_parse_nested(stats, SMC_NLA_STATS_MAX, attrs[SMC_GEN_STATS],
+			     NULL))
+		return NL_STOP;
+	if (stats[SMC_NLA_STATS_SMCR_TECH])
+		tune_stats_tech(stats[SMC_NLA_STATS_SMCR_TECH], &st[TUNE_SMCR]);
+	if (stats[SMC_NLA_STATS_SMCD_TECH])
+		tune_stats_tech(stats[SMC_NLA_STATS_SMCD_TECH], &st[TUNE_SMCD]);
+	return NL_OK;
+}
+
+static int tune_sample(struct tune_stats *st)
+{
+	memset(st, 0, TUNE_TYPES * sizeof(*st));
+	return tune_nl && !gen_nl_handle_dump(SMC_NETLINK_GET_STATS,
+					      handle_tune_stats, st);
+}
+
+/* tests with buffer size bufsize, return 0, 2 on fallback to TCP or 1 */
+static int tune_step(struct sockaddr_storage *sa, socklen_t salen, int bufsize,
+		     double *samples, struct tune_res *res)
+{
+	struct tune_stats before[TUNE_TYPES], after[TUNE_TYPES];
+	int cfd, fd, n, type, lport, rc = EXIT_FAILURE;
+
+	/* the listener lasts as long as the control connection */
+	cfd = probe_server_listen(sa, salen, 1, bufsize, &lport);
+	if (cfd < 0)
+		return EXIT_FAILURE;
+	memset(res, 0, sizeof(*res));
+	res->bufsize = bufsize;
+
+	fd = probe_open(sa, salen, lport, 1, bufsize);
+	if (fd < 0)
+		goto out;
+	n = probe_pingpong(fd, TUNE_MSG, samples);
+	close(fd);
+	if (n <= 0)
+		goto errout;
+	res->p50 = percentile(samples, n, 0.5);
+	res->p99 = percentile(samples, n, 0.99);
+
+	fd = probe_open(sa, salen, lport, 1, bufsize);
+	if (fd < 0)
+		goto out;
+	if (probe_diag(fd)) {
+		fprintf(stderr, "Error: Cannot determine the socket mode\n");
+		close(fd);
+		goto out;
+	}
+	if (probe_res.mode != SMC_DIAG_MODE_SMCD &&
+	    probe_res.mode != SMC_DIAG_MODE_SMCR) {
+		printf("SMC connections fall back to TCP: 0x%08x %s\n",
+		       probe_res.reason, fallback_text(probe_res.reason));
+		close(fd);
+		rc = 2;
+		goto out;
+	}
+	res->sndbuf = probe_res.sndbuf;
+	res->rmbe = probe_res.rmbe;
+	type = probe_res.mode == SMC_DIAG_MODE_SMCD ? TUNE_SMCD : TUNE_SMCR;
+	res->have_stats = tune_sample(before);
+	res->mbps = probe_bulk(fd, TUNE_MSG);
+	close(fd);
+	if (res->mbps < 0)
+		goto errout;
+	if (res->have_stats && tune_sample(after)) {
+		res->delta.tx_cnt = after[type].tx_cnt - before[type].tx_cnt;
+		res->delta.buf_full = after[type].buf_full -
+				      before[type].buf_full;
+		res->delta.buf_small = after[type].buf_small -
+				       before[type].buf_small;
+	} else {
+		res->have_stats = 0;
+	}
+	rc = 0;
+	goto out;
+
+errout:
+	fprintf(stderr, "Error: Test with buffer size %d failed: %s\n",
+		bufsize, strerror(errno));
+out:
+	close(cfd);
+	return rc;
+}
+
+static void print_ratio(char *str, size_t len, struct tune_res *res,
+			uint64_t cnt)
+{
+	if (!res->have_stats || !res->delta.tx_cnt)
+		snprintf(str, len, "-");
+	else
+		snprintf(str, len, "%.2f%%",
+			 cnt / (double)res->delta.tx_cnt * 100);
+}
+
+static int tune(const char *host)
+{
+	char sizestr[4][16], full[16], small[16];
+	struct tune_res res[BENCH_MAX_BUFS];
+	struct sockaddr_storage sa;
+	double *samples, best = 0;
+	int buf, rec, rc;
+	socklen_t salen;
+
+	if (!bulk_time) {
+		fprintf(stderr, "Error: Tuning needs a test time\n");
+		return EXIT_FAILURE;
+	}
+	if (probe_resolve(host, &sa, &salen))
+		return EXIT_FAILURE;
+	samples = malloc(BENCH_MAX_SAMPLES * sizeof(*samples));
+	if (!samples)
+		return EXIT_FAILURE;
+	tune_nl = !gen_nl_open();
+	if (!tune_nl)
+		printf("SMC statistics not available, buffer counters are not shown\n");
+
+	/* ascending, so that the recommendation is the smallest size that
+	 * reaches the plateau, whatever the order of -s
+	 */
+	qsort(bench_bufs, bench_nbufs, sizeof(*bench_bufs), cmp_int);
+	printf("Buffer size sweep with %d byte messages\n", TUNE_MSG);
+	printf("%7s %7s %7s %10s %8s %8s %9s %9s\n", "Request", "Sndbuf",
+	       "RMB", "MB/s", "p50 us", "p99 us", "Buf full", "Too small");
+	for (buf = 0; buf < bench_nbufs; buf++) {
+		rc = tune_step(&sa, salen, bench_bufs[buf], samples, &res[buf]);
+		if (rc)
+			goto out;
+		print_size(sizestr[0], sizeof(sizestr[0]), res[buf].bufsize);
+		print_size(sizestr[1], sizeof(sizestr[1]), res[buf].sndbuf);
+		print_size(sizestr[2], sizeof(sizestr[2]), res[buf].rmbe);
+		print_ratio(full, sizeof(full), &res[buf],
+			    res[buf].delta.buf_full);
+		print_ratio(small, sizeof(small), &res[buf],
+			    res[buf].delta.buf_small);
+		printf("%7s %7s %7s %10.1f %8.1f %8.1f %9s %9s\n", sizestr[0],
+		       sizestr[1], sizestr[2], res[buf].mbps, res[buf].p50,
+		       res[buf].p99, full, small);
+		fflush(stdout);
+		if (res[buf].mbps > best)
+			best = res[buf].mbps;
+	}
+
+	/* smallest size within reach of the best throughput */
+	for (rec = 0; res[rec].mbps < best * TUNE_PLATEAU; rec++)
+		;
+	print_size(sizestr[0], sizeof(sizestr[0]), res[rec].bufsize);
+	print_size(sizestr[1], sizeof(sizestr[1]), res[rec].sndbuf);
+	print_size(sizestr[2], sizeof(sizestr[2]), res[rec].rmbe);
+	print_size(sizestr[3], sizeof(sizestr[3]),
+		   res[rec].sndbuf + res[rec].rmbe);
+	printf("\nThroughput plateau (%.0f%% of %.1f MB/s) reached with %s\n",
+	       TUNE_PLATEAU * 100, best, sizestr[0]);
+	printf("Recommendation: smc_run -r %s -t %s\n", sizestr[0], sizestr[0]);
+	printf("Memory per connection and host: %s (send buffer %s + RMB %s)\n",
+	       sizestr[3], sizestr[1], sizestr[2]);
+	for (buf = 1; buf < bench_nbufs; buf++) {
+		if (res[buf].bufsize > res[buf - 1].bufsize &&
+		    res[buf].sndbuf + res[buf].rmbe <=
+		    res[buf - 1].sndbuf + res[buf - 1].rmbe) {
+			print_size(sizestr[0], sizeof(sizestr[0]),
+				   res[buf].bufsize);
+			printf("Note: Requests of %s and more got no larger buffers, check the\n"
+			       "      net.core.wmem_max and net.core.rmem_max sysctls\n",
+			       sizestr[0]);
+			break;
+		}
+	}
+out:
+	if (tune_nl)
+		gen_nl_close();
+	free(samples);
+	return rc;
+}
+
+/* comma separated list of sizes with optional k or m suffix */
+static int parse_bufsizes(char *arg)
+{
+	char *tok, *end;
+	long size;
+
+	bench_nbufs = 0;
+	for (tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+		size = strtol(tok, &end, 10);
+		if (*end == 'k' || *end == 'K') {
+			size *= 1024;
+			end++;
+		} else if (*end == 'm' || *end == 'M') {
+			size *= 1048576;
+			end++;
+		}
+		if (end == tok || *end || size <= 0 || size > 0x40000000 ||
+		    bench_nbufs == BENCH_MAX_BUFS)
+			return -1;
+		bench_bufs[bench_nbufs++] = size;
+	}
+	return bench_nbufs ? 0 : -1;
+}
+
+static const struct option long_opts[] = {
+	{ "bench", 0, 0, 'b' },
+	{ "bufsize", 1, 0, 's' },
+	{ "connect", 1, 0, 'C' },
+	{ "loopback", 0, 0, 'l' },
+	{ "port", 1, 0, 'p' },
+	{ "server", 0, 0, 'S' },
+	{ "time", 1, 0, 't' },
+	{ "tune", 0, 0, 'T' },
+	{ "timeout", 1, 0, 'w' },
+	{ "ipv6", 0, 0, '6' },
+	{ "version", 0, 0, 'v' },
+	{ "help", 0, 0, 'h' },
+	{ NULL, 0, NULL, 0}
+};
+
+static void _usage(FILE *dest)
+{
+	fprintf(dest,
+"Usage: %s [ OPTIONS ] -C <IP>\n"
+"       %s [ OPTIONS ] -S\n"
+"       %s [ OPTIONS ] -l\n"
+"\t-h, --help            this message\n"
+"\t-v, --version         show version information\n"
+"\t-C, --connect <IP>    probe the SMC connectivity to IP\n"
+"\t-S, --server          run a server for probes from other hosts\n"
+"\t-l, --loopback        probe against a server started on the loopback\n"
+"\t                      address\n"
+"\t-b, --bench           compare the latency and throughput of TCP and SMC\n"
+"\t                      for message sizes from 64 bytes to 1 MiB\n"
+"\t-T, --tune            find the smallest SMC buffer size that reaches the\n"
+"\t                      throughput plateau\n"
+"\t-s, --bufsize <SIZES> benchmark or tune with each of the comma separated\n"
+"\t                      buffer SIZES, the server uses the first one\n"
+"\t-p, --port <PORT>     use port PORT (default: %d)\n"
+"\t-t, --time <MS>       transfer data for MS milliseconds to measure the\n"
+"\t                      throughput, 0 to skip, also the duration of each\n"
+"\t                      benchmark test (default: %d)\n"
+"\t-w, --timeout <MS>    connect timeout in milliseconds (default: %d)\n"
+"\t-6, --ipv6            use IPv6\n",
+		progname, progname, progname, PROBE_PORT_DFT, PROBE_BULK_DFT,
+		PROBE_TIMEOUT_DFT);
+}
+
+static void help(void) __attribute__((noreturn));
+static void help(void)
+{
+	_usage(stdout);
+	exit(EXIT_SUCCESS);
+}
+
+static void usage(void) __attribute__((noreturn));
+static void usage(void)
+{
+	_usage(stderr);
+	exit(EXIT_FAILURE);
+}
+
+static int get_num(const char *arg, int min, int max)
+{
+	char *end;
+	long val;
+
+	val = strtol(arg, &end, 10);
+	if (!*arg || *end || val < min || val > max) {
+		fprintf(stderr, "Error: Invalid value '%s'\n", arg);
+		usage();
+	}
+	return val;
+}
+
+/* server thread on the loopback address, return its port or -1 */
+static int start_server(int family, int lport, int smc, int bufsize)
+{
+	pthread_t tid;
+	int lfd;
+
+	lfd = probe_listen(family, family == AF_INET6 ? "::1" : "127.0.0.1",
+			   lport, smc, bufsize);
+	if (lfd < 0)
+		return -1;
+	if (pthread_create(&tid, NULL, serve, (void *)(long)lfd)) {
+		fprintf(stderr, "Error: Cannot start the server\n");
+		close(lfd);
+		return -1;
+	}
+	return probe_local_port(lfd);
+}
+
+int main(int argc, char *argv[])
+{
+	int ch, lfd, family, buf, smc, server = 0, loopback = 0, do_bench = 0;
+	int do_tune = 0;
+	char *slash, *host = NULL;
+
+	progname = (slash = strrchr(argv[0], '/')) ? slash + 1 : argv[0];
+
+	while ((ch = getopt_long(argc, argv, "bC:lp:s:St:Tw:6vh", long_opts, NULL)) != EOF) {
+		switch (ch) {
+		case 'b':
+			do_bench++;
+			break;
+		case 'C':
+			host = optarg;
+			break;
+		case 's':
+			if (parse_bufsizes(optarg)) {
+				fprintf(stderr, "Error: Invalid buffer sizes '%s'\n",
+					optarg);
+				usage();
+			}
+			break;
+		case 'l':
+			loopback++;
+			break;
+		case 'p':
+			port = get_num(optarg, 0, 65535);
+			break;
+		case 'S':
+			server++;
+			break;
+		case 't':
+			bulk_time = get_num(optarg, 0, 3600000);
+			break;
+		case 'T':
+			do_tune++;
+			break;
+		case 'w':
+			timeout = get_num(optarg, 1, 3600000);
+			break;
+		case '6':
+			ipv6++;
+			break;
+		case 'v':
+			printf("smc_probe utility, smc-tools-%s\n", RELEASE_STRING);
+			exit(0);
+		case 'h':
+			help();
+		case '?':
+		default:
+			usage();
+		}
+	}
+	if (optind < argc || (!!host + server + loopback) != 1 ||
+	    (do_bench && do_tune))
+		usage();
+	if (do_tune && !bench_bufs[0]) {
+		for (bench_nbufs = 0; TUNE_MIN_BUF << bench_nbufs <= TUNE_MAX_BUF;
+		     bench_nbufs++)
+			bench_bufs[bench_nbufs] = TUNE_MIN_BUF << bench_nbufs;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	family = ipv6 ? AF_INET6 : AF_INET;
+	if (server) {
+		lfd = probe_listen(family, NULL, port, 1, bench_bufs[0]);
+		if (lfd < 0)
+			return EXIT_FAILURE;
+		printf("Server listening on port %d\n", probe_local_port(lfd));
+		fflush(stdout);
+		serve((void *)(long)lfd);
+		return EXIT_FAILURE;
+	}
+	for (buf = 0; buf < bench_nbufs; buf++) {
+		for (smc = 0; smc < 2; smc++) {
+			if (!loopback)
+				continue;
+			/* listeners of the benchmark take the buffer size of
+			 * the test, the probe one the given port
+			 */
+			if (do_bench || (smc && !buf))
+				bench_ports[smc][buf] = start_server(family,
+					do_bench || port == PROBE_PORT_DFT ? 0 : port,
+					smc, bench_bufs[buf]);
+			if (bench_ports[smc][buf] < 0)
+				return EXIT_FAILURE;
+		}
+	}
+	if (loopback) {
+		host = ipv6 ? "::1" : "127.0.0.1";
+		port = bench_ports[1][0];
+	}
+
+	if (do_tune)
+		return tune(host);
+	return do_bench ? bench(host) : probe(host);
+}
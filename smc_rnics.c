@@ -0,0 +1,725 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2018, 2022
+ *
+ * User space program to list, enable and disable (R)NICs as used by SMC
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+#define _GNU_SOURCE		/* scandirat */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <iconv.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/utsname.h>
+#include <net/if.h>
+#include <linux/ethtool.h>
+#include <linux/sockios.h>
+
+#include "smctools_common.h"
+
+#define SYSFS_DFT	"/sys"
+#define PNETID_LEN	16		/* per port in util_string */
+#define PNETID_PORTS	4
+#define RNIC_LINE_LEN	1024
+
+/* PCI function types */
+#define PFT_ROCE	0x02
+#define PFT_ISM		0x05
+#define PFT_ROCE2	0x0a
+#define PFT_NETH	0x0c
+#define PFT_NETD	0x0f
+
+/* PCI function, taken from /sys/bus/pci/devices */
+struct pci_func {
+	unsigned long	fid;		/* function_id */
+	char		addr[NAME_MAX + 1];
+};
+
+/* one line of output */
+struct rnic {
+	unsigned long	fid;
+	char		power[8];
+	char		addr[NAME_MAX + 1];
+	char		pchid[32];
+	char		type[40];
+	char		pft[16];
+	char		vfn[16];
+	char		port[16];
+	char		iface[NAME_MAX + 1];
+	char		pnetids[PNETID_PORTS * PNETID_LEN + 1];
+};
+
+/* softset PNET IDs as listed by smc_pnet */
+struct pnet_entry {
+	char		pnetid[PNETID_LEN + 1];
+	char		iface[IFNAMSIZ];
+	char		dev[NAME_MAX + 1];
+	int		port;
+};
+
+static char *progname;
+static int all;
+static int ib_dev;
+static int raw_ids;
+static const char *sysfs = SYSFS_DFT;
+static int slots_fd = -1;
+static int devs_fd = -1;
+
+static struct pci_func *funcs;		/* sorted by FID */
+static int nfuncs;
+
+static char **lines;
+static int nlines;
+
+static struct pnet_entry *pnet_tab;
+static int npnet = -1;			/* not read yet */
+
+static const struct option long_opts[] = {
+	{ "all", 0, 0, 'a' },
+	{ "disable", 1, 0, 'd' },
+	{ "enable", 1, 0, 'e' },
+	{ "help", 0, 0, 'h' },
+	{ "IB-dev", 0, 0, 'I' },
+	{ "rawids", 0, 0, 'r' },
+	{ "root", 1, 0, 'R' },
+	{ "version", 0, 0, 'v' },
+	{ NULL, 0, NULL, 0}
+};
+
+static void _usage(FILE *dest)
+{
+	fprintf(dest,
+"Usage: %s [ OPTIONS ] [ FID ]\n"
+"\n"
+"List RNICs\n"
+"\n"
+"\t-a, --all            include disabled devices in output\n"
+"\t-d, --disable <FID>  disable the specified FID\n"
+"\t-e, --enable <FID>   enable the specified FID\n"
+"\t-h, --help           display this message\n"
+"\t-I, --IB-dev         display IB-dev instead of netdev attributes\n"
+"\t-r, --rawids         display 'type' as raw vendor/device IDs\n"
+"\t-R, --root <DIR>     read sysfs from DIR instead of %s\n"
+"\t-v, --version        display version info\n",
+		progname, SYSFS_DFT);
+}
+
+static void help(void) __attribute__((noreturn));
+static void help(void)
+{
+	_usage(stdout);
+	exit(0);
+}
+
+static void usage(int rc) __attribute__((noreturn));
+static void usage(int rc)
+{
+	_usage(stderr);
+	exit(rc);
+}
+
+/* contents of file path below dirfd, return its length or -1 */
+static ssize_t read_raw(int dirfd, const char *path, char *buf, size_t len)
+{
+	ssize_t rc;
+	int fd;
+
+	fd = openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	rc = pread(fd, buf, len, 0);
+	close(fd);
+	return rc;
+}
+
+/* sysfs attribute as a string without the trailing newline, "" on errors */
+static int read_attr(int dirfd, const char *path, char *buf, size_t len)
+{
+	ssize_t rc;
+
+	rc = read_raw(dirfd, path, buf, len - 1);
+	if (rc < 0) {
+		*buf = '\0';
+		return -1;
+	}
+	buf[rc] = '\0';
+	while (rc > 0 && buf[rc - 1] == '\n')
+		buf[--rc] = '\0';
+	return rc;
+}
+
+static int no_dots(const struct dirent *d)
+{
+	return d->d_name[0] != '.';
+}
+
+/* sorted entries of directory path below dirfd, 0 if it does not exist */
+static int list_dir(int dirfd, const char *path, struct dirent ***list)
+{
+	int n;
+
+	*list = NULL;
+	n = scandirat(dirfd, path, list, no_dots, alphasort);
+	return n < 0 ? 0 : n;
+}
+
+static void free_list(struct dirent **list, int n)
+{
+	while (n-- > 0)
+		free(list[n]);
+	free(list);
+}
+
+static int cmp_func(const void *a, const void *b)
+{
+	const struct pci_func *x = a, *y = b;
+
+	if (x->fid != y->fid)
+		return x->fid < y->fid ? -1 : 1;
+	return strcmp(x->addr, y->addr);
+}
+
+/* read the function IDs of all PCI devices once */
+static int index_funcs(void)
+{
+	struct dirent **list;
+	char path[PATH_MAX], buf[32];
+	int i, n;
+
+	n = list_dir(devs_fd, ".", &list);
+	funcs = calloc(n ? n : 1, sizeof(*funcs));
+	if (!funcs) {
+		free_list(list, n);
+		return -1;
+	}
+	for (i = 0; i < n; i++) {
+		snprintf(path, sizeof(path), "%s/function_id", list[i]->d_name);
+		if (read_attr(devs_fd, path, buf, sizeof(buf)) > 0) {
+			funcs[nfuncs].fid = strtoul(buf, NULL, 16);
+			strcpy(funcs[nfuncs].addr, list[i]->d_name);
+			nfuncs++;
+		}
+	}
+	free_list(list, n);
+	qsort(funcs, nfuncs, sizeof(*funcs), cmp_func);
+	return 0;
+}
+
+/* first PCI device with function ID fid */
+static const char *find_func(unsigned long fid)
+{
+	int lo = 0, hi = nfuncs, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (funcs[mid].fid < fid)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo < nfuncs && funcs[lo].fid == fid ? funcs[lo].addr : NULL;
+}
+
+static void read_pnet_table(void)
+{
+	struct pnet_entry *tmp;
+	char line[RNIC_LINE_LEN];
+	FILE *fp;
+	int max = 0;
+
+	npnet = 0;
+	fp = popen("smc_pnet 2>/dev/null", "r");
+	if (!fp)
+		return;
+	while (fgets(line, sizeof(line), fp)) {
+		if (npnet == max) {
+			max = max ? 2 * max : 16;
+			tmp = realloc(pnet_tab, max * sizeof(*pnet_tab));
+			if (!tmp)
+				break;
+			pnet_tab = tmp;
+		}
+		if (sscanf(line, "%16s %15s %255s %d", pnet_tab[npnet].pnetid,
+			   pnet_tab[npnet].iface, pnet_tab[npnet].dev,
+			   &pnet_tab[npnet].port) == 4)
+			npnet++;
+	}
+	pclose(fp);
+}
+
+/* PNET ID defined via smc_pnet, marked with an asterisk */
+static void get_softset_pnet_id(struct rnic *r, int iport, char *res,
+				size_t len)
+{
+	struct pnet_entry *p;
+	int i;
+
+	if (npnet < 0)
+		read_pnet_table();
+	snprintf(res, len, "n/a");
+	for (i = 0; i < npnet; i++) {
+		p = &pnet_tab[i];
+		if ((strcmp(p->iface, "n/a") && !strcmp(p->iface, r->iface)) ||
+		    (strcmp(p->dev, "n/a") && !strcmp(p->dev, r->addr))) {
+			if (p->port != 255 && p->port != iport)
+				continue;
+			snprintf(res, len, "%s*", p->pnetid);
+		}
+	}
+}
+
+static void get_pnet_from_port(struct rnic *r, char *res, size_t len)
+{
+	const char *src;
+	int lport, i, n = 0;
+
+	*res = '\0';
+	if (!*r->port)
+		return;
+	if (!strcmp(r->port, "n/a") || strcmp(r->type, "RoCE_Express")) {
+		lport = 0;
+	} else {
+		lport = atoi(r->port);
+		if (ib_dev)
+			lport--;
+	}
+	if (lport >= 0 && lport < PNETID_PORTS) {
+		src = r->pnetids + lport * PNETID_LEN;
+		for (i = 0; i < PNETID_LEN && src[i] && n < (int)len - 1; i++)
+			if (src[i] != ' ')
+				res[n++] = src[i];
+		res[n] = '\0';
+	}
+	if (!n)
+		get_softset_pnet_id(r, lport + 1, res, len);
+}
+
+static void print_rnic(struct rnic *r)
+{
+	char line[RNIC_LINE_LEN], pnet[PNETID_LEN + 2], vfn[16];
+	char **tmp;
+
+	get_pnet_from_port(r, pnet, sizeof(pnet));
+	if (raw_ids && *r->vfn)
+		snprintf(vfn, sizeof(vfn), "%lu", strtoul(r->vfn, NULL, 16));
+	else
+		snprintf(vfn, sizeof(vfn), "%s", r->vfn);
+	snprintf(line, sizeof(line),
+		 "%4lx  %-5s  %-12s  %-4s   %-15s  %-4s  %-3s  %-4s  %-17s  %s\n",
+		 r->fid, r->power, r->addr, r->pchid, r->type, r->pft, vfn,
+		 r->port, pnet, r->iface);
+	tmp = realloc(lines, (nlines + 1) * sizeof(*lines));
+	if (!tmp)
+		return;
+	lines = tmp;
+	lines[nlines] = strdup(line);
+	if (lines[nlines])
+		nlines++;
+}
+
+static void print_header(void)
+{
+	printf("FID   Power  PCI_ID        PCHID  Type             PFT   %-3s  %s  PNET_ID            %s\n",
+	       raw_ids ? "VFN" : "VF", ib_dev ? "IPrt" : "PPrt",
+	       ib_dev ? "IB-Dev" : "Net-Dev");
+	printf("----------------------------------------------------------------------------------------------------\n");
+}
+
+/* for the PFTs of known devices */
+static void set_pft_and_vfn(struct rnic *r, unsigned long pft)
+{
+	switch (pft) {
+	case PFT_ROCE:
+		strcpy(r->pft, "ROC");
+		break;
+	case PFT_ISM:
+		strcpy(r->pft, "ISM");
+		break;
+	case PFT_ROCE2:
+		strcpy(r->pft, "ROC2");
+		break;
+	case PFT_NETH:
+		strcpy(r->pft, "NETH");
+		break;
+	case PFT_NETD:
+		strcpy(r->pft, "NETD");
+		strcpy(r->vfn, strtoul(r->vfn, NULL, 16) ? "y" : "n");
+		return;
+	}
+	strcpy(r->vfn, "y");
+}
+
+/* physical port from the port attribute of the device */
+static void set_port(struct rnic *r, int dfd)
+{
+	char buf[16];
+	int port;
+
+	if (read_attr(dfd, "port", buf, sizeof(buf)) < 0)
+		return;
+	port = atoi(buf);
+	if (!port)
+		strcpy(r->port, "n/a");
+	else
+		snprintf(r->port, sizeof(r->port), "%d", ib_dev ? 1 : port - 1);
+}
+
+/* RoCE Express2 and 3 share a PFT, tell them apart by their firmware */
+static const char *roce_by_firmware_lvl(int dfd)
+{
+	struct ethtool_drvinfo info = { .cmd = ETHTOOL_GDRVINFO };
+	const char *name = "";
+	struct dirent **list;
+	struct ifreq ifr;
+	int n, sk;
+
+	n = list_dir(dfd, "net", &list);
+	if (!n)
+		return name;
+	memset(&ifr, 0, sizeof(ifr));
+	snprintf(ifr.ifr_name, IFNAMSIZ, "%.*s", IFNAMSIZ - 1, list[0]->d_name);
+	free_list(list, n);
+	ifr.ifr_data = (void *)&info;
+	sk = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (sk < 0)
+		return name;
+	if (!ioctl(sk, SIOCETHTOOL, &ifr)) {
+		if (atoi(info.fw_version) == 22)
+			name = "RoCE_Express3";
+		else if (atoi(info.fw_version) == 14)
+			name = "RoCE_Express2";
+	}
+	close(sk);
+	return name;
+}
+
+/* util_string holds the PNET IDs of the ports in EBCDIC, blank padded */
+static void read_pnetids(struct rnic *r, int dfd)
+{
+	char raw[PNETID_PORTS * PNETID_LEN];
+	char *in = raw, *out = r->pnetids;
+	size_t inlen, outlen = sizeof(r->pnetids) - 1;
+	ssize_t i, len;
+	iconv_t cd;
+
+	*r->pnetids = '\0';
+	len = read_raw(dfd, "util_string", raw, sizeof(raw));
+	if (len <= 0)
+		return;
+	for (i = 0; i < len; i++)
+		if (!raw[i])
+			raw[i] = 0x40;		/* EBCDIC blank */
+	cd = iconv_open("ASCII", "IBM1047");
+	if (cd == (iconv_t)-1)
+		return;
+	inlen = len;
+	iconv(cd, &in, &inlen, &out, &outlen);
+	*out = '\0';
+	iconv_close(cd);
+}
+
+static void print_func(struct rnic *r, int dfd)
+{
+	struct dirent **list;
+	char buf[32], path[PATH_MAX];
+	unsigned long pft;
+	int n, i, pfd;
+
+	pft = strtoul(r->pft, NULL, 16);
+	if (!raw_ids) {
+		switch (pft) {
+		case PFT_ISM:
+			strcpy(r->type, "ISM");
+			strcpy(r->iface, "n/a");
+			break;
+		case PFT_ROCE:
+			strcpy(r->type, "RoCE_Express");
+			set_port(r, dfd);
+			break;
+		case PFT_ROCE2:
+			strcpy(r->type, roce_by_firmware_lvl(dfd));
+			set_port(r, dfd);
+			break;
+		case PFT_NETH:
+		case PFT_NETD:
+			strcpy(r->type, "Network_Express");
+			set_port(r, dfd);
+			break;
+		default:
+			/* determine the VF flag of unknown devices from VFN */
+			if (!all)
+				return;
+			strcpy(r->vfn, strtoul(r->vfn, NULL, 16) ? "y" : "n");
+			goto common;
+		}
+		set_pft_and_vfn(r, pft);
+	}
+common:
+	read_attr(dfd, "pchid", buf, sizeof(buf));
+	snprintf(r->pchid, sizeof(r->pchid), "%s",
+		 strncmp(buf, "0x", 2) ? buf : buf + 2);
+	read_pnetids(r, dfd);
+
+	if (!ib_dev) {
+		/* one device can have multiple interfaces (one per port) */
+		n = list_dir(dfd, "net", &list);
+		if (!n) {
+			strcpy(r->iface, "n/a");
+			print_rnic(r);
+			return;
+		}
+		for (i = 0; i < n; i++) {
+			snprintf(r->iface, sizeof(r->iface), "%s",
+				 list[i]->d_name);
+			/* not the dev_port of the previous interface */
+			set_port(r, dfd);
+			/* only raw PFTs are numbers */
+			if (!strcmp(r->pft, "0x02")) {
+				snprintf(path, sizeof(path), "net/%s/dev_port",
+					 r->iface);
+				if (read_attr(dfd, path, buf, sizeof(buf)) >= 0)
+					snprintf(r->port, sizeof(r->port),
+						 "%.15s", buf);
+			}
+			print_rnic(r);
+		}
+		free_list(list, n);
+		return;
+	}
+	/* only one IB interface per card */
+	n = list_dir(dfd, "infiniband", &list);
+	if (!n) {
+		strcpy(r->iface, "n/a");
+		print_rnic(r);
+		return;
+	}
+	snprintf(r->iface, sizeof(r->iface), "%s", list[0]->d_name);
+	free_list(list, n);
+	snprintf(path, sizeof(path), "infiniband/%s", r->iface);
+	pfd = openat(dfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (pfd < 0)
+		return;
+	n = list_dir(pfd, "ports", &list);
+	for (i = 0; i < n; i++) {
+		snprintf(r->port, sizeof(r->port), "%.15s", list[i]->d_name);
+		print_rnic(r);
+	}
+	free_list(list, n);
+	close(pfd);
+}
+
+static void print_slot(const char *slot, const char *target)
+{
+	char path[PATH_MAX], vend[16], dev[16], *end;
+	const char *addr;
+	struct rnic r;
+	int dfd;
+
+	memset(&r, 0, sizeof(r));
+	r.fid = strtoul(slot, &end, 16);
+	if (*end || (target && strcmp(slot, target)))
+		return;
+	snprintf(path, sizeof(path), "%s/power", slot);
+	read_attr(slots_fd, path, r.power, sizeof(r.power));
+	strcpy(r.port, "n/a");
+	if (!strcmp(r.power, "0")) {
+		/* device not yet hotplugged */
+		if (all) {
+			*r.port = '\0';
+			print_rnic(&r);
+		}
+		return;
+	}
+	/* device is hotplugged - locate it */
+	addr = find_func(r.fid);
+	if (!addr) {
+		fprintf(stderr, "Error: No matching device found for FID %s\n",
+			slot);
+		return;
+	}
+	snprintf(r.addr, sizeof(r.addr), "%s", addr);
+	dfd = openat(devs_fd, addr, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (dfd < 0)
+		return;
+	read_attr(dfd, "vendor", vend, sizeof(vend));
+	read_attr(dfd, "device", dev, sizeof(dev));
+	snprintf(r.type, sizeof(r.type), "%s:%s",
+		 strncmp(vend, "0x", 2) ? vend : vend + 2,
+		 strncmp(dev, "0x", 2) ? dev : dev + 2);
+	read_attr(dfd, "pft", r.pft, sizeof(r.pft));
+	read_attr(dfd, "vfn", r.vfn, sizeof(r.vfn));
+	print_func(&r, dfd);
+	close(dfd);
+}
+
+static int cmp_line(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+static int print_rnics(const char *target)
+{
+	struct dirent **list;
+	int i, n;
+
+	if (index_funcs())
+		return -1;
+	print_header();
+	/* iterate over slots, as powered-off devices won't show elsewhere */
+	n = list_dir(slots_fd, ".", &list);
+	for (i = 0; i < n; i++)
+		print_slot(list[i]->d_name, target);
+	free_list(list, n);
+
+	qsort(lines, nlines, sizeof(*lines), cmp_line);
+	for (i = 0; i < nlines; i++) {
+		fputs(lines[i], stdout);
+		free(lines[i]);
+	}
+	free(lines);
+	free(funcs);
+	free(pnet_tab);
+	return nlines;
+}
+
+/* FID as used for the slot names: 8 hex digits */
+static void format_fid(const char *arg, char *res, size_t len)
+{
+	const char *hex = strncmp(arg, "0x", 2) ? arg : arg + 2;
+	unsigned long fid;
+	char *end;
+
+	errno = 0;
+	fid = strtoul(hex, &end, 16);
+	if (!*hex || *end || *hex == '-' || *hex == '+' || errno ||
+	    fid > 0xffffffffUL) {
+		fprintf(stderr, "Error: '%s' is not a valid FID\n", hex);
+		exit(3);
+	}
+	snprintf(res, len, "%08lx", fid);
+}
+
+static int set_power(const char *fid, int val)
+{
+	char path[PATH_MAX], buf[8];
+	unsigned long ufid;
+	struct stat st;
+	int fd, rc;
+
+	ufid = strtoul(fid, NULL, 16);
+	if (fstatat(slots_fd, fid, &st, 0) || !S_ISDIR(st.st_mode)) {
+		fprintf(stderr, "Error: FID %lx does not exist\n", ufid);
+		return 5;
+	}
+	snprintf(path, sizeof(path), "%s/power", fid);
+	read_attr(slots_fd, path, buf, sizeof(buf));
+	if (atoi(buf) == val) {
+		fprintf(stderr, "Error: FID %lx is already %s\n", ufid,
+			val ? "enabled" : "disabled");
+		return 6;
+	}
+	fd = openat(slots_fd, path, O_WRONLY | O_CLOEXEC);
+	rc = fd < 0 || write(fd, val ? "1\n" : "0\n", 2) != 2;
+	if (fd >= 0 && close(fd))
+		rc = 1;
+	if (rc) {
+		fprintf(stderr, "Error: Failed to %s FID %lx\n",
+			val ? "enable" : "disable", ufid);
+		return 7;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	char fid[16], target[16], *slash, *action_fid = NULL;
+	int ch, sysfs_fd, rc, root = 0, action = -1;
+	struct utsname uts;
+
+	progname = (slash = strrchr(argv[0], '/')) ? slash + 1 : argv[0];
+	*target = '\0';
+
+	while ((ch = getopt_long(argc, argv, "ad:e:hIrR:v", long_opts, NULL)) != EOF) {
+		switch (ch) {
+		case 'a':
+			all = 1;
+			break;
+		case 'd':
+			action = 0;
+			action_fid = optarg;
+			break;
+		case 'e':
+			action = 1;
+			action_fid = optarg;
+			break;
+		case 'h':
+			help();
+		case 'I':
+			ib_dev = 1;
+			break;
+		case 'r':
+			raw_ids = 1;
+			break;
+		case 'R':
+			sysfs = optarg;
+			root = 1;
+			break;
+		case 'v':
+			printf("smc_rnics utility, smc-tools-%s\n", RELEASE_STRING);
+			exit(0);
+		case '?':
+		default:
+			usage(2);
+		}
+	}
+	for (; optind < argc; optind++)
+		format_fid(argv[optind], target, sizeof(target));
+
+	/* a fake sysfs tree can be inspected on any platform */
+	if (!root && (uname(&uts) || strncmp(uts.machine, "s390", 4))) {
+		fprintf(stderr, "Error: s390/s390x supported only\n");
+		exit(1);
+	}
+	sysfs_fd = open(sysfs, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (sysfs_fd < 0) {
+		fprintf(stderr, "Error: Cannot open %s: %s\n", sysfs,
+			strerror(errno));
+		exit(1);
+	}
+	slots_fd = openat(sysfs_fd, "bus/pci/slots",
+			  O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	devs_fd = openat(sysfs_fd, "bus/pci/devices",
+			 O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	close(sysfs_fd);
+
+	if (action >= 0) {
+		if (*target)
+			usage(4);
+		format_fid(action_fid, fid, sizeof(fid));
+		return set_power(fid, action);
+	}
+
+	rc = print_rnics(*target ? target : NULL);
+	if (rc < 0) {
+		fprintf(stderr, "Error: Out of memory\n");
+		return 1;
+	}
+	if (*target && !rc)
+		return 8;
+
+	return 0;
+}
@@ -35,6 +35,8 @@ int show_smcd;
 int show_wide;
 int listening = 0;
 int all = 0;
+static int sample_interval;
+static int sample_count;
 
 static void print_header(void)
 {
@@ -164,9 +166,8 @@ static void show_one_smc_sock(struct nlmsghdr *nlh)
 	unsigned long long inode;
 	char txtbuf[128];
 
-	parse_rtattr(tb, SMC_DIAG_MAX, (struct rtattr *)(r+1),
-		     nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*r)));
-
+	if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(*r)))
+		return;	/* truncated message */
 	if (listening) {
 		if ( r->diag_state != 10)
 			return;
@@ -178,6 +179,12 @@ static void show_one_smc_sock(struct nlmsghdr *nlh)
 		return;	/* show only SMC-R sockets */
 	if (show_smcd && r->diag_mode != SMC_DIAG_MODE_SMCD)
 		return;	/* show only SMC-D sockets */
+	/* filter on the fixed header first, most sockets are skipped
+	 * when only listening or only SMC-R/-D sockets are of interest,
+	 * see the "smcss-listening" case of "make bench"
+	 */
+	parse_rtattr(tb, SMC_DIAG_MAX, (struct rtattr *)(r+1),
+		     nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*r)));
 
 	printf("%-14s ", smc_state(r->diag_state));
 	printf("%05d ", r->diag_uid);
@@ -203,7 +210,7 @@ static void show_one_smc_sock(struct nlmsghdr *nlh)
 		printf("TCP ");
 		/* when available print local and peer fallback reason code */
 		if (tb[SMC_DIAG_FALLBACK] &&
-		    tb[SMC_DIAG_FALLBACK]->rta_len >= sizeof(struct smc_diag_fallback))
+		    RTA_PAYLOAD(tb[SMC_DIAG_FALLBACK]) >= sizeof(struct smc_diag_fallback))
 		{
 			struct smc_diag_fallback fallback;
 
@@ -221,7 +228,7 @@ static void show_one_smc_sock(struct nlmsghdr *nlh)
 
 	if (show_debug) {
 		if (tb[SMC_DIAG_SHUTDOWN] &&
-		    tb[SMC_DIAG_SHUTDOWN]->rta_len >= sizeof(__u8))
+		    RTA_PAYLOAD(tb[SMC_DIAG_SHUTDOWN]) >= sizeof(__u8))
 		{
 			unsigned char mask;
 
@@ -230,7 +237,7 @@ static void show_one_smc_sock(struct nlmsghdr *nlh)
 		}
 
 		if (tb[SMC_DIAG_CONNINFO] &&
-		    tb[SMC_DIAG_CONNINFO]->rta_len >= sizeof(struct smc_diag_conninfo))
+		    RTA_PAYLOAD(tb[SMC_DIAG_CONNINFO]) >= sizeof(struct smc_diag_conninfo))
 		{
 			struct smc_diag_conninfo cinfo;
 
@@ -254,23 +261,27 @@ static void show_one_smc_sock(struct nlmsghdr *nlh)
 
 	if (show_smcr) {
 		if (tb[SMC_DIAG_LGRINFO] &&
-		    tb[SMC_DIAG_LGRINFO]->rta_len >= sizeof(struct smc_diag_lgrinfo))
+		    RTA_PAYLOAD(tb[SMC_DIAG_LGRINFO]) >= sizeof(struct smc_diag_lgrinfo))
 		{
 			struct smc_diag_lgrinfo linfo;
 
 			linfo = *(struct smc_diag_lgrinfo *)RTA_DATA(tb[SMC_DIAG_LGRINFO]);
 			printf("%4s ", linfo.role ? "SERV" : "CLNT");
-			printf("%-15s ", linfo.lnk[0].ibname);
+			/* the names are not terminated if they fill the arrays */
+			printf("%-15.*s ", (int)sizeof(linfo.lnk[0].ibname),
+			       linfo.lnk[0].ibname);
 			printf("%02x   ", linfo.lnk[0].ibport);
 			printf("%02x     ", linfo.lnk[0].link_id);
-			printf("%-40s ", linfo.lnk[0].gid);
-			printf("%s", linfo.lnk[0].peer_gid);
+			printf("%-40.*s ", (int)sizeof(linfo.lnk[0].gid),
+			       linfo.lnk[0].gid);
+			printf("%.*s", (int)sizeof(linfo.lnk[0].peer_gid),
+			       linfo.lnk[0].peer_gid);
 		}
 	}
 
 	if (show_smcd) {
 		if (tb[SMC_DIAG_DMBINFO] &&
-		    tb[SMC_DIAG_DMBINFO]->rta_len >= sizeof(struct smcd_diag_dmbinfo))
+		    RTA_PAYLOAD(tb[SMC_DIAG_DMBINFO]) >= sizeof(struct smcd_diag_dmbinfo))
 		{
 			struct smcd_diag_dmbinfo dinfo;
 
@@ -291,6 +302,9 @@ static int smc_show_netlink()
 {
 	struct rtnl_handle rth;
 	unsigned char cmd = 0;
+	struct timespec ts;
+	char tstamp[32];
+	unsigned int n;
 	int rc = 0;
 
 	if ((rc = rtnl_open(&rth)))
@@ -307,12 +321,31 @@ static int smc_show_netlink()
 	if (show_smcd)
 		cmd |= (1<<(SMC_DIAG_DMBINFO-1));
 
-	if ((rc = sockdiag_send(rth.fd, cmd)))
+	if (!sample_interval && !sample_count) {
+		if ((rc = sockdiag_send(rth.fd, cmd)))
+			goto exit;
+		print_header();
+		rc = rtnl_dump(&rth, show_one_smc_sock);
 		goto exit;
+	}
 
-	print_header();
-
-	rc = rtnl_dump(&rth, show_one_smc_sock);
+	/* like vmstat: without count until interrupted, one socket for all */
+	if (!sample_interval)
+		sample_interval = 1;
+	for (n = 0; !sample_count || n < (unsigned int)sample_count; n++) {
+		if (nl_sample(n, sample_interval, &ts))
+			break;
+		strftime(tstamp, sizeof(tstamp), "%Y-%m-%d %H:%M:%S",
+			 localtime(&ts.tv_sec));
+		printf("%sSample %u at %s.%03ld\n", n ? "\n" : "", n, tstamp,
+		       ts.tv_nsec / 1000000);
+		if ((rc = sockdiag_send(rth.fd, cmd)))
+			break;
+		print_header();
+		if ((rc = rtnl_dump(&rth, show_one_smc_sock)))
+			break;
+		fflush(stdout);
+	}
 
 exit:
 	rtnl_close(&rth);
@@ -327,6 +360,8 @@ static const struct option long_opts[] = {
 	{ "smcr", 0, 0, 'R' },
 	{ "version", 0, 0, 'v' },
 	{ "wide", 0, 0, 'W' },
+	{ "interval", 1, 0, 'i' },
+	{ "count", 1, 0, 'c' },
 	{ "help", 0, 0, 'h' },
 	{ NULL, 0, NULL, 0}
 };
@@ -343,6 +378,8 @@ static void _usage(FILE *dest)
 "\t-W, --wide          do not truncate IP addresses\n"
 "\t-D, --smcd          show detailed SMC-D information (shows only SMC-D sockets)\n"
 "\t-R, --smcr          show detailed SMC-R information (shows only SMC-R sockets)\n"
+"\t-i, --interval SEC   repeat every SEC seconds on the same netlink socket\n"
+"\t-c, --count NUM      stop after NUM samples\n"
 "\tno OPTIONS          show all connected sockets\n",
 		progname);
 }
@@ -368,7 +405,7 @@ int main(int argc, char *argv[])
 
 	progname = (slash = strrchr(argv[0], '/')) ? slash + 1 : argv[0];
 
-	while ((ch = getopt_long(argc, argv, "aldDRhvW", long_opts, NULL)) != EOF) {
+	while ((ch = getopt_long(argc, argv, "aldDRhvWi:c:", long_opts, NULL)) != EOF) {
 		switch (ch) {
 		case 'a':
 			all++;
@@ -391,6 +428,16 @@ int main(int argc, char *argv[])
 		case 'W':
 			show_wide++;
 			break;
+		case 'i':
+			sample_interval = atoi(optarg);
+			if (sample_interval <= 0)
+				usage();
+			break;
+		case 'c':
+			sample_count = atoi(optarg);
+			if (sample_count <= 0)
+				usage();
+			break;
 		case 'h':
 			help();
 		case '?':
@@ -18,6 +18,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <syslog.h>
+#include <time.h>
 #include <sys/file.h>
 
 #include "smctools_common.h"
@@ -36,6 +38,7 @@ static int is_abs = 0;
 static int show_cmd = 0;
 static int reset_cmd = 0;
 static int json_cmd = 0;
+static int watch_cmd = 0;
 static int cache_file_exists = 0;
 
 struct smc_stats smc_stat;	/* kernel values, might contain merged values */
@@ -46,6 +49,35 @@ struct smc_stats_rsn smc_rsn_c;
 struct smc_stats_rsn smc_rsn_org;
 FILE *cache_fp = NULL;
 char *cache_file_path = NULL;
+extern char *myname;
+
+#define SMC_MAX_ALERT_RULES	16
+#define SMC_WATCH_INTERVAL_DFT	5
+
+/* Metrics evaluated by "stats watch", all in percent per interval */
+enum {
+	SMC_METRIC_FBACK_RATE,		/* fallbacks per connection */
+	SMC_METRIC_HSHAKE_ERR_RATE,	/* handshake errors per connection */
+	SMC_METRIC_TX_BUF_FULL,		/* rmb_tx.buf_full_cnt per TX call */
+	SMC_METRIC_RX_BUF_FULL,		/* rmb_rx.buf_full_cnt per RX call */
+	SMC_MAX_METRIC,
+};
+
+static const char *metric_names[SMC_MAX_METRIC] = {
+	"fallback_rate", "hshake_err_rate", "tx_buf_full_ratio", "rx_buf_full_ratio"
+};
+
+struct smc_alert_rule {
+	char	*text;		/* rule as specified by the user */
+	int	metric;
+	int	above;		/* fire if value > limit, else if value < limit */
+	double	limit;
+};
+
+static struct smc_alert_rule alert_rules[SMC_MAX_ALERT_RULES];
+static int alert_cnt = 0;
+static int watch_interval = SMC_WATCH_INTERVAL_DFT;
+static int watch_exit = 0;
 
 static char* j_output[65] = {"SMC_INT_TX_BUF_8K", "SMC_INT_TX_BUF_16K", "SMC_INT_TX_BUF_32K", "SMC_INT_TX_BUF_64K", "SMC_INT_TX_BUF_128K",
 			    "SMC_INT_TX_BUF_256K", "SMC_INT_TX_BUF_512K", "SMC_INT_TX_BUF_1024K", "SMC_INT_TX_BUF_G_1024K",
@@ -130,12 +162,18 @@ static void usage(void)
 {
 	fprintf(stderr,
 #if defined(SMCD)
-		"Usage: smcd stats [show | reset]\n"
+		"Usage: smcd stats [show | reset | json]\n"
+		"       smcd stats watch [interval <sec>] [alert <rule>]... [exit]\n"
 #elif defined(SMCR)
-		"Usage: smcr stats [show | reset]\n"
+		"Usage: smcr stats [show | reset | json]\n"
+		"       smcr stats watch [interval <sec>] [alert <rule>]... [exit]\n"
 #else
-		"Usage: smc stats [show | reset]\n"
+		"Usage: smc stats [show | reset | json]\n"
+		"       smc stats watch [interval <sec>] [alert <rule>]... [exit]\n"
 #endif
+		"where  rule := METRIC{<|>}VALUE[%%]\n"
+		"       METRIC := {fallback_rate | hshake_err_rate |\n"
+		"                  tx_buf_full_ratio | rx_buf_full_ratio}\n"
 	);
 	exit(-1);
 }
@@ -480,6 +518,8 @@ static int show_tech_pload_info(struct nlattr **attr, int type, int direction)
 		tmp_memsize = &smc_stat.smc[tech_type].rx_rmbsize;
 	else
 		return NL_STOP;
+	if (!attr[direction])
+		return rc;
 
 	if (nla_parse_nested(tech_pload_attrs, SMC_NLA_STATS_PLOAD_MAX,
 			     attr[direction],
@@ -544,6 +584,8 @@ static int show_tech_rmb_info(struct nlattr **attr, int type, int direction)
 		tmp_rmb_stats = &smc_stat.smc[tech_type].rmb_tx;
 	else
 		tmp_rmb_stats = &smc_stat.smc[tech_type].rmb_rx;
+	if (!attr[direction])
+		return rc;
 
 	if (nla_parse_nested(tech_rmb_attrs, SMC_NLA_STATS_RMB_MAX,
 			     attr[direction],
@@ -764,7 +806,7 @@ static int handle_gen_fback_stats_reply(struct nl_msg *msg, void *arg)
 		trgt64 = nla_get_u64(stats_fback_attrs[SMC_NLA_FBACK_STATS_SRV_CNT]);
 		smc_rsn.srv_fback_cnt = trgt64;
 	}
-	if (stats_fback_attrs[SMC_NLA_FBACK_STATS_SRV_CNT]) {
+	if (stats_fback_attrs[SMC_NLA_FBACK_STATS_CLNT_CNT]) {
 		trgt64 = nla_get_u64(stats_fback_attrs[SMC_NLA_FBACK_STATS_CLNT_CNT]);
 		smc_rsn.clnt_fback_cnt = trgt64;
 	}
@@ -790,10 +832,51 @@ static int handle_gen_fback_stats_reply(struct nl_msg *msg, void *arg)
 	return rc;
 }
 
-static void handle_cmd_params(int argc, char **argv)
+static void parse_alert_rule(char *rule)
 {
+	struct smc_alert_rule *r;
+	char *op, *end;
+	int i, len;
 
-	memset(&smc_rsn, 0, sizeof(smc_rsn));
+	if (alert_cnt >= SMC_MAX_ALERT_RULES) {
+		fprintf(stderr, "Error: Too many alert rules, maximum is %d\n",
+			SMC_MAX_ALERT_RULES);
+		exit(-1);
+	}
+	r = &alert_rules[alert_cnt];
+	op = strpbrk(rule, "<>");
+	if (!op)
+		goto errout;
+	len = op - rule;
+	r->metric = -1;
+	for (i = 0; i < SMC_MAX_METRIC; i++) {
+		if (strlen(metric_names[i]) == len &&
+		    strncmp(rule, metric_names[i], len) == 0) {
+			r->metric = i;
+			break;
+		}
+	}
+	if (r->metric < 0)
+		goto errout;
+	r->above = (*op == '>');
+	errno = 0;
+	r->limit = strtod(op + 1, &end);
+	if (errno || end == op + 1)
+		goto errout;
+	if (*end == '%')
+		end++;
+	if (*end != '\0' || r->limit < 0)
+		goto errout;
+	r->text = rule;
+	alert_cnt++;
+	return;
+errout:
+	fprintf(stderr, "Error: Invalid alert rule \"%s\"\n", rule);
+	usage();
+}
+
+static void handle_cmd_params(int argc, char **argv)
+{
 	if (argc == 0) {
 		show_cmd = 1; /* no object given, so use the default "show" */
 		return;
@@ -811,6 +894,9 @@ static void handle_cmd_params(int argc, char **argv)
 		} else if (contains(argv[0], "json") == 0) {
 			json_cmd = 1;
 			break;
+		} else if (contains(argv[0], "watch") == 0) {
+			watch_cmd = 1;
+			break;
 		}else {
 			usage();
 		}
@@ -818,11 +904,49 @@ static void handle_cmd_params(int argc, char **argv)
 			break;
 		NEXT_ARG();
 	}
+	if (watch_cmd) {
+		while (NEXT_ARG_OK()) {
+			NEXT_ARG();
+			if (contains(argv[0], "interval") == 0) {
+				if (!NEXT_ARG_OK())
+					usage();
+				NEXT_ARG();
+				watch_interval = atoi(argv[0]);
+				if (watch_interval <= 0) {
+					fprintf(stderr, "Error: Invalid interval \"%s\"\n", argv[0]);
+					usage();
+				}
+			} else if (contains(argv[0], "alert") == 0 ||
+				   strcmp(argv[0], "--alert") == 0) {
+				if (!NEXT_ARG_OK())
+					usage();
+				NEXT_ARG();
+				parse_alert_rule(argv[0]);
+			} else if (contains(argv[0], "exit") == 0) {
+				watch_exit = 1;
+			} else {
+				usage();
+			}
+		}
+	}
 	/* Too many parameters or wrong sequence of parameters */
 	if (NEXT_ARG_OK())
 		usage();
 }
 
+/* The cache only holds the baseline for relative output, so a cache file
+ * that cannot be parsed is ignored instead of failing the command. It is
+ * rewritten on the next reset.
+ */
+static void discard_cache_file(const char *reason)
+{
+	fprintf(stderr, "Warning: Ignoring cache file %s: %s\n",
+		cache_file_path, reason);
+	memset(&smc_stat_c, 0, sizeof(smc_stat_c));
+	memset(&smc_rsn_c, 0, sizeof(smc_rsn_c));
+	cache_file_exists = 0;
+}
+
 static void read_cache_file(FILE *fp)
 {
 	int count = 0, idx = 0, rc, size_fback = 0;
@@ -840,27 +964,31 @@ static void read_cache_file(FILE *fp)
 	fbck_cnt = (__u64 *)&smc_rsn_c.srv_fback_cnt;
 
 	while (fgets(buf, sizeof(buf), fp) != NULL) {
+		if (!strchr(buf, '\n') && !feof(fp)) {
+			discard_cache_file("line too long");
+			return;
+		}
 		if (count < size) {
 			rc = sscanf(buf, "%d%llu", &idx, &val);
 			if (rc < 2) {
-				perror("Error: parsing cache file(stats)");
-				exit(-1);
+				discard_cache_file("parse error (stats)");
+				return;
 			}
 			if (idx != count) {
-				perror("Error: unexpected value in cache file");
-				exit(-1);
+				discard_cache_file("unexpected index (stats)");
+				return;
 			}
 			*trgt = val;
 			trgt++;
 		} else if (count < size_fback) {
 			rc = sscanf(buf, "%d%d%d", &idx, &val_err, &val_cnt);
 			if (rc < 3) {
-				perror("Error: parsing cache file (fback stats)");
-				exit(-1);
+				discard_cache_file("parse error (fback stats)");
+				return;
 			}
-			if (idx > SMC_MAX_FBACK_RSN_CNT * 2) {
-				perror("Error: unexpected value in cache file (fback stats)");
-				exit(-1);
+			if (idx != count - size) {
+				discard_cache_file("unexpected index (fback stats)");
+				return;
 			}
 			*trgt_fbck = val_err;
 			trgt_fbck++;
@@ -869,18 +997,20 @@ static void read_cache_file(FILE *fp)
 		} else if (count < size_fback + 2) {
 			rc = sscanf(buf, "%llu", &val);
 			if (rc < 1) {
-				perror("Error: parsing cache file(fback counters)");
-				exit(-1);
+				discard_cache_file("parse error (fback counters)");
+				return;
 			}
 			*fbck_cnt = val;
 			fbck_cnt++;
 		} else {
-			perror("Error: cache file corrupt");
-			exit(-1);
+			discard_cache_file("too many lines");
+			return;
 		}
 		cache_file_exists = 1;
 		count++;
 	}
+	if (count && count < size_fback + 2)
+		discard_cache_file("truncated");
 }
 
 static int get_fback_err_cache_count(struct smc_stats_fback *fback, int trgt)
@@ -933,17 +1063,13 @@ static int is_data_consistent ()
 	return 1;
 }
 
-static void merge_cache ()
+/* Subtract the cached values (smc_stat_c, smc_rsn_c) from the kernel values */
+static void subtract_cache()
 {
 	int size, i, size_fback, val_err, cache_cnt;
 	struct smc_stats_fback *kern_fbck;
 	__u64 *kernel, *cache;
 
-	if (!is_data_consistent()) {
-		unlink(cache_file_path);
-		return;
-	}
-
 	size = sizeof(smc_stat) / sizeof(__u64);
 	kernel = (__u64 *)&smc_stat;
 	cache = (__u64 *)&smc_stat_c;
@@ -966,6 +1092,15 @@ static void merge_cache ()
 	smc_rsn.clnt_fback_cnt -= smc_rsn_c.clnt_fback_cnt;
 }
 
+static void merge_cache ()
+{
+	if (!is_data_consistent()) {
+		unlink(cache_file_path);
+		return;
+	}
+	subtract_cache();
+}
+
 static void open_cache_file()
 {
 	int fd;
@@ -1025,6 +1160,162 @@ static void fill_cache_file()
 	fprintf(cache_fp, "%16llu\n", smc_rsn_org.clnt_fback_cnt);
 }
 
+static int stats_dump()
+{
+	struct gen_nl_req reqs[] = {
+		{ .cmd = SMC_NETLINK_GET_FBACK_STATS, .flags = NLM_F_DUMP,
+		  .cb_handler = handle_gen_fback_stats_reply },
+		{ .cmd = SMC_NETLINK_GET_STATS, .flags = NLM_F_DUMP,
+		  .cb_handler = handle_gen_stats_reply },
+	};
+	int i;
+
+	/* fallback reasons are appended, so start from an empty table */
+	memset(&smc_rsn, 0, sizeof(smc_rsn));
+	if (gen_nl_batch_run(reqs, 2)) {
+		for (i = 0; i < 2; i++) {
+			if (reqs[i].err) {
+				gen_nl_perror(reqs[i].err);
+				break;
+			}
+		}
+		return -1;
+	}
+	memcpy(&smc_stat_org, &smc_stat, sizeof(smc_stat_org));
+	memcpy(&smc_rsn_org, &smc_rsn, sizeof(smc_rsn_org));
+	return 0;
+}
+
+/* Compute the watch metrics from the interval deltas in smc_stat and smc_rsn */
+static void get_metrics(double *val, int *valid)
+{
+	__u64 total_conn, fback_count, hshake_err_cnt;
+	struct smc_stats_tech *tech;
+
+	tech = &smc_stat.smc[is_smcd ? SMC_TYPE_D : SMC_TYPE_R];
+	hshake_err_cnt = smc_stat.clnt_hshake_err_cnt + smc_stat.srv_hshake_err_cnt;
+	fback_count = smc_rsn.clnt_fback_cnt + smc_rsn.srv_fback_cnt;
+	total_conn = tech->clnt_v1_succ_cnt + tech->clnt_v2_succ_cnt +
+		     tech->srv_v1_succ_cnt + tech->srv_v2_succ_cnt +
+		     hshake_err_cnt + fback_count;
+
+	memset(valid, 0, SMC_MAX_METRIC * sizeof(int));
+	if (total_conn) {
+		val[SMC_METRIC_FBACK_RATE] = fback_count / (double)total_conn * 100;
+		val[SMC_METRIC_HSHAKE_ERR_RATE] = hshake_err_cnt / (double)total_conn * 100;
+		valid[SMC_METRIC_FBACK_RATE] = 1;
+		valid[SMC_METRIC_HSHAKE_ERR_RATE] = 1;
+	}
+	if (tech->tx_cnt) {
+		val[SMC_METRIC_TX_BUF_FULL] = tech->rmb_tx.buf_full_cnt / (double)tech->tx_cnt * 100;
+		valid[SMC_METRIC_TX_BUF_FULL] = 1;
+	}
+	if (tech->rx_cnt) {
+		val[SMC_METRIC_RX_BUF_FULL] = tech->rmb_rx.buf_full_cnt / (double)tech->rx_cnt * 100;
+		valid[SMC_METRIC_RX_BUF_FULL] = 1;
+	}
+}
+
+/* Append the top fallback reasons of the interval to buf */
+static void get_top_fbacks(struct smc_stats_fback *fback, const char *caption,
+			   char *buf, size_t len)
+{
+	int i, count = 0;
+	size_t pos;
+
+	bubble_sort(fback);
+	for (i = 0; i < SMC_MAX_FBACK_RSN_CNT && count < 3; i++) {
+		if (fback[i].fback_code == 0 || fback[i].count <= 0)
+			continue;
+		pos = strlen(buf);
+		snprintf(buf + pos, len - pos, "%s%s%s:%d", pos ? ", " : "",
+			 count ? "" : caption, get_fbackstr(fback[i].fback_code),
+			 fback[i].count);
+		count++;
+	}
+}
+
+static int check_alerts(const char *tstamp, double *val, int *valid)
+{
+	char reasons[512];
+	int i, fired = 0;
+	double v;
+
+	reasons[0] = '\0';
+	for (i = 0; i < alert_cnt; i++) {
+		if (!valid[alert_rules[i].metric])
+			continue;
+		v = val[alert_rules[i].metric];
+		if (alert_rules[i].above ? v <= alert_rules[i].limit :
+					   v >= alert_rules[i].limit)
+			continue;
+		if (!fired) {
+			get_top_fbacks(smc_rsn.srv, "server ", reasons, sizeof(reasons));
+			get_top_fbacks(smc_rsn.clnt, "client ", reasons, sizeof(reasons));
+		}
+		fired = 1;
+		printf("%s  ALERT %s: %s is %.2f%%, top fallback reasons: %s\n",
+		       tstamp, alert_rules[i].text, metric_names[alert_rules[i].metric],
+		       v, reasons[0] ? reasons : "none");
+		syslog(LOG_WARNING, "alert %s: %s is %.2f%%, top fallback reasons: %s",
+		       alert_rules[i].text, metric_names[alert_rules[i].metric],
+		       v, reasons[0] ? reasons : "none");
+	}
+	fflush(stdout);
+
+	return fired;
+}
+
+static void print_watch_line(const char *tstamp, double *val, int *valid)
+{
+	int i;
+
+	printf("%s ", tstamp);
+	for (i = 0; i < SMC_MAX_METRIC; i++) {
+		if (valid[i])
+			printf(" %s %.2f%%", metric_names[i], val[i]);
+		else
+			printf(" %s -", metric_names[i]);
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+/* Evaluate the alert rules against the counter deltas of every interval */
+static int watch_stats()
+{
+	double val[SMC_MAX_METRIC];
+	int valid[SMC_MAX_METRIC];
+	char tstamp[32];
+	time_t now;
+
+	if (alert_cnt)
+		openlog(myname, LOG_PID, LOG_USER);
+	if (stats_dump())
+		return EXIT_FAILURE;
+	while (1) {
+		/* the previous sample is the baseline of the next interval */
+		memcpy(&smc_stat_c, &smc_stat_org, sizeof(smc_stat_c));
+		memcpy(&smc_rsn_c, &smc_rsn_org, sizeof(smc_rsn_c));
+		sleep(watch_interval);
+		if (stats_dump())
+			return EXIT_FAILURE;
+		now = time(NULL);
+		strftime(tstamp, sizeof(tstamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+		if (!is_data_consistent()) {
+			printf("%s  counters were reset\n", tstamp);
+			continue;
+		}
+		subtract_cache();
+		get_metrics(val, valid);
+		print_watch_line(tstamp, val, valid);
+		if (check_alerts(tstamp, val, valid) && watch_exit)
+			return EXIT_FAILURE;
+	}
+
+	return 0;
+}
+
 int invoke_stats(int argc, char **argv, int option_details)
 {
 	if (option_details == SMC_DETAIL_LEVEL_V || option_details == SMC_DETAIL_LEVEL_VV) {
@@ -1037,14 +1328,12 @@ int invoke_stats(int argc, char **argv, int option_details)
 	}
 
 	handle_cmd_params(argc, argv);
+	if (watch_cmd)
+		return watch_stats();
 	if (!is_abs)
 		init_cache_file();
-	if (gen_nl_handle_dump(SMC_NETLINK_GET_FBACK_STATS, handle_gen_fback_stats_reply, NULL))
-		goto errout;
-	if (gen_nl_handle_dump(SMC_NETLINK_GET_STATS, handle_gen_stats_reply, NULL))
+	if (stats_dump())
 		goto errout;
-	memcpy(&smc_stat_org, &smc_stat, sizeof(smc_stat_org));
-	memcpy(&smc_rsn_org, &smc_rsn, sizeof(smc_rsn_org));
 
 	if (!is_abs && cache_file_exists)
 		merge_cache();
@@ -1064,8 +1353,11 @@ int invoke_stats(int argc, char **argv, int option_details)
 		fill_cache_file();
 	}
 errout:
-	if (cache_fp)
+	if (cache_fp) {
 		fclose(cache_fp);
+		cache_fp = NULL;
+	}
 	free(cache_file_path);
+	cache_file_path = NULL;
 	return 0;
 }
@@ -0,0 +1,733 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Synthetic SMC_NL_RECORD dumps for tests, benchmarks and fuzzing
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * The dumps describe a made-up system: SMC-R devices mlx5_<n> with an active
+ * port 1, and an active but unused port 2 on every other device, SMC-D
+ * devices with CHID 0x300 + <n>, link groups with their links spread over the
+ * devices, and sockets in all states and modes attached to them. All values
+ * follow from the indexes and the seed, so a configuration always gives the
+ * same file.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+
+#include "../smctools_common.h"
+#include "../libnetlink.h"
+#include "../stats.h"
+#include "nl_gen.h"
+
+#define GEN_FAMILY_ID		0x1e	/* any, the tools do not check it */
+#define GEN_MSG_MAX		4096
+#define GEN_NEST_MAX		4
+#define GEN_CURSOR_SIZE		65536	/* sndbuf and RMBE size */
+#define GEN_TIME_BASE		1600000000
+
+struct gen_msg {
+	union {
+		struct nlmsghdr	nlh;
+		char		buf[GEN_MSG_MAX];
+	};
+	int	len;
+	int	nest[GEN_NEST_MAX];
+	int	depth;
+};
+
+struct gen_ctx {
+	FILE			*fp;
+	const struct nl_gen_cfg	*cfg;
+	unsigned int		rnd;
+	unsigned int		round;	/* over all samples */
+	long			cnt;
+	int			err;
+};
+
+/* sock_diag extension sets requested by smcss, smc topology and balance */
+static const unsigned char sock_exts[] = {
+	0,
+	1 << (SMC_DIAG_CONNINFO - 1),
+	1 << (SMC_DIAG_LGRINFO - 1),
+	1 << (SMC_DIAG_DMBINFO - 1),
+	(1 << (SMC_DIAG_CONNINFO - 1)) | (1 << (SMC_DIAG_LGRINFO - 1)),
+	(1 << (SMC_DIAG_CONNINFO - 1)) | (1 << (SMC_DIAG_DMBINFO - 1)),
+	(1 << (SMC_DIAG_LGRINFO - 1)) | (1 << (SMC_DIAG_DMBINFO - 1)),
+	(1 << (SMC_DIAG_CONNINFO - 1)) | (1 << (SMC_DIAG_LGRINFO - 1)) |
+	(1 << (SMC_DIAG_DMBINFO - 1)),
+};
+
+static const unsigned int fback_codes[] = {
+	SMC_CLC_DECL_PEERNOSMC, SMC_CLC_DECL_NOSMCDEV, SMC_CLC_DECL_IPSEC,
+	SMC_CLC_DECL_MODEUNSUPP, SMC_CLC_DECL_DIFFPREFIX, SMC_CLC_DECL_MEM,
+	SMC_CLC_DECL_TIMEOUT_CL, SMC_CLC_DECL_NOSMCRDEV, SMC_CLC_DECL_PEERDECL,
+	SMC_CLC_DECL_VERSMISMAT,
+};
+
+void nl_gen_defaults(struct nl_gen_cfg *cfg)
+{
+	memset(cfg, 0, sizeof(*cfg));
+	cfg->what = NL_GEN_ALL;
+	cfg->devs = 2;
+	cfg->lgrs = 4;
+	cfg->links = 2;
+	cfg->socks = 20;
+	cfg->fbacks = 6;
+	cfg->samples = 1;
+	cfg->rounds = 1;
+	cfg->seed = 1;
+	cfg->sock_ext = -1;
+}
+
+static unsigned int gen_rand(struct gen_ctx *ctx)
+{
+	/* xorshift32 */
+	ctx->rnd ^= ctx->rnd << 13;
+	ctx->rnd ^= ctx->rnd >> 17;
+	ctx->rnd ^= ctx->rnd << 5;
+	return ctx->rnd;
+}
+
+static void msg_start(struct gen_msg *m, int type)
+{
+	memset(m, 0, sizeof(*m));
+	m->nlh.nlmsg_type = type;
+	m->nlh.nlmsg_flags = NLM_F_MULTI;
+	m->len = NLMSG_HDRLEN;
+}
+
+static void msg_start_genl(struct gen_msg *m, int cmd)
+{
+	struct genlmsghdr *g;
+
+	msg_start(m, GEN_FAMILY_ID);
+	g = (struct genlmsghdr *)(m->buf + m->len);
+	g->cmd = cmd;
+	g->version = SMC_GENL_FAMILY_VERSION;
+	m->len += GENL_HDRLEN;
+}
+
+/* attributes of both families share the struct nlattr layout */
+static void put(struct gen_msg *m, int type, const void *data, int len)
+{
+	struct nlattr *nla = (struct nlattr *)(m->buf + m->len);
+	int total = NLA_HDRLEN + len;
+
+	if (m->len + NLA_ALIGN(total) > GEN_MSG_MAX)
+		abort();	/* a bug in the generator */
+	nla->nla_type = type;
+	nla->nla_len = total;
+	memcpy((char *)nla + NLA_HDRLEN, data, len);
+	memset((char *)nla + total, 0, NLA_ALIGN(total) - total);
+	m->len += NLA_ALIGN(total);
+}
+
+static void put_u8(struct gen_msg *m, int type, __u8 val)
+{
+	put(m, type, &val, sizeof(val));
+}
+
+static void put_u16(struct gen_msg *m, int type, __u16 val)
+{
+	put(m, type, &val, sizeof(val));
+}
+
+static void put_u32(struct gen_msg *m, int type, __u32 val)
+{
+	put(m, type, &val, sizeof(val));
+}
+
+static void put_u64(struct gen_msg *m, int type, __u64 val)
+{
+	put(m, type, &val, sizeof(val));
+}
+
+static void put_str(struct gen_msg *m, int type, const char *str)
+{
+	put(m, type, str, strlen(str) + 1);
+}
+
+static void nest_start(struct gen_msg *m, int type)
+{
+	m->nest[m->depth++] = m->len;
+	put(m, type, NULL, 0);
+}
+
+static void nest_end(struct gen_msg *m)
+{
+	int off = m->nest[--m->depth];
+
+	((struct nlattr *)(m->buf + off))->nla_len = m->len - off;
+}
+
+static void rec_write(struct gen_ctx *ctx, int kind, int cmd, struct gen_msg *m)
+{
+	struct nl_rec_hdr hdr = { .kind = kind, .cmd = cmd, .len = m->len };
+
+	m->nlh.nlmsg_len = m->len;
+	if (fwrite(&hdr, sizeof(hdr), 1, ctx->fp) != 1 ||
+	    fwrite(m->buf, m->len, 1, ctx->fp) != 1)
+		ctx->err = 1;
+	if (kind != NL_REC_MARK && m->nlh.nlmsg_type != NLMSG_DONE)
+		ctx->cnt++;
+}
+
+static void rec_done(struct gen_ctx *ctx, int kind, int cmd)
+{
+	struct gen_msg m;
+	int err = 0;
+
+	msg_start(&m, NLMSG_DONE);
+	memcpy(m.buf + m.len, &err, sizeof(err));
+	m.len += sizeof(err);
+	rec_write(ctx, kind, cmd, &m);
+}
+
+static void rec_mark(struct gen_ctx *ctx, unsigned int n)
+{
+	struct nl_rec_mark *mark;
+	struct gen_msg m;
+
+	msg_start(&m, NLMSG_NOOP);
+	m.nlh.nlmsg_flags = 0;
+	mark = (struct nl_rec_mark *)m.buf;
+	mark->sec = GEN_TIME_BASE + n;
+	m.len = sizeof(*mark);
+	rec_write(ctx, NL_REC_MARK, n, &m);
+}
+
+/* Names and addresses shared between the dumps */
+
+static void dev_name(char *buf, size_t len, unsigned int dev)
+{
+	snprintf(buf, len, "mlx5_%u", dev);
+}
+
+static unsigned int link_dev(const struct nl_gen_cfg *cfg, unsigned int lgr,
+			     unsigned int link)
+{
+	return (lgr + link) % cfg->devs;
+}
+
+static void link_gid(char *buf, size_t len, unsigned int dev)
+{
+	snprintf(buf, len, "fe80:0000:0000:0000:0000:0000:%04x:0001",
+		 (dev + 1) & 0xffff);
+}
+
+static void link_peer_gid(char *buf, size_t len, unsigned int lgr, unsigned int link)
+{
+	snprintf(buf, len, "fe80:0000:0000:0000:0000:%04x:%04x:%04x",
+		 (lgr >> 16) & 0xffff, lgr & 0xffff, (link + 1) & 0xffff);
+}
+
+static unsigned int link_conns(unsigned int lgr, unsigned int link)
+{
+	/* every fourth link group puts most connections on its first link */
+	return (lgr % 4 == 0 && link == 0) ? 6 : 2;
+}
+
+static __u32 lgr_smcr_id(unsigned int lgr)
+{
+	return (lgr + 1) << 8;
+}
+
+static __u32 lgr_smcd_id(unsigned int lgr)
+{
+	return 0x1000 + lgr;
+}
+
+static void gen_sys_info(struct gen_ctx *ctx)
+{
+	struct gen_msg m;
+
+	msg_start_genl(&m, SMC_NETLINK_GET_SYS_INFO);
+	nest_start(&m, SMC_GEN_SYS_INFO);
+	put_u8(&m, SMC_NLA_SYS_VER, 2);
+	put_u8(&m, SMC_NLA_SYS_REL, 1);
+	put_u8(&m, SMC_NLA_SYS_IS_ISM_V2, 1);
+	put_str(&m, SMC_NLA_SYS_LOCAL_HOST, "smchost01");
+	put_str(&m, SMC_NLA_SYS_SEID, "IBM-SYSZ-ISMSEID00000000FFFF0001");
+	put_u8(&m, SMC_NLA_SYS_IS_SMCR_V2, 1);
+	nest_end(&m);
+	rec_write(ctx, NL_REC_GENL, SMC_NETLINK_GET_SYS_INFO, &m);
+	rec_done(ctx, NL_REC_GENL, SMC_NETLINK_GET_SYS_INFO);
+}
+
+static void gen_devs_smcr(struct gen_ctx *ctx)
+{
+	const struct nl_gen_cfg *cfg = ctx->cfg;
+	unsigned int i, lgr, link, *lnk_cnt;
+	char buf[32];
+	struct gen_msg m;
+
+	lnk_cnt = calloc(cfg->devs, sizeof(*lnk_cnt));
+	if (!lnk_cnt) {
+		ctx->err = 1;
+		return;
+	}
+	for (lgr = 0; lgr < cfg->lgrs; lgr++)
+		for (link = 0; link < cfg->links; link++)
+			lnk_cnt[link_dev(cfg, lgr, link)]++;
+	for (i = 0; i < cfg->devs; i++) {
+		msg_start_genl(&m, SMC_NETLINK_GET_DEV_SMCR);
+		nest_start(&m, SMC_GEN_DEV_SMCR);
+		put_u32(&m, SMC_NLA_DEV_USE_CNT, 0);
+		put_u8(&m, SMC_NLA_DEV_IS_CRIT, i % 2 == 0);
+		put_u32(&m, SMC_NLA_DEV_PCI_FID, 0x100 + i);
+		put_u16(&m, SMC_NLA_DEV_PCI_CHID, 0x200 + i);
+		put_u16(&m, SMC_NLA_DEV_PCI_VENDOR, 0x15b3);
+		put_u16(&m, SMC_NLA_DEV_PCI_DEVICE, 0x1016);
+		snprintf(buf, sizeof(buf), "%04x:00:00.0", i);
+		put_str(&m, SMC_NLA_DEV_PCI_ID, buf);
+		dev_name(buf, sizeof(buf), i);
+		put_str(&m, SMC_NLA_DEV_IB_NAME, buf);
+
+		nest_start(&m, SMC_NLA_DEV_PORT);
+		put_u8(&m, SMC_NLA_DEV_PORT_PNET_USR, i == 0);
+		put_str(&m, SMC_NLA_DEV_PORT_PNETID, "NET1");
+		put_u32(&m, SMC_NLA_DEV_PORT_NETDEV, 1);
+		put_u8(&m, SMC_NLA_DEV_PORT_STATE, 1);
+		put_u8(&m, SMC_NLA_DEV_PORT_VALID, 1);
+		put_u32(&m, SMC_NLA_DEV_PORT_LNK_CNT, lnk_cnt[i]);
+		nest_end(&m);
+		nest_start(&m, SMC_NLA_DEV_PORT2);
+		put_u8(&m, SMC_NLA_DEV_PORT_PNET_USR, 0);
+		put_str(&m, SMC_NLA_DEV_PORT_PNETID, "NET1");
+		put_u32(&m, SMC_NLA_DEV_PORT_NETDEV, 0);
+		put_u8(&m, SMC_NLA_DEV_PORT_STATE, i % 2 == 0);
+		put_u8(&m, SMC_NLA_DEV_PORT_VALID, i % 2 == 0);
+		put_u32(&m, SMC_NLA_DEV_PORT_LNK_CNT, 0);
+		nest_end(&m);
+		nest_end(&m);
+		rec_write(ctx, NL_REC_GENL, SMC_NETLINK_GET_DEV_SMCR, &m);
+	}
+	free(lnk_cnt);
+	rec_done(ctx, NL_REC_GENL, SMC_NETLINK_GET_DEV_SMCR);
+}
+
+static void gen_devs_smcd(struct gen_ctx *ctx)
+{
+	const struct nl_gen_cfg *cfg = ctx->cfg;
+	struct gen_msg m;
+	unsigned int i;
+	char buf[32];
+
+	for (i = 0; i < cfg->devs; i++) {
+		msg_start_genl(&m, SMC_NETLINK_GET_DEV_SMCD);
+		nest_start(&m, SMC_GEN_DEV_SMCD);
+		put_u32(&m, SMC_NLA_DEV_USE_CNT, cfg->lgrs / cfg->devs +
+					      (i < cfg->lgrs % cfg->devs));
+		put_u8(&m, SMC_NLA_DEV_IS_CRIT, 0);
+		put_u32(&m, SMC_NLA_DEV_PCI_FID, 0x400 + i);
+		put_u16(&m, SMC_NLA_DEV_PCI_CHID, 0x300 + i);
+		put_u16(&m, SMC_NLA_DEV_PCI_VENDOR, 0x1014);
+		put_u16(&m, SMC_NLA_DEV_PCI_DEVICE, 0x04ed);
+		snprintf(buf, sizeof(buf), "%04x:00:00.0", 0x100 + i);
+		put_str(&m, SMC_NLA_DEV_PCI_ID, buf);
+		nest_start(&m, SMC_NLA_DEV_PORT);
+		put_u8(&m, SMC_NLA_DEV_PORT_PNET_USR, 0);
+		put_str(&m, SMC_NLA_DEV_PORT_PNETID, "NET1");
+		nest_end(&m);
+		nest_end(&m);
+		rec_write(ctx, NL_REC_GENL, SMC_NETLINK_GET_DEV_SMCD, &m);
+	}
+	rec_done(ctx, NL_REC_GENL, SMC_NETLINK_GET_DEV_SMCD);
+}
+
+static void put_lgr_v2(struct gen_msg *m, int type, unsigned int lgr)
+{
+	char buf[32];
+
+	nest_start(m, type);
+	put_u8(m, SMC_NLA_LGR_V2_VER, 2);
+	put_u8(m, SMC_NLA_LGR_V2_REL, 1);
+	put_u8(m, SMC_NLA_LGR_V2_OS, 2);
+	put_str(m, SMC_NLA_LGR_V2_NEG_EID, "SMC-EID-TEST");
+	snprintf(buf, sizeof(buf), "peer%u", lgr);
+	put_str(m, SMC_NLA_LGR_V2_PEER_HOST, buf);
+	nest_end(m);
+}
+
+static void msg_lgr_smcr(struct gen_msg *m, int cmd, unsigned int lgr,
+			 const struct nl_gen_cfg *cfg)
+{
+	unsigned int link, conns = 0;
+
+	for (link = 0; link < cfg->links; link++)
+		conns += link_conns(lgr, link);
+	msg_start_genl(m, cmd);
+	nest_start(m, SMC_GEN_LGR_SMCR);
+	put_u32(m, SMC_NLA_LGR_R_ID, lgr_smcr_id(lgr));
+	put_u8(m, SMC_NLA_LGR_R_ROLE, lgr % 2);
+	put_u8(m, SMC_NLA_LGR_R_TYPE, cfg->links > 1 ? 2 : 1);
+	put_str(m, SMC_NLA_LGR_R_PNETID, "NET1");
+	put_u8(m, SMC_NLA_LGR_R_VLAN_ID, 0);
+	put_u32(m, SMC_NLA_LGR_R_CONNS_NUM, conns);
+	if (lgr % 2) {
+		put_lgr_v2(m, SMC_NLA_LGR_R_V2_COMMON, lgr);
+		nest_start(m, SMC_NLA_LGR_R_V2);
+		put_u8(m, SMC_NLA_LGR_R_V2_DIRECT, 0);
+		nest_end(m);
+	}
+	put_u64(m, SMC_NLA_LGR_R_NET_COOKIE, lgr);
+	put_u64(m, SMC_NLA_LGR_R_SNDBUF_ALLOC, (__u64)conns * GEN_CURSOR_SIZE);
+	put_u64(m, SMC_NLA_LGR_R_RMB_ALLOC, (__u64)conns * GEN_CURSOR_SIZE);
+	nest_end(m);
+}
+
+static void msg_link(struct gen_msg *m, unsigned int lgr, unsigned int link,
+		     const struct nl_gen_cfg *cfg)
+{
+	unsigned int dev = link_dev(cfg, lgr, link);
+	char buf[48];
+
+	msg_start_genl(m, SMC_NETLINK_GET_LINK_SMCR);
+	nest_start(m, SMC_GEN_LINK_SMCR);
+	put_u8(m, SMC_NLA_LINK_ID, link + 1);
+	dev_name(buf, sizeof(buf), dev);
+	put_str(m, SMC_NLA_LINK_IB_DEV, buf);
+	put_u8(m, SMC_NLA_LINK_IB_PORT, 1);
+	link_gid(buf, sizeof(buf), dev);
+	put_str(m, SMC_NLA_LINK_GID, buf);
+	link_peer_gid(buf, sizeof(buf), lgr, link);
+	put_str(m, SMC_NLA_LINK_PEER_GID, buf);
+	put_u32(m, SMC_NLA_LINK_CONN_CNT, link_conns(lgr, link));
+	put_u32(m, SMC_NLA_LINK_NET_DEV, 1);
+	put_u32(m, SMC_NLA_LINK_UID, htonl(lgr_smcr_id(lgr) | (link + 1)));
+	put_u32(m, SMC_NLA_LINK_PEER_UID, htonl(lgr_smcr_id(lgr) | (link + 0x81)));
+	put_u32(m, SMC_NLA_LINK_STATE, 3);
+	nest_end(m);
+}
+
+static void gen_lgrs_smcr(struct gen_ctx *ctx)
+{
+	struct gen_msg m;
+	unsigned int i;
+
+	for (i = 0; i < ctx->cfg->lgrs; i++) {
+		msg_lgr_smcr(&m, SMC_NETLINK_GET_LGR_SMCR, i, ctx->cfg);
+		rec_write(ctx, NL_REC_GENL, SMC_NETLINK_GET_LGR_SMCR, &m);
+	}
+	rec_done(ctx, NL_REC_GENL, SMC_NETLINK_GET_LGR_SMCR);
+}
+
+/* a link dump sends each link group followed by its links */
+static void gen_links(struct gen_ctx *ctx)
+{
+	const struct nl_gen_cfg *cfg = ctx->cfg;
+	unsigned int i, j;
+	struct gen_msg m;
+
+	for (i = 0; i < cfg->lgrs; i++) {
+		msg_lgr_smcr(&m, SMC_NETLINK_GET_LINK_SMCR, i, cfg);
+		rec_write(ctx, NL_REC_GENL, SMC_NETLINK_GET_LINK_SMCR, &m);
+		for (j = 0; j < cfg->links; j++) {
+			msg_link(&m, i, j, cfg);
+			rec_write(ctx, NL_REC_GENL, SMC_NETLINK_GET_LINK_SMCR, &m);
+		}
+	}
+	rec_done(ctx, NL_REC_GENL, SMC_NETLINK_GET_LINK_SMCR);
+}
+
+static void gen_lgrs_smcd(struct gen_ctx *ctx)
+{
+	const struct nl_gen_cfg *cfg = ctx->cfg;
+	struct gen_msg m;
+	unsigned int i;
+
+	for (i = 0; i < cfg->lgrs; i++) {
+		msg_start_genl(&m, SMC_NETLINK_GET_LGR_SMCD);
+		nest_start(&m, SMC_GEN_LGR_SMCD);
+		put_u32(&m, SMC_NLA_LGR_D_ID, lgr_smcd_id(i));
+		put_u64(&m, SMC_NLA_LGR_D_GID, 0x1000000000ULL + i % cfg->devs);
+		put_u64(&m, SMC_NLA_LGR_D_PEER_GID, 0x2000000000ULL + i);
+		put_u8(&m, SMC_NLA_LGR_D_VLAN_ID, 0);
+		put_u32(&m, SMC_NLA_LGR_D_CONNS_NUM, 1 + i % 3);
+		put_str(&m, SMC_NLA_LGR_D_PNETID, "NET1");
+		put_u16(&m, SMC_NLA_LGR_D_CHID, 0x300 + i % cfg->devs);
+		if (i % 2)
+			put_lgr_v2(&m, SMC_NLA_LGR_D_V2_COMMON, i);
+		put_u64(&m, SMC_NLA_LGR_D_SNDBUF_ALLOC, (__u64)(1 + i % 3) * GEN_CURSOR_SIZE);
+		put_u64(&m, SMC_NLA_LGR_D_DMB_ALLOC, (__u64)(1 + i % 3) * GEN_CURSOR_SIZE);
+		nest_end(&m);
+		rec_write(ctx, NL_REC_GENL, SMC_NETLINK_GET_LGR_SMCD, &m);
+	}
+	rec_done(ctx, NL_REC_GENL, SMC_NETLINK_GET_LGR_SMCD);
+}
+
+/* counters grow with the round, so that samples differ */
+static __u64 gen_counter(struct gen_ctx *ctx, unsigned int max)
+{
+	return (__u64)(gen_rand(ctx) % max) * (ctx->round + 1);
+}
+
+static void put_sizes(struct gen_ctx *ctx, struct gen_msg *m, int type)
+{
+	int i;
+
+	nest_start(m, type);
+	for (i = SMC_NLA_STATS_PLOAD_8K; i <= SMC_NLA_STATS_PLOAD_G_1024K; i++)
+		put_u64(m, i, gen_counter(ctx, 1000));
+	nest_end(m);
+}
+
+static void put_rmb_stats(struct gen_ctx *ctx, struct gen_msg *m, int type)
+{
+	int i;
+
+	nest_start(m, type);
+	for (i = SMC_NLA_STATS_RMB_SIZE_SM_PEER_CNT; i <= SMC_NLA_STATS_RMB_DGRADE_CNT; i++)
+		put_u64(m, i, gen_counter(ctx, 100));
+	nest_end(m);
+}
+
+static void put_tech(struct gen_ctx *ctx, struct gen_msg *m, int type)
+{
+	int i;
+
+	nest_start(m, type);
+	put_sizes(ctx, m, SMC_NLA_STATS_T_TX_RMB_SIZE);
+	put_sizes(ctx, m, SMC_NLA_STATS_T_RX_RMB_SIZE);
+	put_sizes(ctx, m, SMC_NLA_STATS_T_TXPLOAD_SIZE);
+	put_sizes(ctx, m, SMC_NLA_STATS_T_RXPLOAD_SIZE);
+	put_rmb_stats(ctx, m, SMC_NLA_STATS_T_TX_RMB_STATS);
+	put_rmb_stats(ctx, m, SMC_NLA_STATS_T_RX_RMB_STATS);
+	for (i = SMC_NLA_STATS_T_CLNT_V1_SUCC; i <= SMC_NLA_STATS_T_TX_RMB_USAGE; i++)
+		put_u64(m, i, gen_counter(ctx, i >= SMC_NLA_STATS_T_RX_BYTES ?
+						   1000000 : 1000));
+	nest_end(m);
+}
+
+static void gen_stats(struct gen_ctx *ctx)
+{
+	struct gen_msg m;
+
+	msg_start_genl(&m, SMC_NETLINK_GET_STATS);
+	nest_start(&m, SMC_GEN_STATS);
+	put_tech(ctx, &m, SMC_NLA_STATS_SMCD_TECH);
+	put_tech(ctx, &m, SMC_NLA_STATS_SMCR_TECH);
+	put_u64(&m, SMC_NLA_STATS_CLNT_HS_ERR_CNT, gen_counter(ctx, 10));
+	put_u64(&m, SMC_NLA_STATS_SRV_HS_ERR_CNT, gen_counter(ctx, 10));
+	nest_end(&m);
+	rec_write(ctx, NL_REC_GENL, SMC_NETLINK_GET_STATS, &m);
+	rec_done(ctx, NL_REC_GENL, SMC_NETLINK_GET_STATS);
+}
+
+static void gen_fbacks(struct gen_ctx *ctx)
+{
+	const struct nl_gen_cfg *cfg = ctx->cfg;
+	__u64 srv_cnt = 0, clnt_cnt = 0;
+	unsigned int i, *cnt;
+	struct gen_msg m;
+
+	cnt = calloc(cfg->fbacks + 1, sizeof(*cnt));
+	if (!cnt) {
+		ctx->err = 1;
+		return;
+	}
+	for (i = 0; i < cfg->fbacks; i++) {
+		cnt[i] = 1 + gen_rand(ctx) % 100 * (ctx->round + 1);
+		if (i % 2)
+			srv_cnt += cnt[i];
+		else
+			clnt_cnt += cnt[i];
+	}
+	for (i = 0; i < cfg->fbacks; i++) {
+		msg_start_genl(&m, SMC_NETLINK_GET_FBACK_STATS);
+		nest_start(&m, SMC_GEN_FBACK_STATS);
+		put_u8(&m, SMC_NLA_FBACK_STATS_TYPE, i % 2);
+		put_u64(&m, SMC_NLA_FBACK_STATS_SRV_CNT, srv_cnt);
+		put_u64(&m, SMC_NLA_FBACK_STATS_CLNT_CNT, clnt_cnt);
+		put_u32(&m, SMC_NLA_FBACK_STATS_RSN_CODE,
+			fback_codes[i / 2 % (sizeof(fback_codes) / sizeof(fback_codes[0]))]);
+		put_u16(&m, SMC_NLA_FBACK_STATS_RSN_CNT, cnt[i]);
+		nest_end(&m);
+		rec_write(ctx, NL_REC_GENL, SMC_NETLINK_GET_FBACK_STATS, &m);
+	}
+	free(cnt);
+	rec_done(ctx, NL_REC_GENL, SMC_NETLINK_GET_FBACK_STATS);
+}
+
+static void set_cursor(struct smc_diag_cursor *c, __u64 bytes)
+{
+	c->wrap = bytes / GEN_CURSOR_SIZE;
+	c->count = bytes % GEN_CURSOR_SIZE;
+}
+
+static void msg_sock(struct gen_ctx *ctx, struct gen_msg *m, unsigned int k,
+		     unsigned char ext)
+{
+	const struct nl_gen_cfg *cfg = ctx->cfg;
+	unsigned int lgr = 0, link = 0;
+	struct smc_diag_msg *r;
+	int connected, mode;
+	__u8 shutdown = 0;
+	__u64 bytes;
+
+	msg_start(m, SOCK_DIAG_BY_FAMILY);
+	r = (struct smc_diag_msg *)(m->buf + m->len);
+	m->len += NLMSG_ALIGN(sizeof(*r));
+	r->diag_family = AF_INET;
+	switch (k % 10) {
+	case 0:  r->diag_state = 10; break;	/* LISTEN */
+	case 1:  r->diag_state = 2; break;	/* INIT */
+	case 2:  r->diag_state = 7; break;	/* CLOSED */
+	default: r->diag_state = 1; break;	/* ACTIVE */
+	}
+	switch (k % 5) {
+	case 3:  mode = SMC_DIAG_MODE_SMCD; break;
+	case 4:  mode = SMC_DIAG_MODE_FALLBACK_TCP; break;
+	default: mode = SMC_DIAG_MODE_SMCR; break;
+	}
+	r->diag_mode = mode;
+	r->id.idiag_sport = htons(40000 + k % 20000);
+	r->id.idiag_dport = htons(r->diag_state == 10 ? 0 : 445);
+	r->id.idiag_src[0] = htonl(0x0a000000 | (k & 0xffff));
+	if (r->diag_state != 10)
+		r->id.idiag_dst[0] = htonl(0x0a010000 | (k & 0xffff));
+	r->id.idiag_if = 1;
+	r->diag_uid = 1000;
+	r->diag_inode = 100000 + k;
+	connected = r->diag_state == 1 || r->diag_state == 7;
+	if (cfg->lgrs) {
+		lgr = k % cfg->lgrs;
+		link = cfg->links ? (k / cfg->lgrs) % cfg->links : 0;
+	}
+
+	put_u8(m, SMC_DIAG_SHUTDOWN, shutdown);
+	if (mode == SMC_DIAG_MODE_FALLBACK_TCP) {
+		struct smc_diag_fallback fb = {
+			.reason = SMC_CLC_DECL_PEERNOSMC,
+			.peer_diagnosis = k % 2 ? SMC_CLC_DECL_NOSMCDEV : 0,
+		};
+
+		put(m, SMC_DIAG_FALLBACK, &fb, sizeof(fb));
+		return;
+	}
+	if (!connected)
+		return;
+	if (ext & (1 << (SMC_DIAG_CONNINFO - 1))) {
+		struct smc_diag_conninfo ci;
+
+		memset(&ci, 0, sizeof(ci));
+		ci.token = k + 1;
+		ci.sndbuf_size = GEN_CURSOR_SIZE;
+		ci.rmbe_size = GEN_CURSOR_SIZE;
+		ci.peer_rmbe_size = GEN_CURSOR_SIZE;
+		/* sockets on the busiest links move 4 MB per round */
+		bytes = (__u64)ctx->round *
+			(link_conns(lgr, link) > 2 ? 4 << 20 : 256 << 10);
+		set_cursor(&ci.tx_prep, bytes);
+		set_cursor(&ci.tx_sent, bytes);
+		set_cursor(&ci.tx_fin, bytes);
+		set_cursor(&ci.tx_prod, bytes / 2);
+		set_cursor(&ci.tx_cons, bytes / 2);
+		set_cursor(&ci.rx_prod, bytes / 2);
+		set_cursor(&ci.rx_cons, bytes / 2);
+		put(m, SMC_DIAG_CONNINFO, &ci, sizeof(ci));
+	}
+	if (mode == SMC_DIAG_MODE_SMCR && cfg->lgrs && cfg->links &&
+	    (ext & (1 << (SMC_DIAG_LGRINFO - 1)))) {
+		struct smc_diag_lgrinfo li;
+
+		memset(&li, 0, sizeof(li));
+		li.role = lgr % 2;
+		dev_name((char *)li.lnk[0].ibname, sizeof(li.lnk[0].ibname),
+			 link_dev(cfg, lgr, link));
+		li.lnk[0].ibport = 1;
+		li.lnk[0].link_id = link + 1;
+		link_gid((char *)li.lnk[0].gid, sizeof(li.lnk[0].gid),
+			 link_dev(cfg, lgr, link));
+		link_peer_gid((char *)li.lnk[0].peer_gid, sizeof(li.lnk[0].peer_gid),
+			      lgr, link);
+		put(m, SMC_DIAG_LGRINFO, &li, sizeof(li));
+	}
+	if (mode == SMC_DIAG_MODE_SMCD && cfg->lgrs &&
+	    (ext & (1 << (SMC_DIAG_DMBINFO - 1)))) {
+		struct smcd_diag_dmbinfo di;
+
+		memset(&di, 0, sizeof(di));
+		di.linkid = lgr_smcd_id(lgr);
+		di.peer_gid = 0x2000000000ULL + lgr;
+		di.my_gid = 0x1000000000ULL + lgr % cfg->devs;
+		di.token = 0x10000 + k;
+		di.peer_token = 0x20000 + k;
+		put(m, SMC_DIAG_DMBINFO, &di, sizeof(di));
+	}
+}
+
+static void gen_socks(struct gen_ctx *ctx, unsigned char ext)
+{
+	struct gen_msg m;
+	unsigned int k;
+
+	for (k = 0; k < ctx->cfg->socks; k++) {
+		msg_sock(ctx, &m, k, ext);
+		rec_write(ctx, NL_REC_DIAG, ext, &m);
+	}
+	rec_done(ctx, NL_REC_DIAG, ext);
+}
+
+static void gen_round(struct gen_ctx *ctx)
+{
+	const struct nl_gen_cfg *cfg = ctx->cfg;
+	unsigned int i;
+
+	if (cfg->what & NL_GEN_SYS)
+		gen_sys_info(ctx);
+	if (cfg->what & NL_GEN_DEVR)
+		gen_devs_smcr(ctx);
+	if (cfg->what & NL_GEN_DEVD)
+		gen_devs_smcd(ctx);
+	if (cfg->what & NL_GEN_LGR)
+		gen_lgrs_smcr(ctx);
+	if (cfg->what & NL_GEN_LINK)
+		gen_links(ctx);
+	if (cfg->what & NL_GEN_LGRD)
+		gen_lgrs_smcd(ctx);
+	if (cfg->what & NL_GEN_STATS)
+		gen_stats(ctx);
+	if (cfg->what & NL_GEN_FBACK)
+		gen_fbacks(ctx);
+	if (!(cfg->what & NL_GEN_SOCK))
+		return;
+	if (cfg->sock_ext >= 0) {
+		gen_socks(ctx, cfg->sock_ext);
+		return;
+	}
+	for (i = 0; i < sizeof(sock_exts); i++)
+		gen_socks(ctx, sock_exts[i]);
+}
+
+long nl_gen_write(FILE *fp, const struct nl_gen_cfg *cfg)
+{
+	struct gen_ctx ctx = {
+		.fp = fp,
+		.cfg = cfg,
+		.rnd = cfg->seed ? cfg->seed : 1,
+	};
+	unsigned int s, r;
+
+	if (!cfg->devs)
+		return -1;
+	for (s = 0; s < cfg->samples; s++) {
+		if (cfg->samples > 1)
+			rec_mark(&ctx, s);
+		for (r = 0; r < cfg->rounds; r++) {
+			gen_round(&ctx);
+			ctx.round++;
+		}
+	}
+	if (fflush(fp) || ctx.err)
+		return -1;
+
+	return ctx.cnt;
+}
@@ -0,0 +1,58 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Synthetic SMC_NL_RECORD dumps for tests, benchmarks and fuzzing
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#ifndef NL_GEN_H_
+#define NL_GEN_H_
+
+#include <stdio.h>
+
+/* dumps to generate */
+#define NL_GEN_SYS	0x0001	/* SMC_NETLINK_GET_SYS_INFO */
+#define NL_GEN_DEVR	0x0002	/* SMC_NETLINK_GET_DEV_SMCR */
+#define NL_GEN_DEVD	0x0004	/* SMC_NETLINK_GET_DEV_SMCD */
+#define NL_GEN_LGR	0x0008	/* SMC_NETLINK_GET_LGR_SMCR */
+#define NL_GEN_LINK	0x0010	/* SMC_NETLINK_GET_LINK_SMCR */
+#define NL_GEN_LGRD	0x0020	/* SMC_NETLINK_GET_LGR_SMCD */
+#define NL_GEN_STATS	0x0040	/* SMC_NETLINK_GET_STATS */
+#define NL_GEN_FBACK	0x0080	/* SMC_NETLINK_GET_FBACK_STATS */
+#define NL_GEN_SOCK	0x0100	/* sock_diag, once per extension set */
+#define NL_GEN_ALL	0x01ff
+
+struct nl_gen_cfg {
+	unsigned int	what;		/* NL_GEN_* */
+	unsigned int	devs;		/* SMC-R and SMC-D devices each */
+	unsigned int	lgrs;		/* SMC-R and SMC-D link groups each */
+	unsigned int	links;		/* links per SMC-R link group */
+	unsigned int	socks;
+	unsigned int	fbacks;		/* fallback reason records */
+	unsigned int	samples;	/* samples, separated by marks */
+	unsigned int	rounds;		/* dumps per sample, see below */
+	unsigned int	seed;
+	int		sock_ext;	/* sock_diag extensions, or -1 */
+};
+
+/* Defaults: a small system with 2 devices, 4 link groups with 2 links each,
+ * and 20 sockets
+ */
+void nl_gen_defaults(struct nl_gen_cfg *cfg);
+
+/* Write the dumps of cfg as SMC_NL_RECORD records to fp. A sample holds the
+ * dumps rounds times, with the connection cursors advanced in each round, for
+ * commands that dump the same data more than once without sample marks.
+ * With sock_ext -1, sockets are written once for each set of the extensions
+ * that the tools request. Returns the number of records of the
+ * dumps (without NLMSG_DONE and marks), or -1 on write errors.
+ */
+long nl_gen_write(FILE *fp, const struct nl_gen_cfg *cfg);
+
+#endif /* NL_GEN_H_ */
@@ -0,0 +1,190 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * Write synthetic netlink dumps for SMC_NL_REPLAY
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nl_gen.h"
+
+static char *progname;
+
+static const struct {
+	const char	*name;
+	unsigned int	what;
+} dumps[] = {
+	{ "sys",	NL_GEN_SYS },
+	{ "devr",	NL_GEN_DEVR },
+	{ "devd",	NL_GEN_DEVD },
+	{ "lgr",	NL_GEN_LGR },
+	{ "link",	NL_GEN_LINK },
+	{ "lgrd",	NL_GEN_LGRD },
+	{ "stats",	NL_GEN_STATS },
+	{ "fback",	NL_GEN_FBACK },
+	{ "sock",	NL_GEN_SOCK },
+	{ "all",	NL_GEN_ALL },
+};
+
+static const struct option long_opts[] = {
+	{ "dumps", 1, 0, 't' },
+	{ "devices", 1, 0, 'D' },
+	{ "linkgroups", 1, 0, 'l' },
+	{ "links", 1, 0, 'k' },
+	{ "sockets", 1, 0, 's' },
+	{ "fallbacks", 1, 0, 'f' },
+	{ "samples", 1, 0, 'S' },
+	{ "rounds", 1, 0, 'r' },
+	{ "seed", 1, 0, 'x' },
+	{ "extensions", 1, 0, 'e' },
+	{ "help", 0, 0, 'h' },
+	{ NULL, 0, NULL, 0}
+};
+
+static void _usage(FILE *dest)
+{
+	fprintf(dest,
+"Usage: %s [ OPTIONS ] FILE\n"
+"\t-h, --help              this message\n"
+"\t-t, --dumps LIST        dumps to write, comma separated list of sys,\n"
+"\t                        devr, devd, lgr, link, lgrd, stats, fback, sock\n"
+"\t                        and all (default)\n"
+"\t-D, --devices N         SMC-R and SMC-D devices each (default 2)\n"
+"\t-l, --linkgroups N      SMC-R and SMC-D link groups each (default 4)\n"
+"\t-k, --links N           links per SMC-R link group (default 2)\n"
+"\t-s, --sockets N         sockets (default 20)\n"
+"\t-f, --fallbacks N       fallback reason records (default 6)\n"
+"\t-S, --samples N         samples, separated by sample marks (default 1)\n"
+"\t-r, --rounds N          dumps per sample (default 1)\n"
+"\t-x, --seed N            seed of the counter values (default 1)\n"
+"\t-e, --extensions N      write the sockets for these sock_diag extensions\n"
+"\t                        only, instead of for every set the tools use\n",
+		progname);
+}
+
+static void help(void) __attribute__((noreturn));
+static void help(void)
+{
+	_usage(stdout);
+	exit(0);
+}
+
+static void usage(void) __attribute__((noreturn));
+static void usage(void)
+{
+	_usage(stderr);
+	exit(-1);
+}
+
+static unsigned int get_num(const char *arg)
+{
+	char *end;
+	long val;
+
+	errno = 0;
+	val = strtol(arg, &end, 0);
+	if (errno || end == arg || *end || val < 0 || val > 100000000)
+		usage();
+	return val;
+}
+
+static unsigned int get_dumps(char *arg)
+{
+	unsigned int what = 0, i;
+	char *tok;
+
+	for (tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+		for (i = 0; i < sizeof(dumps) / sizeof(dumps[0]); i++) {
+			if (!strcmp(tok, dumps[i].name))
+				break;
+		}
+		if (i == sizeof(dumps) / sizeof(dumps[0])) {
+			fprintf(stderr, "Error: Unknown dump \"%s\"\n", tok);
+			usage();
+		}
+		what |= dumps[i].what;
+	}
+	return what;
+}
+
+int main(int argc, char **argv)
+{
+	struct nl_gen_cfg cfg;
+	char *slash;
+	long cnt;
+	FILE *fp;
+	int ch;
+
+	progname = (slash = strrchr(argv[0], '/')) ? slash + 1 : argv[0];
+	nl_gen_defaults(&cfg);
+	while ((ch = getopt_long(argc, argv, "ht:D:l:k:s:f:S:r:x:e:", long_opts,
+				 NULL)) != EOF) {
+		switch (ch) {
+		case 't':
+			cfg.what = get_dumps(optarg);
+			break;
+		case 'D':
+			cfg.devs = get_num(optarg);
+			if (!cfg.devs)
+				usage();
+			break;
+		case 'l':
+			cfg.lgrs = get_num(optarg);
+			break;
+		case 'k':
+			cfg.links = get_num(optarg);
+			break;
+		case 's':
+			cfg.socks = get_num(optarg);
+			break;
+		case 'f':
+			cfg.fbacks = get_num(optarg);
+			break;
+		case 'S':
+			cfg.samples = get_num(optarg);
+			break;
+		case 'r':
+			cfg.rounds = get_num(optarg);
+			break;
+		case 'x':
+			cfg.seed = get_num(optarg);
+			break;
+		case 'e':
+			cfg.sock_ext = get_num(optarg);
+			if (cfg.sock_ext > 255)
+				usage();
+			break;
+		case 'h':
+			help();
+		case '?':
+		default:
+			usage();
+		}
+	}
+	if (optind != argc - 1)
+		usage();
+
+	fp = fopen(argv[optind], "w");
+	if (!fp) {
+		fprintf(stderr, "Error: Cannot open %s: %s\n", argv[optind],
+			strerror(errno));
+		return EXIT_FAILURE;
+	}
+	cnt = nl_gen_write(fp, &cfg);
+	if (fclose(fp) || cnt < 0) {
+		fprintf(stderr, "Error: Cannot write %s\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
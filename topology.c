@@ -0,0 +1,756 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * User space program for SMC Information display
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "smctools_common.h"
+#include "util.h"
+#include "libnetlink.h"
+#include "linkgroup.h"
+#include "dev.h"
+#include "topology.h"
+
+#define TOPO_HASH_SIZE	256
+
+static int type_entered = 0;
+static int json_cmd = 0;
+#if defined(SMCD)
+static int topo_smcr = 0;
+static int topo_smcd = 1;
+#elif defined(SMCR)
+static int topo_smcr = 1;
+static int topo_smcd = 0;
+#else
+static int topo_smcr = 1;
+static int topo_smcd = 1;
+#endif
+static int d_level = 0;
+
+static char target_type[SMC_TYPE_STR_MAX] = {0};
+
+/* sock_diag dump handlers take no argument */
+static struct topology *cur_topo;
+
+static void usage(void)
+{
+	fprintf(stderr,
+#if defined(SMCD)
+		"Usage: smcd topology [show | json]\n"
+#elif defined(SMCR)
+		"Usage: smcr topology [show | json]\n"
+#else
+		"Usage: smc topology [show | json] [type {smcd | smcr}]\n"
+#endif
+	);
+	exit(-1);
+}
+
+static void *topo_zalloc(size_t size)
+{
+	void *p = calloc(1, size);
+
+	if (!p) {
+		perror("Error: Cannot allocate memory");
+		exit(-1);
+	}
+	return p;
+}
+
+const char *smc_sock_state(unsigned char x)
+{
+	static char buf[16];
+
+	switch (x) {
+	case 1:		return "ACTIVE";
+	case 2:		return "INIT";
+	case 7:		return "CLOSED";
+	case 10:	return "LISTEN";
+	case 20:	return "PEERCLOSEWAIT1";
+	case 21:	return "PEERCLOSEWAIT2";
+	case 22:	return "APPCLOSEWAIT1";
+	case 23:	return "APPCLOSEWAIT2";
+	case 24:	return "APPFINCLOSEWAIT1";
+	case 25:	return "PEERFINCLOSEWAIT";
+	case 26:	return "PEERABORTWAIT";
+	case 27:	return "PROCESSABORT";
+	default:	sprintf(buf, "%#x?", x); return buf;
+	}
+}
+
+/* see addr_format() in smcss.c for the address family detection */
+void smc_sock_addr(char *buf, size_t len, __be32 addr[4], int port)
+{
+	char addr_buf[INET6_ADDRSTRLEN + 1];
+	int af;
+
+	if (addr[1] == 0 && addr[2] == 0 && addr[3] == 0)
+		af = AF_INET;
+	else
+		af = AF_INET6;
+	if (!inet_ntop(af, addr, addr_buf, sizeof(addr_buf)))
+		snprintf(addr_buf, sizeof(addr_buf), "?");
+	if (af == AF_INET6)
+		snprintf(buf, len, "[%s]:%d", addr_buf, port);
+	else
+		snprintf(buf, len, "%s:%d", addr_buf, port);
+}
+
+static int topo_parse(struct nl_msg *msg, struct nlattr **attrs)
+{
+	struct nlmsghdr *hdr = nlmsg_hdr(msg);
+
+	if (genlmsg_parse(hdr, 0, attrs, SMC_GEN_MAX,
+			  (struct nla_policy *)smc_gen_net_policy) < 0) {
+		fprintf(stderr, "Error: Invalid data returned: smc_gen_net_policy\n");
+		nl_msg_dump(msg, stderr);
+		return NL_STOP;
+	}
+	return NL_OK;
+}
+
+static void topo_add_port(struct topology *topo, struct topo_dev *dev, int idx)
+{
+	struct topo_port *port = &dev->port[idx];
+
+	port->dev = dev;
+	port->valid = dev->info.port_valid[idx];
+	port->links_tail = &port->links;
+	memcpy(port->key.ibname, dev->info.dev_name, sizeof(port->key.ibname));
+	port->key.ibport = idx + 1;
+	if (smc_hash_add(&topo->port_idx, &port->key, sizeof(port->key), port))
+		goto errout;
+	return;
+errout:
+	perror("Error: Cannot allocate memory");
+	exit(-1);
+}
+
+static int topo_add_dev(struct topology *topo, struct smc_diag_dev_info *info, int smcd)
+{
+	struct topo_dev *dev;
+	int i;
+
+	dev = topo_zalloc(sizeof(*dev));
+	dev->lgrs_tail = &dev->lgrs;
+	dev->info = *info;
+	if (!smcd) {
+		for (i = 0; i < SMC_MAX_PORTS; i++)
+			topo_add_port(topo, dev, i);
+	} else {
+		dev->smcd = 1;
+		dev->chid = dev->info.pci_pchid;
+		if (smc_hash_add(&topo->chid_idx, &dev->chid, sizeof(dev->chid), dev)) {
+			free(dev);
+			return NL_STOP;
+		}
+	}
+	*topo->devs_tail = dev;
+	topo->devs_tail = &dev->next;
+
+	return NL_OK;
+}
+
+static int topo_add_link(struct topology *topo, struct nlattr **attrs)
+{
+	struct topo_lgr *lgr = topo->cur_lgr;
+	struct topo_port_key pkey = {0};
+	struct topo_link *link, **pos;
+	struct topo_port *port;
+
+	if (!lgr)
+		return NL_OK;	/* link without link group, ignore */
+	link = topo_zalloc(sizeof(*link));
+	if (fill_link_struct(&link->info, attrs) != NL_OK) {
+		free(link);
+		return NL_STOP;
+	}
+	link->lgr = lgr;
+	link->socks_tail = &link->socks;
+	for (pos = &lgr->links; *pos; pos = &(*pos)->next_lgr)
+		;
+	*pos = link;
+	lgr->nlinks++;
+
+	memcpy(link->key.gid, link->info.v1.gid, sizeof(link->key.gid));
+	memcpy(link->key.peer_gid, link->info.v1.peer_gid, sizeof(link->key.peer_gid));
+	link->key.link_id = link->info.v1.link_id;
+	if (smc_hash_add(&topo->uid_idx, link->info.link_uid,
+			 sizeof(link->info.link_uid), link) ||
+	    smc_hash_add(&topo->gid_idx, &link->key, sizeof(link->key), link))
+		return NL_STOP;
+
+	memcpy(pkey.ibname, link->info.v1.ibname, sizeof(pkey.ibname));
+	pkey.ibport = link->info.v1.ibport;
+	port = smc_hash_find(&topo->port_idx, &pkey, sizeof(pkey));
+	if (port) {
+		link->port = port;
+		*port->links_tail = link;
+		port->links_tail = &link->next_port;
+		port->nlinks++;
+	} else {
+		link->next_port = topo->orphan_links;
+		topo->orphan_links = link;
+	}
+
+	return NL_OK;
+}
+
+/* arg is a (struct topology *) */
+static int handle_topo_lgr_reply(struct nl_msg *msg, void *arg)
+{
+	struct topology *topo = (struct topology *)arg;
+	struct nlattr *attrs[SMC_GEN_MAX + 1];
+	struct topo_lgr *lgr;
+	int rc;
+
+	if (topo_parse(msg, attrs) != NL_OK)
+		return NL_STOP;
+	if (!attrs[SMC_GEN_LGR_SMCR] && !attrs[SMC_GEN_LINK_SMCR] && !attrs[SMC_GEN_LGR_SMCD])
+		return NL_STOP;
+
+	/* a link dump sends each link group followed by its links */
+	if (attrs[SMC_GEN_LINK_SMCR])
+		return topo_add_link(topo, attrs);
+
+	lgr = topo_zalloc(sizeof(*lgr));
+	lgr->socks_tail = &lgr->socks;
+	if (attrs[SMC_GEN_LGR_SMCR]) {
+		rc = fill_lgr_struct(&lgr->r, attrs);
+		lgr->key[0] = *(__u32 *)lgr->r.lgr_id;
+		topo->cur_lgr = lgr;
+	} else {
+		rc = fill_lgr_smcd_struct(&lgr->d, attrs);
+		lgr->key[0] = lgr->d.v1.linkid;
+		lgr->key[1] = 1;
+		lgr->smcd = 1;
+		lgr->ism = smc_hash_find(&topo->chid_idx, &lgr->d.chid, sizeof(lgr->d.chid));
+		if (lgr->ism) {
+			*lgr->ism->lgrs_tail = lgr;
+			lgr->ism->lgrs_tail = &lgr->next_ism;
+		}
+	}
+	*topo->lgrs_tail = lgr;
+	topo->lgrs_tail = &lgr->next;
+	if (rc != NL_OK)
+		return rc;
+	if (smc_hash_add(&topo->lgr_idx, lgr->key, sizeof(lgr->key), lgr))
+		return NL_STOP;
+
+	return NL_OK;
+}
+
+static void topo_add_sock(struct nlmsghdr *nlh)
+{
+	struct smc_diag_msg *r = NLMSG_DATA(nlh);
+	struct rtattr *tb[SMC_DIAG_MAX + 1];
+	struct topology *topo = cur_topo;
+	struct topo_sock *sock, ***tail;
+	struct topo_lgr *lgr = NULL;
+
+	if (nlh->nlmsg_len < NLMSG_LENGTH(sizeof(*r)))
+		return;	/* truncated message */
+	parse_rtattr(tb, SMC_DIAG_MAX, (struct rtattr *)(r+1),
+		     nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*r)));
+
+	if (r->diag_state == 10 || r->diag_state == 2)
+		return;	/* LISTEN and INIT sockets have no link */
+	if (r->diag_mode == SMC_DIAG_MODE_FALLBACK_TCP) {
+		topo->fback_socks++;
+		return;
+	}
+	if ((r->diag_mode == SMC_DIAG_MODE_SMCR && !topo->smcr) ||
+	    (r->diag_mode == SMC_DIAG_MODE_SMCD && !topo->smcd))
+		return;
+
+	sock = topo_zalloc(sizeof(*sock));
+	sock->id = r->id;
+	sock->inode = r->diag_inode;
+	sock->state = r->diag_state;
+	sock->mode = r->diag_mode;
+	if (tb[SMC_DIAG_CONNINFO] &&
+	    RTA_PAYLOAD(tb[SMC_DIAG_CONNINFO]) >= sizeof(struct smc_diag_conninfo)) {
+		memcpy(&sock->cinfo, RTA_DATA(tb[SMC_DIAG_CONNINFO]), sizeof(sock->cinfo));
+		sock->has_cinfo = 1;
+	}
+
+	tail = &topo->orphan_tail;
+	if (r->diag_mode == SMC_DIAG_MODE_SMCR && tb[SMC_DIAG_LGRINFO] &&
+	    RTA_PAYLOAD(tb[SMC_DIAG_LGRINFO]) >= sizeof(struct smc_diag_lgrinfo)) {
+		struct smc_diag_lgrinfo linfo;
+		struct topo_link_key key;
+
+		memcpy(&linfo, RTA_DATA(tb[SMC_DIAG_LGRINFO]), sizeof(linfo));
+		memset(&key, 0, sizeof(key));
+		memcpy(key.gid, linfo.lnk[0].gid, sizeof(key.gid));
+		memcpy(key.peer_gid, linfo.lnk[0].peer_gid, sizeof(key.peer_gid));
+		key.link_id = linfo.lnk[0].link_id;
+		sock->link = smc_hash_find(&topo->gid_idx, &key, sizeof(key));
+		if (sock->link) {
+			lgr = sock->link->lgr;
+			sock->link->nsocks++;
+			tail = &sock->link->socks_tail;
+		}
+	} else if (r->diag_mode == SMC_DIAG_MODE_SMCD && tb[SMC_DIAG_DMBINFO] &&
+		   RTA_PAYLOAD(tb[SMC_DIAG_DMBINFO]) >= sizeof(struct smcd_diag_dmbinfo)) {
+		struct smcd_diag_dmbinfo dinfo;
+
+		memcpy(&dinfo, RTA_DATA(tb[SMC_DIAG_DMBINFO]), sizeof(dinfo));
+		lgr = topology_find_lgr(topo, dinfo.linkid, 1);
+		if (lgr) {
+			lgr->nsocks++;
+			tail = &lgr->socks_tail;
+		}
+	}
+	**tail = sock;
+	*tail = &sock->next;
+	sock->lgr = lgr;
+	topo->nsocks++;
+
+	if (lgr && sock->has_cinfo) {
+		sock->tkey[0] = sock->cinfo.token;
+		sock->tkey[1] = lgr->key[0];
+		if (smc_hash_add(&topo->token_idx, sock->tkey, sizeof(sock->tkey), sock)) {
+			perror("Error: Cannot allocate memory");
+			exit(-1);
+		}
+	}
+}
+
+static int topo_dump_socks(struct topology *topo, int sock_ext)
+{
+	struct rtnl_handle rth;
+	unsigned char cmd = sock_ext;
+	int rc;
+
+	if (rtnl_open(&rth))
+		return EXIT_FAILURE;
+	rth.dump = MAGIC_SEQ;
+	if (topo->smcr)
+		cmd |= (1<<(SMC_DIAG_LGRINFO-1));
+	if (topo->smcd)
+		cmd |= (1<<(SMC_DIAG_DMBINFO-1));
+	if ((rc = sockdiag_send(rth.fd, cmd)))
+		goto exit;
+	cur_topo = topo;
+	rc = rtnl_dump(&rth, topo_add_sock);
+	cur_topo = NULL;
+exit:
+	rtnl_close(&rth);
+	return rc;
+}
+
+/* Run the device, link group, link and socket dumps once and join them */
+struct topology *topology_build(int smcr, int smcd, int flags)
+{
+	struct smc_dev_inventory *inv;
+	int i, cmds[2], ncmds = 0;
+	struct topology *topo;
+
+	topo = topo_zalloc(sizeof(*topo));
+	topo->smcr = smcr;
+	topo->smcd = smcd;
+	topo->devs_tail = &topo->devs;
+	topo->lgrs_tail = &topo->lgrs;
+	topo->orphan_tail = &topo->orphan_socks;
+	if (smc_hash_init(&topo->lgr_idx, TOPO_HASH_SIZE) ||
+	    smc_hash_init(&topo->uid_idx, TOPO_HASH_SIZE) ||
+	    smc_hash_init(&topo->gid_idx, TOPO_HASH_SIZE) ||
+	    smc_hash_init(&topo->port_idx, TOPO_HASH_SIZE) ||
+	    smc_hash_init(&topo->chid_idx, TOPO_HASH_SIZE) ||
+	    smc_hash_init(&topo->token_idx, TOPO_HASH_SIZE)) {
+		perror("Error: Cannot allocate memory");
+		goto errout;
+	}
+
+	/* devices first, so that links and link groups find their ports */
+	inv = dev_inventory_get((smcr ? SMC_INV_SMCR : 0) | (smcd ? SMC_INV_SMCD : 0));
+	if (!inv)
+		goto errout;
+	for (i = 0; smcr && i < inv->nsmcr; i++) {
+		if (topo_add_dev(topo, &inv->smcr[i], 0) != NL_OK)
+			goto errout;
+	}
+	for (i = 0; smcd && i < inv->nsmcd; i++) {
+		if (topo_add_dev(topo, &inv->smcd[i], 1) != NL_OK)
+			goto errout;
+	}
+	/* SMC-R links and SMC-D link groups in one batch */
+	if (smcr)
+		cmds[ncmds++] = SMC_NETLINK_GET_LINK_SMCR;
+	if (smcd)
+		cmds[ncmds++] = SMC_NETLINK_GET_LGR_SMCD;
+	if (ncmds && gen_nl_handle_dumps(cmds, ncmds, handle_topo_lgr_reply, topo))
+		goto errout;
+	topo->cur_lgr = NULL;
+	if (!(flags & TOPO_NO_SOCKS) && topo_dump_socks(topo, flags & 0xff))
+		goto errout;
+
+	return topo;
+errout:
+	topology_free(topo);
+	return NULL;
+}
+
+static void topo_free_socks(struct topo_sock *sock)
+{
+	struct topo_sock *next;
+
+	for (; sock; sock = next) {
+		next = sock->next;
+		free(sock);
+	}
+}
+
+void topology_free(struct topology *topo)
+{
+	struct topo_link *link, *next_link;
+	struct topo_lgr *lgr, *next_lgr;
+	struct topo_dev *dev, *next_dev;
+
+	if (!topo)
+		return;
+	for (lgr = topo->lgrs; lgr; lgr = next_lgr) {
+		next_lgr = lgr->next;
+		for (link = lgr->links; link; link = next_link) {
+			next_link = link->next_lgr;
+			topo_free_socks(link->socks);
+			free(link);
+		}
+		topo_free_socks(lgr->socks);
+		free(lgr);
+	}
+	for (dev = topo->devs; dev; dev = next_dev) {
+		next_dev = dev->next;
+		free(dev);
+	}
+	topo_free_socks(topo->orphan_socks);
+	smc_hash_free(&topo->lgr_idx);
+	smc_hash_free(&topo->uid_idx);
+	smc_hash_free(&topo->gid_idx);
+	smc_hash_free(&topo->port_idx);
+	smc_hash_free(&topo->chid_idx);
+	smc_hash_free(&topo->token_idx);
+	free(topo);
+}
+
+struct topo_lgr *topology_find_lgr(struct topology *topo, __u32 lgr_id, int smcd)
+{
+	__u32 key[2] = { lgr_id, !!smcd };
+
+	return smc_hash_find(&topo->lgr_idx, key, sizeof(key));
+}
+
+struct topo_link *topology_find_link(struct topology *topo, __u8 *link_uid)
+{
+	return smc_hash_find(&topo->uid_idx, link_uid, 4);
+}
+
+struct topo_sock *topology_find_sock(struct topology *topo, __u32 lgr_id, __u32 token)
+{
+	__u32 key[2] = { token, lgr_id };
+
+	return smc_hash_find(&topo->token_idx, key, sizeof(key));
+}
+
+struct topo_port *topology_find_port(struct topology *topo, __u8 *ibname, __u8 ibport)
+{
+	struct topo_port_key key;
+
+	memset(&key, 0, sizeof(key));
+	snprintf((char *)key.ibname, sizeof(key.ibname), "%s", (char *)ibname);
+	key.ibport = ibport;
+	return smc_hash_find(&topo->port_idx, &key, sizeof(key));
+}
+
+static void print_topo_sock(struct topo_sock *sock, int indent)
+{
+	char local[64], peer[64];
+
+	smc_sock_addr(local, sizeof(local), sock->id.idiag_src, ntohs(sock->id.idiag_sport));
+	smc_sock_addr(peer, sizeof(peer), sock->id.idiag_dst, ntohs(sock->id.idiag_dport));
+	printf("%*s%07llu %-14s %s %s", indent, "", sock->inode,
+	       smc_sock_state(sock->state), local, peer);
+	if (sock->has_cinfo)
+		printf(" token %08x", sock->cinfo.token);
+	printf("\n");
+}
+
+static void print_topo_socks(struct topo_sock *sock, int indent)
+{
+	if (d_level < SMC_DETAIL_LEVEL_V)
+		return;
+	for (; sock; sock = sock->next)
+		print_topo_sock(sock, indent);
+}
+
+static void print_topo_link(struct topo_link *link, int indent)
+{
+	struct topo_lgr *lgr = link->lgr;
+
+	printf("%*sLG-ID %08x %s %-6s Link-UID %08x %-15s #Conns %d #Socks %d\n",
+	       indent, "", lgr->key[0], lgr->r.lgr_role ? "SERV" : "CLNT",
+	       smc_lgr_type(lgr->r.lgr_type), ntohl(*(__u32 *)link->info.link_uid),
+	       smc_link_state(link->info.link_state), link->info.conn_cnt,
+	       link->nsocks);
+	print_topo_socks(link->socks, indent + 2);
+}
+
+static void print_topo_smcd_lgr(struct topo_lgr *lgr, int indent)
+{
+	printf("%*sLG-ID %08x VLAN %#x #Conns %d #Socks %d\n", indent, "",
+	       lgr->key[0], lgr->d.vlan_id, lgr->d.conns_num, lgr->nsocks);
+	print_topo_socks(lgr->socks, indent + 2);
+}
+
+static void print_topo_text(struct topology *topo)
+{
+	struct topo_link *link;
+	struct topo_port *port;
+	struct topo_lgr *lgr;
+	struct topo_dev *dev;
+	int i, first = 1;
+
+	for (dev = topo->devs; dev; dev = dev->next) {
+		if (dev->smcd) {
+			printf("ISM %04x (PCHID %04x, PCI-ID %s) PNET-ID %s\n",
+			       dev->info.pci_fid, dev->info.pci_pchid, dev->info.pci_id,
+			       trim_space((char *)dev->info.pnet_id[0]));
+			for (lgr = dev->lgrs; lgr; lgr = lgr->next_ism)
+				print_topo_smcd_lgr(lgr, 2);
+			continue;
+		}
+		printf("%s (%s, PCI-ID %s)\n", dev->info.dev_name,
+		       smc_ib_dev_type(dev->info.pci_device), dev->info.pci_id);
+		for (i = 0; i < SMC_MAX_PORTS; i++) {
+			port = &dev->port[i];
+			if (!port->valid && !port->links)
+				continue;
+			printf("  Port %d %-15s %-8s PNET-ID %s #Links %d\n", i + 1,
+			       dev->info.netdev[i][0] ? (char *)dev->info.netdev[i] : "-",
+			       smc_ib_port_state(dev->info.port_state[i]),
+			       trim_space((char *)dev->info.pnet_id[i]), port->nlinks);
+			for (link = port->links; link; link = link->next_port)
+				print_topo_link(link, 4);
+		}
+	}
+	for (lgr = topo->lgrs; lgr; lgr = lgr->next) {
+		if (!lgr->smcd || lgr->ism)
+			continue;
+		if (first)
+			printf("Unknown ISM device\n");
+		first = 0;
+		print_topo_smcd_lgr(lgr, 2);
+	}
+	if (topo->orphan_links)
+		printf("Unknown RoCE port\n");
+	for (link = topo->orphan_links; link; link = link->next_port)
+		print_topo_link(link, 2);
+	if (topo->orphan_socks && d_level >= SMC_DETAIL_LEVEL_V) {
+		printf("Unknown link\n");
+		print_topo_socks(topo->orphan_socks, 2);
+	}
+	printf("#Socks %d, TCP fallback %d\n", topo->nsocks, topo->fback_socks);
+}
+
+static void print_json_socks(struct topo_sock *sock)
+{
+	printf("\"sockets\":[");
+	for (; sock; sock = sock->next)
+		printf("%llu%s", sock->inode, sock->next ? "," : "");
+	printf("]");
+}
+
+static void print_topo_json(struct topology *topo)
+{
+	char local[64], peer[64];
+	struct topo_link *link;
+	struct topo_sock *sock;
+	struct topo_lgr *lgr;
+	struct topo_dev *dev;
+	int i, first;
+
+	printf("{\"devices\":[");
+	for (dev = topo->devs; dev; dev = dev->next) {
+		if (dev->smcd) {
+			printf("{\"type\":\"ISM\",\"fid\":\"%04x\",\"pchid\":\"%04x\","
+			       "\"pci_id\":\"%s\",\"pnet_id\":\"%s\",\"linkgroups\":[",
+			       dev->info.pci_fid, dev->info.pci_pchid, dev->info.pci_id,
+			       trim_space((char *)dev->info.pnet_id[0]));
+			for (lgr = dev->lgrs; lgr; lgr = lgr->next_ism)
+				printf("\"%08x\"%s", lgr->key[0], lgr->next_ism ? "," : "");
+			printf("]}");
+		} else {
+			printf("{\"type\":\"%s\",\"ibdev\":\"%s\",\"fid\":\"%04x\","
+			       "\"pchid\":\"%04x\",\"pci_id\":\"%s\",\"ports\":[",
+			       smc_ib_dev_type(dev->info.pci_device), dev->info.dev_name,
+			       dev->info.pci_fid, dev->info.pci_pchid, dev->info.pci_id);
+			first = 1;
+			for (i = 0; i < SMC_MAX_PORTS; i++) {
+				if (!dev->port[i].valid && !dev->port[i].links)
+					continue;
+				printf("%s{\"port\":%d,\"netdev\":\"%s\",\"state\":\"%s\","
+				       "\"pnet_id\":\"%s\",\"links\":[", first ? "" : ",",
+				       i + 1, dev->info.netdev[i],
+				       smc_ib_port_state(dev->info.port_state[i]),
+				       trim_space((char *)dev->info.pnet_id[i]));
+				for (link = dev->port[i].links; link; link = link->next_port)
+					printf("\"%08x\"%s", ntohl(*(__u32 *)link->info.link_uid),
+					       link->next_port ? "," : "");
+				printf("]}");
+				first = 0;
+			}
+			printf("]}");
+		}
+		if (dev->next)
+			printf(",");
+	}
+
+	printf("],\"linkgroups\":[");
+	for (lgr = topo->lgrs; lgr; lgr = lgr->next) {
+		if (lgr->smcd) {
+			printf("{\"id\":\"%08x\",\"smc\":\"D\",\"vlan\":%d,\"pnet_id\":\"%s\","
+			       "\"conns\":%d,", lgr->key[0], lgr->d.vlan_id,
+			       trim_space((char *)lgr->d.pnet_id), lgr->d.conns_num);
+			print_json_socks(lgr->socks);
+			printf("}");
+		} else {
+			printf("{\"id\":\"%08x\",\"smc\":\"R\",\"role\":\"%s\",\"type\":\"%s\","
+			       "\"vlan\":%d,\"pnet_id\":\"%s\",\"conns\":%d,\"links\":[",
+			       lgr->key[0], lgr->r.lgr_role ? "SERV" : "CLNT",
+			       smc_lgr_type(lgr->r.lgr_type), lgr->r.vlan_id,
+			       trim_space((char *)lgr->r.pnet_id), lgr->r.conns_num);
+			for (link = lgr->links; link; link = link->next_lgr) {
+				printf("{\"uid\":\"%08x\",\"id\":%d,\"state\":\"%s\","
+				       "\"ibdev\":\"%s\",\"ibport\":%d,\"netdev\":\"%s\","
+				       "\"conns\":%d,", ntohl(*(__u32 *)link->info.link_uid),
+				       link->info.v1.link_id, smc_link_state(link->info.link_state),
+				       link->info.v1.ibname, link->info.v1.ibport,
+				       link->info.netdev, link->info.conn_cnt);
+				print_json_socks(link->socks);
+				printf("}%s", link->next_lgr ? "," : "");
+			}
+			printf("]}");
+		}
+		if (lgr->next)
+			printf(",");
+	}
+
+	printf("],\"sockets\":[");
+	first = 1;
+	for (lgr = topo->lgrs; lgr; lgr = lgr->next) {
+		for (link = lgr->links; link; link = link->next_lgr) {
+			for (sock = link->socks; sock; sock = sock->next) {
+				smc_sock_addr(local, sizeof(local), sock->id.idiag_src,
+					      ntohs(sock->id.idiag_sport));
+				smc_sock_addr(peer, sizeof(peer), sock->id.idiag_dst,
+					      ntohs(sock->id.idiag_dport));
+				printf("%s{\"inode\":%llu,\"state\":\"%s\",\"mode\":\"SMCR\","
+				       "\"local\":\"%s\",\"peer\":\"%s\",\"lgr\":\"%08x\","
+				       "\"link\":\"%08x\"}", first ? "" : ",", sock->inode,
+				       smc_sock_state(sock->state), local, peer, lgr->key[0],
+				       ntohl(*(__u32 *)link->info.link_uid));
+				first = 0;
+			}
+		}
+		for (sock = lgr->socks; sock; sock = sock->next) {
+			smc_sock_addr(local, sizeof(local), sock->id.idiag_src,
+				      ntohs(sock->id.idiag_sport));
+			smc_sock_addr(peer, sizeof(peer), sock->id.idiag_dst,
+				      ntohs(sock->id.idiag_dport));
+			printf("%s{\"inode\":%llu,\"state\":\"%s\",\"mode\":\"SMCD\","
+			       "\"local\":\"%s\",\"peer\":\"%s\",\"lgr\":\"%08x\"}",
+			       first ? "" : ",", sock->inode, smc_sock_state(sock->state),
+			       local, peer, lgr->key[0]);
+			first = 0;
+		}
+	}
+	for (sock = topo->orphan_socks; sock; sock = sock->next) {
+		smc_sock_addr(local, sizeof(local), sock->id.idiag_src,
+			      ntohs(sock->id.idiag_sport));
+		smc_sock_addr(peer, sizeof(peer), sock->id.idiag_dst,
+			      ntohs(sock->id.idiag_dport));
+		printf("%s{\"inode\":%llu,\"state\":\"%s\",\"mode\":\"%s\","
+		       "\"local\":\"%s\",\"peer\":\"%s\"}", first ? "" : ",",
+		       sock->inode, smc_sock_state(sock->state),
+		       sock->mode == SMC_DIAG_MODE_SMCD ? "SMCD" : "SMCR", local, peer);
+		first = 0;
+	}
+	printf("],\"fallback_sockets\":%d}\n", topo->fback_socks);
+}
+
+static void handle_cmd_params(int argc, char **argv)
+{
+	if (((argc == 1) && (contains(argv[0], "help") == 0)) || (argc > 3))
+		usage();
+
+	if (argc > 0) {
+		if (contains(argv[0], "show") == 0)
+			json_cmd = 0;
+		else if (contains(argv[0], "json") == 0)
+			json_cmd = 1;
+		else
+			PREV_ARG(); /* no object given, so use the default "show" */
+	}
+
+	while (NEXT_ARG_OK()) {
+		NEXT_ARG();
+		if (type_entered) {
+			snprintf(target_type, sizeof(target_type), "%s", argv[0]);
+			if (strncmp(target_type, "smcd", SMC_TYPE_STR_MAX) == 0) {
+				topo_smcd = 1;
+				topo_smcr = 0;
+			} else if ((strnlen(target_type, sizeof(target_type)) < 4) ||
+				   (strncmp(target_type, "smcr", SMC_TYPE_STR_MAX) != 0)) {
+				print_type_error();
+			} else {
+				topo_smcd = 0;
+				topo_smcr = 1;
+			}
+			type_entered = 0;
+			break;
+		} else if (contains(argv[0], "help") == 0) {
+			usage();
+#if !defined(SMCD) && !defined(SMCR)
+		} else if (contains(argv[0], "type") == 0) {
+			type_entered = 1;
+#endif
+		} else {
+			usage();
+		}
+	}
+	/* Too many parameters or wrong sequence of parameters */
+	if (NEXT_ARG_OK() || type_entered)
+		usage();
+}
+
+int invoke_topology(int argc, char **argv, int detail_level)
+{
+	struct topology *topo;
+
+	d_level = detail_level;
+	handle_cmd_params(argc, argv);
+	topo = topology_build(topo_smcr, topo_smcd, TOPO_SOCK_CONNINFO);
+	if (!topo)
+		return EXIT_FAILURE;
+	if (json_cmd)
+		print_topo_json(topo);
+	else
+		print_topo_text(topo);
+	topology_free(topo);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+/*
+ * SMC Tools - Shared Memory Communication Tools
+ *
+ * Copyright IBM Corp. 2026
+ *
+ * User space program for SMC Information display
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ */
+
+#ifndef TOPOLOGY_H_
+#define TOPOLOGY_H_
+
+#include "util.h"
+
+struct topo_lgr;
+struct topo_link;
+struct topo_dev;
+
+struct topo_sock {
+	struct topo_sock	*next;		/* next socket on link, lgr or list */
+	struct topo_lgr		*lgr;
+	struct topo_link	*link;		/* SMC-R only */
+	struct inet_diag_sockid	id;
+	__u64			inode;
+	__u32			tkey[2];	/* token, LG-ID */
+	__u8			state;
+	__u8			mode;
+	int			has_cinfo;
+	struct smc_diag_conninfo cinfo;
+};
+
+struct topo_link_key {
+	__u8			gid[40];
+	__u8			peer_gid[40];
+	__u8			link_id;
+};
+
+struct topo_port_key {
+	__u8			ibname[IB_DEVICE_NAME_MAX];
+	__u8			ibport;
+};
+
+struct topo_link {
+	struct topo_link	*next_lgr;	/* next link of the link group */
+	struct topo_link	*next_port;	/* next link on the same port */
+	struct topo_lgr		*lgr;
+	struct topo_port	*port;
+	struct topo_sock	*socks;
+	struct topo_sock	**socks_tail;
+	int			nsocks;
+	struct topo_link_key	key;
+	struct smc_diag_linkinfo_v2 info;
+};
+
+struct topo_lgr {
+	struct topo_lgr		*next;
+	__u32			key[2];		/* LG-ID, is SMC-D */
+	int			smcd;
+	struct smc_diag_lgr	r;		/* SMC-R only */
+	struct smcd_diag_dmbinfo_v2 d;		/* SMC-D only */
+	struct topo_link	*links;
+	int			nlinks;
+	struct topo_dev		*ism;		/* SMC-D only */
+	struct topo_lgr		*next_ism;	/* next lgr on the same ISM device */
+	struct topo_sock	*socks;		/* SMC-D only */
+	struct topo_sock	**socks_tail;
+	int			nsocks;
+};
+
+struct topo_port {
+	struct topo_dev		*dev;
+	int			valid;
+	struct topo_port_key	key;
+	struct topo_link	*links;
+	struct topo_link	**links_tail;
+	int			nlinks;
+};
+
+struct topo_dev {
+	struct topo_dev		*next;
+	int			smcd;
+	__u16			chid;		/* SMC-D only */
+	struct smc_diag_dev_info info;
+	struct topo_port	port[SMC_MAX_PORTS];	/* SMC-R only */
+	struct topo_lgr		*lgrs;		/* SMC-D only */
+	struct topo_lgr		**lgrs_tail;
+};
+
+struct topology {
+	int			smcr;
+	int			smcd;
+	struct topo_dev		*devs;
+	struct topo_dev		**devs_tail;
+	struct topo_lgr		*lgrs;
+	struct topo_lgr		**lgrs_tail;
+	struct topo_lgr		*cur_lgr;	/* lgr of the links being dumped */
+	struct topo_link	*orphan_links;	/* links on unknown ports */
+	struct topo_sock	*orphan_socks;	/* SMC sockets on unknown links */
+	struct topo_sock	**orphan_tail;
+	int			nsocks;
+	int			fback_socks;
+	struct smc_hash		lgr_idx;	/* by LG-ID */
+	struct smc_hash		uid_idx;	/* links by link UID */
+	struct smc_hash		gid_idx;	/* links by GID, peer GID, link id */
+	struct smc_hash		port_idx;	/* ports by ibdev/port */
+	struct smc_hash		chid_idx;	/* ISM devices by CHID */
+	struct smc_hash		token_idx;	/* sockets by token, LG-ID */
+};
+
+/* flags of topology_build(), the low byte holds sock_diag extensions */
+#define TOPO_SOCK_CONNINFO	(1 << (SMC_DIAG_CONNINFO - 1))
+#define TOPO_NO_SOCKS		(1 << 8)	/* skip the socket dump */
+
+int invoke_topology(int argc, char **argv, int detail_level);
+struct topology *topology_build(int smcr, int smcd, int flags);
+void topology_free(struct topology *topo);
+struct topo_lgr *topology_find_lgr(struct topology *topo, __u32 lgr_id, int smcd);
+struct topo_link *topology_find_link(struct topology *topo, __u8 *link_uid);
+struct topo_sock *topology_find_sock(struct topology *topo, __u32 lgr_id, __u32 token);
+struct topo_port *topology_find_port(struct topology *topo, __u8 *ibname, __u8 ibport);
+const char *smc_sock_state(unsigned char x);
+void smc_sock_addr(char *buf, size_t len, __be32 addr[4], int port);
+
+#endif /* TOPOLOGY_H_ */
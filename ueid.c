@@ -29,8 +29,6 @@ static int show_cmd = 0;
 
 static char target_eid[SMC_MAX_EID_LEN + 1] = {0};
 
-extern int smc_id;
-extern struct nl_sock *sk;
 
 const struct nla_policy
 smc_gen_ueid_policy[SMC_NLA_EID_TABLE_MAX + 1] = {
@@ -51,49 +49,19 @@ static void usage(void)
 
 static int gen_nl_ueid_handle(int cmd, char *ueid, int (*cb_handler)(struct nl_msg *msg, void *arg))
 {
-	int rc = EXIT_FAILURE, nlmsg_flags = 0;
-	struct nl_msg *msg;
-
-	nl_socket_modify_cb(sk, NL_CB_VALID, NL_CB_CUSTOM, cb_handler, NULL);
-
-	/* Allocate a netlink message and set header information. */
-	msg = nlmsg_alloc();
-	if (!msg) {
-		nl_perror(NLE_NOMEM, "Error");
-		rc = EXIT_FAILURE;
-		goto err;
-	}
+	struct gen_nl_req req = {
+		.cmd = cmd,
+		.cb_handler = cb_handler,
+		.attr = SMC_NLA_EID_TABLE_ENTRY,
+		.str = ueid,
+	};
+	int rc;
 
 	if (cmd == SMC_NETLINK_DUMP_UEID)
-		nlmsg_flags = NLM_F_DUMP;
-
-	if (!genlmsg_put(msg, NL_AUTO_PORT, NL_AUTO_SEQ, smc_id, 0, nlmsg_flags,
-			 cmd, SMC_GENL_FAMILY_VERSION)) {
-		nl_perror(rc, "Error");
-		rc = EXIT_FAILURE;
-		goto err;
-	}
-
-	if (ueid && ueid[0]) {
-		rc = nla_put_string(msg, SMC_NLA_EID_TABLE_ENTRY, ueid);
-		if (rc < 0) {
-			nl_perror(rc, "Error");
-			rc = EXIT_FAILURE;
-			goto err;
-		}
+		req.flags = NLM_F_DUMP;
 
-	}
-
-	/* Send message */
-	rc = nl_send_auto(sk, msg);
-	if (rc < 0) {
-		nl_perror(rc, "Error");
-		rc = EXIT_FAILURE;
-		goto err;
-	}
-
-	/* Receive reply message, returns number of cb invocations. */
-	rc = nl_recvmsgs_default(sk);
+	gen_nl_batch_run(&req, 1);
+	rc = req.err;
 
 	if (rc < 0) {
 		/* For cmd "UEID remove" the kernel might return ENOENT when
@@ -125,15 +93,10 @@ static int gen_nl_ueid_handle(int cmd, char *ueid, int (*cb_handler)(struct nl_m
 		} else {
 			nl_perror(rc, "Error");
 		}
-		rc = EXIT_FAILURE;
-		goto err;
+		return EXIT_FAILURE;
 	}
 
-	nlmsg_free(msg);
 	return EXIT_SUCCESS;
-err:
-	nlmsg_free(msg);
-	return rc;
 }
 
 static int handle_gen_ueid_reply(struct nl_msg *msg, void *arg)
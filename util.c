@@ -16,9 +16,21 @@
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
+#include <net/if.h>
 
 #include "util.h"
 
+/* Interface names by ifindex, direct mapped. if_indextoname() costs a socket
+ * and an ioctl per call, and every port and link of a dump names its netdev,
+ * see the "link" and "dev" cases of "make bench".
+ */
+#define SMC_IFNAME_CACHE_SIZE	64
+
+static struct {
+	unsigned int	ifindex;
+	char		name[IF_NAMESIZE];
+} ifname_cache[SMC_IFNAME_CACHE_SIZE];
+
 void print_unsup_msg(void)
 {
 	fprintf(stderr, "Error: Kernel does not support this parameter !\n");
@@ -143,3 +155,131 @@ int get_abbreviated(uint64_t num, int max_digs, char *res)
 	snprintf(res, max_digs + 1, "%*.*lf%c", max_digs - 1, num_places, num / factor, magnitude);
 	return 0;
 }
+
+/* FNV-1a */
+static uint32_t smc_hash_key(const void *key, size_t klen)
+{
+	const unsigned char *p = key;
+	uint32_t hval = 2166136261u;
+
+	while (klen--) {
+		hval ^= *p++;
+		hval *= 16777619u;
+	}
+	return hval;
+}
+
+int smc_hash_init(struct smc_hash *ht, unsigned int size)
+{
+	unsigned int n = 16;
+
+	while (n < size)
+		n <<= 1;
+	ht->buckets = calloc(n, sizeof(*ht->buckets));
+	if (!ht->buckets)
+		return -1;
+	ht->size = n;
+	ht->count = 0;
+	return 0;
+}
+
+static void smc_hash_grow(struct smc_hash *ht)
+{
+	struct smc_hash_node **buckets, *node, *next;
+	unsigned int i, n = ht->size << 1;
+
+	buckets = calloc(n, sizeof(*buckets));
+	if (!buckets)
+		return;	/* keep the current table, chains just get longer */
+	for (i = 0; i < ht->size; i++) {
+		for (node = ht->buckets[i]; node; node = next) {
+			next = node->next;
+			node->next = buckets[node->hval & (n - 1)];
+			buckets[node->hval & (n - 1)] = node;
+		}
+	}
+	free(ht->buckets);
+	ht->buckets = buckets;
+	ht->size = n;
+}
+
+int smc_hash_add(struct smc_hash *ht, const void *key, size_t klen, void *data)
+{
+	struct smc_hash_node *node;
+	unsigned int idx;
+
+	node = malloc(sizeof(*node));
+	if (!node)
+		return -1;
+	if (ht->count >= ht->size)
+		smc_hash_grow(ht);
+	node->key = key;
+	node->klen = klen;
+	node->data = data;
+	node->hval = smc_hash_key(key, klen);
+	idx = node->hval & (ht->size - 1);
+	node->next = ht->buckets[idx];
+	ht->buckets[idx] = node;
+	ht->count++;
+	return 0;
+}
+
+void *smc_hash_find(struct smc_hash *ht, const void *key, size_t klen)
+{
+	struct smc_hash_node *node;
+	uint32_t hval;
+
+	if (!ht->buckets)
+		return NULL;
+	hval = smc_hash_key(key, klen);
+	for (node = ht->buckets[hval & (ht->size - 1)]; node; node = node->next) {
+		if (node->hval == hval && node->klen == klen &&
+		    memcmp(node->key, key, klen) == 0)
+			return node->data;
+	}
+	return NULL;
+}
+
+void smc_hash_free(struct smc_hash *ht)
+{
+	struct smc_hash_node *node, *next;
+	unsigned int i;
+
+	for (i = 0; i < ht->size; i++) {
+		for (node = ht->buckets[i]; node; node = next) {
+			next = node->next;
+			free(node);
+		}
+	}
+	free(ht->buckets);
+	ht->buckets = NULL;
+	ht->size = 0;
+	ht->count = 0;
+}
+
+/* Copy the name of interface ifindex to name (IF_NAMESIZE bytes), return
+ * NULL if there is no such interface
+ */
+char *smc_ifname(unsigned int ifindex, char *name)
+{
+	unsigned int slot = ifindex % SMC_IFNAME_CACHE_SIZE;
+	char buf[IF_NAMESIZE];
+
+	if (!ifindex)
+		return NULL;
+	if (ifname_cache[slot].ifindex != ifindex) {
+		if (!if_indextoname(ifindex, buf))
+			return NULL;
+		memcpy(ifname_cache[slot].name, buf, IF_NAMESIZE);
+		ifname_cache[slot].ifindex = ifindex;
+	}
+	return memcpy(name, ifname_cache[slot].name, IF_NAMESIZE);
+}
+
+/* Forget all cached names, e.g. before the next poll of a long running
+ * command, interfaces may have been renamed or removed since
+ */
+void smc_ifname_flush(void)
+{
+	memset(ifname_cache, 0, sizeof(ifname_cache));
+}
@@ -27,11 +27,32 @@
 #define NEXT_ARG_OK() (argc - 1 > 0)
 #define PREV_ARG() do { argv--; argc++; } while(0)
 
+/* Chained hash table, keys are owned by the caller and must stay valid */
+struct smc_hash_node {
+	struct smc_hash_node	*next;
+	const void		*key;
+	size_t			klen;
+	uint32_t		hval;
+	void			*data;
+};
+
+struct smc_hash {
+	struct smc_hash_node	**buckets;
+	unsigned int		size;	/* number of buckets, power of 2 */
+	unsigned int		count;
+};
+
 void print_unsup_msg(void);
 void print_type_error(void);
 char* trim_space(char *str);
 int get_abbreviated(uint64_t num, int max_digs, char *res);
 int contains(const char *prfx, const char *str);
+int smc_hash_init(struct smc_hash *ht, unsigned int size);
+int smc_hash_add(struct smc_hash *ht, const void *key, size_t klen, void *data);
+void *smc_hash_find(struct smc_hash *ht, const void *key, size_t klen);
+void smc_hash_free(struct smc_hash *ht);
+char *smc_ifname(unsigned int ifindex, char *name);
+void smc_ifname_flush(void);
 
 static inline int is_str_empty(char *str)
 {